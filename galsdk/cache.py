@@ -0,0 +1,247 @@
+from __future__ import annotations
+
+import hashlib
+import json
+import mmap
+import os
+import shutil
+import struct
+from pathlib import Path
+from typing import TYPE_CHECKING, Callable, Iterable
+
+from PIL import Image
+
+if TYPE_CHECKING:
+    from panda3d.core import NodePath, Texture
+
+
+INDEX_NAME = 'index.json'
+DEFAULT_MAX_SIZE = 1024 * 1024 * 1024
+IMAGE_HEADER_FORMAT = '<4s2H'
+IMAGE_HEADER_SIZE = struct.calcsize(IMAGE_HEADER_FORMAT)
+
+
+class AssetCache:
+    """
+    Persistent cache of game assets that have been converted for display in the editor
+
+    Decoding models and TIMs from the game's formats and turning them into Panda3D objects is slow enough to make
+    switching between rooms and camera angles lag, and has to be redone every time the editor is opened. The cache keeps
+    the converted data on disk, keyed by a hash of the source files' contents plus the name and version of the
+    conversion, so it's reused whenever the same data is converted again, even after the source files have been moved
+    or renamed. Bump the version passed to get when a conversion changes to invalidate what it previously cached.
+
+    To avoid rehashing unchanged source files, the cache keeps an index of the hash of each file along with its mtime
+    and size, and only rehashes a file whose mtime or size doesn't match, the same way export identifies files that have
+    changed.
+
+    Entries are touched whenever they're used, and when adding an entry would take the cache over its maximum size, the
+    least recently used entries are deleted to make room.
+    """
+
+    def __init__(self, cache_dir: Path, max_size: int = DEFAULT_MAX_SIZE):
+        """
+        :param cache_dir: Directory to store the cache in. It will be created if it doesn't exist.
+        :param max_size: Maximum total size of the cached assets in bytes
+        """
+        self.cache_dir = cache_dir
+        self.max_size = max_size
+        self.index_path = cache_dir / INDEX_NAME
+        self.index: dict[str, tuple[float, int, str]] = {}
+        self.index_changed = False
+        try:
+            with self.index_path.open() as f:
+                self.index = {path: tuple(entry) for path, entry in json.load(f).items()}
+        except (OSError, ValueError):
+            # a missing or corrupt index just means everything gets rehashed
+            pass
+
+    def _save_index(self):
+        if not self.index_changed:
+            return
+        self.index_changed = False
+        self.cache_dir.mkdir(parents=True, exist_ok=True)
+        temp_path = self.index_path.with_suffix('.tmp')
+        with temp_path.open('w') as f:
+            json.dump(self.index, f)
+        os.replace(temp_path, self.index_path)
+
+    def hash_file(self, path: Path) -> str:
+        """
+        Get the hash of a file's contents, using the hash in the index if the file hasn't changed since it was hashed
+
+        :param path: Path to the file
+        :return: Hex digest of the file's contents
+        """
+        stat = path.stat()
+        key = str(path.resolve())
+        if (entry := self.index.get(key)) is not None:
+            mtime, size, digest = entry
+            if mtime == stat.st_mtime and size == stat.st_size:
+                return digest
+
+        digest = hashlib.sha1(path.read_bytes()).hexdigest()
+        self.index[key] = (stat.st_mtime, stat.st_size, digest)
+        self.index_changed = True
+        return digest
+
+    def entry_path(self, sources: Iterable[Path], kind: str, version: int, params: str = '') -> Path:
+        """
+        Get the path in the cache where a converted asset is stored
+
+        :param sources: Files the asset was converted from
+        :param kind: Name of the conversion, which is also the directory in the cache the asset is stored in
+        :param version: Version of the conversion
+        :param params: Any other inputs to the conversion that affect its output
+        :return: Path to the cache entry, which may not exist
+        """
+        key = hashlib.sha1(f'{kind}:{version}:{params}'.encode())
+        for source in sources:
+            key.update(bytes.fromhex(self.hash_file(source)))
+        return self.cache_dir / kind / key.hexdigest()
+
+    def get_path(self, sources: Iterable[Path], kind: str, version: int, convert: Callable[[], bytes],
+                 params: str = '') -> Path:
+        """
+        Get the path to a converted asset in the cache, converting and caching it if necessary
+
+        :param sources: Files the asset is converted from
+        :param kind: Name of the conversion
+        :param version: Version of the conversion
+        :param convert: Function that performs the conversion if the asset isn't cached
+        :param params: Any other inputs to the conversion that affect its output
+        :return: Path to the cache entry
+        """
+        path = self.entry_path(sources, kind, version, params)
+        self._save_index()
+        if path.exists():
+            try:
+                # the mtime records when the entry was last used, for prune
+                os.utime(path)
+            except OSError:
+                pass
+        else:
+            data = convert()
+            self.prune(self.max_size - len(data))
+            path.parent.mkdir(parents=True, exist_ok=True)
+            # write to a temporary file first so an interrupted write doesn't leave a truncated entry behind
+            temp_path = path.with_suffix('.tmp')
+            temp_path.write_bytes(data)
+            os.replace(temp_path, path)
+        return path
+
+    def get(self, sources: Iterable[Path], kind: str, version: int, convert: Callable[[], bytes],
+            params: str = '') -> memoryview:
+        """
+        Get a converted asset from the cache, converting and caching it if necessary
+
+        :param sources: Files the asset is converted from
+        :param kind: Name of the conversion
+        :param version: Version of the conversion
+        :param convert: Function that performs the conversion if the asset isn't cached
+        :param params: Any other inputs to the conversion that affect its output
+        :return: Memory-mapped view of the converted data
+        """
+        path = self.get_path(sources, kind, version, convert, params)
+        with path.open('rb') as f:
+            if path.stat().st_size == 0:
+                return memoryview(b'')
+            # the mapping stays open for as long as the view is referenced
+            return memoryview(mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ))
+
+    def get_image(self, sources: Iterable[Path], kind: str, version: int, convert: Callable[[], Image.Image],
+                  params: str = '') -> Image.Image:
+        """Get a converted image from the cache. The image's pixels are read directly from the memory-mapped entry."""
+        def convert_image() -> bytes:
+            image = convert()
+            if image.mode not in ('RGB', 'RGBA'):
+                image = image.convert('RGBA')
+            return struct.pack(IMAGE_HEADER_FORMAT, image.mode.encode().ljust(4), image.width,
+                               image.height) + image.tobytes()
+
+        data = self.get(sources, kind, version, convert_image, params)
+        raw_mode, width, height = struct.unpack_from(IMAGE_HEADER_FORMAT, data)
+        mode = raw_mode.decode().strip()
+        # the image shares the mapped buffer, so PIL makes a copy if anything modifies it
+        return Image.frombuffer(mode, (width, height), data[IMAGE_HEADER_SIZE:], 'raw', mode, 0, 1)
+
+    def get_panda3d_model(self, sources: Iterable[Path], kind: str, version: int, convert: Callable[[], NodePath],
+                          params: str = '') -> NodePath:
+        """Get a converted model from the cache. The model is stored as a BAM stream, Panda3D's native format."""
+        from panda3d.core import NodePath
+
+        # Panda3D copies its input into its own buffer anyway, so the entry is read rather than mapped
+        path = self.get_path(sources, kind, version, lambda: bytes(convert().encodeToBamStream()), params)
+        return NodePath.decodeFromBamStream(path.read_bytes())
+
+    def get_panda3d_texture(self, sources: Iterable[Path], kind: str, version: int, convert: Callable[[], Texture],
+                            params: str = '') -> Texture:
+        """Get a converted texture from the cache. The texture is stored in Panda3D's TXO format."""
+        from panda3d.core import StringStream, Texture
+
+        def convert_texture() -> bytes:
+            stream = StringStream()
+            convert().writeTxo(stream)
+            return stream.getData()
+
+        path = self.get_path(sources, kind, version, convert_texture, params)
+        texture = Texture()
+        texture.readTxo(StringStream(path.read_bytes()))
+        return texture
+
+    def prune(self, max_size: int = None):
+        """
+        Delete the least recently used entries until the cache is no bigger than a given size
+
+        :param max_size: Size in bytes to shrink the cache to. Defaults to the cache's maximum size.
+        """
+        if max_size is None:
+            max_size = self.max_size
+        entries = []
+        total_size = 0
+        for path in self.cache_dir.glob('*/*'):
+            if path.suffix == '.tmp':
+                continue
+            stat = path.stat()
+            entries.append((stat.st_mtime, stat.st_size, path))
+            total_size += stat.st_size
+
+        entries.sort()
+        for _, size, path in entries:
+            if total_size <= max_size:
+                break
+            try:
+                path.unlink()
+            except OSError:
+                # on Windows, an entry can't be deleted while it's still mapped
+                continue
+            total_size -= size
+
+    def clear(self):
+        """Delete everything in the cache"""
+        self.index = {}
+        self.index_changed = False
+        if self.cache_dir.exists():
+            shutil.rmtree(self.cache_dir)
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Manage a project's cache of assets converted for the editor")
+    subparsers = parser.add_subparsers()
+
+    clear_parser = subparsers.add_parser('clear', help='Delete everything in the cache')
+    clear_parser.add_argument('project', help='Path to the project directory', type=Path)
+    clear_parser.set_defaults(action=lambda a: AssetCache(a.project / 'cache').clear())
+
+    prune_parser = subparsers.add_parser('prune', help='Delete the least recently used assets until the cache is no '
+                                         'bigger than a given size')
+    default_size_mb = DEFAULT_MAX_SIZE // (1024 * 1024)
+    prune_parser.add_argument('-s', '--size', help=f'Size to shrink the cache to in MB. Defaults to {default_size_mb}.',
+                              type=int, default=default_size_mb)
+    prune_parser.add_argument('project', help='Path to the project directory', type=Path)
+    prune_parser.set_defaults(action=lambda a: AssetCache(a.project / 'cache').prune(a.size * 1024 * 1024))
+
+    args = parser.parse_args()
+    args.action(args)
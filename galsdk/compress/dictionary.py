@@ -21,17 +21,26 @@
 # https://github.com/gdkchan/GalTTT. I considered replacing this implementation with a new one based on that code, but
 # I think it's kind of a wash. While that code is faster, even after these latest optimizations, this code seems to have
 # the edge in compression efficiency in the majority (but not all) of the cases I tested.
+# Update 2026-10-14: The LCP array is now built with Kasai's algorithm and the byte map only marks each string's
+# occurrences once, which fixes the quadratic behavior on long runs of the same byte (a chunk of mostly zeros went from
+# ~15 seconds to well under one). The output is unchanged. Chunks are independent, so compress_many can also compress
+# them in parallel, and `python -m galsdk.compress.dictionary benchmark` reports ratio and timing for a set of files.
 
 import functools
-import math
 import io
+import math
+import os
+import sys
 
-from collections.abc import Container
+from collections.abc import Container, Iterable
+from concurrent.futures import ProcessPoolExecutor
 from galsdk import file
 
 
 CHUNK_SIZE = 5000  # this is accurate to how the game's original compression worked
 MAX_ITERATIONS = 10000
+# starting a process pool takes longer than compressing a few chunks, so fewer chunks than this are compressed serially
+MIN_PARALLEL_CHUNKS = 8
 
 
 class DictionaryCompressor:
@@ -57,16 +66,7 @@ class DictionaryCompressor:
         if data_len == 0:
             return b''
 
-        for i in range(data_len - 1):
-            next_index = i + 1
-            a = self.data[self.suffixes[next_index]:]
-            b = self.data[self.suffixes[i]:]
-            for j, (ac, bc) in enumerate(zip(a, b)):
-                if ac != bc:
-                    self.lcp[next_index] = j
-                    break
-            else:
-                self.lcp[next_index] = min(len(a), len(b))
+        self.build_lcp()
 
         # we set a limit on the maximum length of strings because it's too computationally expensive to break them down
         # for the dictionary
@@ -121,6 +121,34 @@ class DictionaryCompressor:
 
         return raw_dictionary + len(compressed).to_bytes(2, 'big') + compressed
 
+    def build_lcp(self):
+        """
+        Fill in the LCP array from the suffix array
+
+        This is Kasai's algorithm. Each entry is the length of the prefix a suffix has in common with the suffix before
+        it in the suffix array. Walking the suffixes in text order means the common prefix of one pair is at most one
+        byte shorter than the next, so we never compare the same bytes twice and long runs of repeated bytes (which are
+        common in TIMs) don't make this quadratic.
+        """
+        data = self.data
+        data_len = len(data)
+        rank = [0] * data_len
+        for i, suffix in enumerate(self.suffixes):
+            rank[suffix] = i
+
+        common = 0
+        for i in range(data_len):
+            suffix_rank = rank[i]
+            if suffix_rank == 0:
+                common = 0
+                continue
+            j = self.suffixes[suffix_rank - 1]
+            while i + common < data_len and j + common < data_len and data[i + common] == data[j + common]:
+                common += 1
+            self.lcp[suffix_rank] = common
+            if common > 0:
+                common -= 1
+
     @staticmethod
     def start_span(count: int, start: int, entries: list[tuple[int, int, int]]) -> int:
         last_index = start
@@ -387,9 +415,10 @@ class DictionaryCompressor:
         data_len = len(self.data)
         chosen_strings = {ss for s in byte_map for ss in s}
         strings_to_remove = set()
+        unused_bytes = set(range(256)) - set(self.data)
         while True:
             num_chosen_strings = len(chosen_strings)
-            superstrings = {s for s in chosen_strings if all(s not in ss or s == ss for ss in chosen_strings)}
+            superstrings = self.find_superstrings(chosen_strings, unused_bytes)
             usage_counts = {}
             i = 0
             while i < data_len:
@@ -422,6 +451,17 @@ class DictionaryCompressor:
 
         return usage_counts
 
+    @staticmethod
+    def find_superstrings(strings: set[bytes], unused_bytes: set[int]) -> set[bytes]:
+        """Find the strings in a set which aren't part of any other string in the set"""
+        if not unused_bytes:
+            return {s for s in strings if all(s not in ss or s == ss for ss in strings)}
+
+        # join everything with a byte that can't be part of any of the strings. then, a string is part of another string
+        # exactly when it can be found somewhere other than its own spot in the joined strings.
+        joined = bytes([min(unused_bytes)]).join(strings)
+        return {s for s in strings if joined.find(s) == joined.rfind(s)}
+
     def choose_strings(self, byte_map: list[set[bytes]], start: int = 0, end: int = None,
                        candidate: bytes = None) -> int:
         map_len = len(byte_map)
@@ -475,10 +515,16 @@ class DictionaryCompressor:
 
     def create_byte_map(self) -> list[set[bytes]]:
         byte_options = [set() for _ in range(len(self.data))]
+        # many suffixes share the same string, so rather than marking the bytes of each occurrence as we find it, we
+        # collect the starting offsets of each string's occurrences and mark the bytes at the end, covering each byte
+        # only once per string
+        occurrences: dict[bytes, set[int]] = {}
+        searched: dict[bytes, set[int]] = {}
         for i, p in enumerate(self.lcp):
             if p > 1:
                 index = self.suffixes[i]
-                end = index + p
+                # nothing longer than MAX_STRING_LEN is ever a substring, so don't bother checking those lengths
+                end = index + min(p, self.MAX_STRING_LEN)
                 string = self.data[index:end]
                 # the full prefix might have been removed from the list of substrings, so see if there's a smaller
                 # prefix that still works
@@ -489,12 +535,14 @@ class DictionaryCompressor:
                 if str_len < 2:
                     continue
 
-                end = index + str_len
-                while index != -1:
-                    for j in range(index, end):
-                        byte_options[j].add(string)
-                    index = self.data.find(string, end)
-                    end = index + str_len
+                string_occurrences = occurrences.setdefault(string, set())
+                string_searched = searched.setdefault(string, set())
+                while index != -1 and index not in string_searched:
+                    # once we reach an occurrence we've searched from before, the rest of the sequence is the same as
+                    # it was that time
+                    string_searched.add(index)
+                    string_occurrences.add(index)
+                    index = self.data.find(string, index + str_len)
 
                 # because of the way the LCP array works, if the string before us was the first string in the sequence
                 # of strings that start with this prefix, it could have missed it because it didn't have enough in
@@ -504,10 +552,16 @@ class DictionaryCompressor:
                     last_p = self.lcp[last_i]
                     if last_p < str_len:
                         index = self.suffixes[last_i]
-                        end = index + str_len
-                        assert self.data[index:end] == string
-                        for j in range(index, end):
-                            byte_options[j].add(string)
+                        assert self.data[index:index + str_len] == string
+                        string_occurrences.add(index)
+
+        for string, string_occurrences in occurrences.items():
+            str_len = len(string)
+            covered = 0
+            for index in sorted(string_occurrences):
+                for j in range(max(index, covered), index + str_len):
+                    byte_options[j].add(string)
+                covered = index + str_len
 
         return byte_options
 
@@ -522,10 +576,13 @@ class DictionaryCompressor:
             while i < data_len:
                 p = self.lcp[i]
                 index = self.suffixes[i]
-                string = self.data[index:index + p]
-                if p > 1 and string in self.substrings:
+                # strings longer than MAX_STRING_LEN are never substrings, so we can skip them without slicing
+                string = self.data[index:index + p] if 1 < p <= self.MAX_STRING_LEN else None
+                if string is not None and string in self.substrings:
                     for j in range(i + 1, data_len):
                         p2 = self.lcp[j]
+                        if p2 > self.MAX_STRING_LEN:
+                            continue  # too long to be a substring, so we aren't a substring of it
                         if p2 != p:
                             index = self.suffixes[j]
                             next_string = self.data[index:index + p2]
@@ -555,19 +612,63 @@ class DictionaryCompressor:
                 break
 
 
-def compress(data: bytes) -> bytes:
-    final_data = bytearray()
-    for i in range(0, len(data), CHUNK_SIZE):
-        compressor = DictionaryCompressor(data[i:i + CHUNK_SIZE])
-        chunk_data = compressor.compress()
-        final_data.extend(chunk_data)
+def compress_chunk(data: bytes) -> bytes:
+    """
+    Compress a single chunk of at most CHUNK_SIZE bytes
 
-    final_data_len = len(final_data)
-    padding_needed = (4 - final_data_len & 3) & 3
-    if padding_needed > 0:
-        final_data += b'0' * padding_needed
+    :param data: The data to compress
+    :return: The compressed chunk, without the length header that compress adds
+    """
+    return DictionaryCompressor(data).compress()
 
-    return final_data_len.to_bytes(4, 'little') + final_data
+
+def compress(data: bytes, max_workers: int | None = 1) -> bytes:
+    """
+    Compress data with the game's dictionary compression
+
+    :param data: The data to compress
+    :param max_workers: Number of processes to compress chunks of the data in. The default of 1 compresses everything
+        in this process. None uses one process per CPU.
+    :return: The compressed data
+    """
+    return compress_many([data], max_workers)[0]
+
+
+def compress_many(items: Iterable[bytes], max_workers: int | None = None) -> list[bytes]:
+    """
+    Compress several independent pieces of data with the game's dictionary compression
+
+    Every CHUNK_SIZE-byte chunk of each item gets its own dictionary, so all the chunks of all the items are compressed
+    in parallel. If there are fewer than MIN_PARALLEL_CHUNKS chunks, they're compressed in this process regardless.
+
+    :param items: The pieces of data to compress
+    :param max_workers: Maximum number of processes to compress chunks in. None uses one process per CPU, and 1
+        compresses everything in this process.
+    :return: The compressed data for each item, in the same order
+    """
+    items = list(items)
+    chunks = [item[i:i + CHUNK_SIZE] for item in items for i in range(0, len(item), CHUNK_SIZE)]
+    if max_workers == 1 or len(chunks) < MIN_PARALLEL_CHUNKS:
+        compressed_chunks = [compress_chunk(chunk) for chunk in chunks]
+    else:
+        with ProcessPoolExecutor(max_workers) as executor:
+            compressed_chunks = list(executor.map(compress_chunk, chunks))
+
+    results = []
+    chunk_iter = iter(compressed_chunks)
+    for item in items:
+        final_data = bytearray()
+        for _ in range(0, len(item), CHUNK_SIZE):
+            final_data.extend(next(chunk_iter))
+
+        final_data_len = len(final_data)
+        padding_needed = (4 - final_data_len & 3) & 3
+        if padding_needed > 0:
+            final_data += b'0' * padding_needed
+
+        results.append(final_data_len.to_bytes(4, 'little') + final_data)
+
+    return results
 
 
 def decompress(data: bytes) -> list[tuple[int, bytes]]:
@@ -640,3 +741,91 @@ def decompress(data: bytes) -> list[tuple[int, bytes]]:
                     raise ValueError('Expected padding bytes')
 
     return results
+
+
+def load_reference(revision: str):
+    """
+    Load the version of this module from an earlier git revision, to compare against
+
+    :param revision: Git revision to load the module from
+    :return: The module
+    """
+    import subprocess
+    import types
+
+    source = subprocess.run(['git', 'show', f'{revision}:galsdk/compress/dictionary.py'], capture_output=True,
+                            check=True, cwd=os.path.dirname(os.path.abspath(__file__))).stdout
+    module = types.ModuleType(f'{__name__}_{revision}')
+    exec(compile(source, f'{revision}:galsdk/compress/dictionary.py', 'exec'), module.__dict__)
+    return module
+
+
+def benchmark(paths: Iterable[str], max_workers: int | None, reference: str | None = None):
+    import time
+
+    reference_module = load_reference(reference) if reference else None
+    total_size = total_compressed_size = 0
+    total_reference = total_serial = total_parallel = 0.
+    reference_header = f' {"ref":>8} {"speedup":>7}' if reference_module else ''
+    print(f'{"file":<32} {"size":>9} {"packed":>9} {"ratio":>6}{reference_header} {"serial":>8} {"parallel":>8}')
+    for path in paths:
+        with open(path, 'rb') as f:
+            data = f.read()
+
+        reference_column = ''
+        if reference_module:
+            start = time.perf_counter()
+            reference_compressed = reference_module.compress(data)
+            reference_time = time.perf_counter() - start
+            total_reference += reference_time
+        start = time.perf_counter()
+        compressed = compress(data)
+        serial_time = time.perf_counter() - start
+        start = time.perf_counter()
+        parallel_compressed = compress(data, max_workers)
+        parallel_time = time.perf_counter() - start
+
+        if parallel_compressed != compressed:
+            raise AssertionError(f'{path}: parallel compression produced different output')
+        if b''.join(chunk for _, chunk in decompress(compressed)) != data:
+            raise AssertionError(f'{path}: compressed data did not decompress to the original')
+        if reference_module:
+            if reference_compressed != compressed:
+                print(f'{path}: output differs from {reference}', file=sys.stderr)
+            speedup = reference_time / serial_time if serial_time > 0 else float('inf')
+            reference_column = f' {reference_time:>7.2f}s {speedup:>6.1f}x'
+
+        ratio = len(compressed) / len(data) if data else 1.
+        print(f'{os.path.basename(path):<32} {len(data):>9} {len(compressed):>9} {ratio:>6.1%}{reference_column} '
+              f'{serial_time:>7.2f}s {parallel_time:>7.2f}s')
+        total_size += len(data)
+        total_compressed_size += len(compressed)
+        total_serial += serial_time
+        total_parallel += parallel_time
+
+    ratio = total_compressed_size / total_size if total_size else 1.
+    reference_column = ''
+    if reference_module:
+        speedup = total_reference / total_serial if total_serial > 0 else float('inf')
+        reference_column = f' {total_reference:>7.2f}s {speedup:>6.1f}x'
+    print(f'{"total":<32} {total_size:>9} {total_compressed_size:>9} {ratio:>6.1%}{reference_column} '
+          f'{total_serial:>7.2f}s {total_parallel:>7.2f}s')
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(description='Tools for the dictionary compression used for some Galerians TIMs')
+    subparsers = parser.add_subparsers()
+
+    benchmark_parser = subparsers.add_parser('benchmark', help='Measure compression ratio and time for files, '
+                                             'compressing in this process and in parallel')
+    benchmark_parser.add_argument('-j', '--jobs', type=int, help='Number of processes for the parallel run. '
+                                  'Defaults to the number of CPUs.')
+    benchmark_parser.add_argument('-r', '--reference', help='Git revision of an earlier version of the compressor to '
+                                  'also time, and check the output against')
+    benchmark_parser.add_argument('files', nargs='+', help='Files to compress')
+    benchmark_parser.set_defaults(action=lambda a: benchmark(a.files, a.jobs, a.reference))
+
+    args = parser.parse_args()
+    args.action(args)
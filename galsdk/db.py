@@ -1,4 +1,6 @@
+import io
 import math
+import mmap
 import os
 import os.path
 from pathlib import Path
@@ -16,6 +18,10 @@ class Database(Archive[bytes]):
     into a single CDB file. There are two variants - an "extended" form that records file sizes with byte precision,
     and a non-extended form that records file sizes with sector precision. The non-extended form will pad files with
     null bytes to the nearest sector boundary.
+
+    A database read lazily (see read) memory-maps the file and only parses the directory up front. Entries are then
+    memoryview slices of the mapping, so nothing is copied until an entry is replaced or the database is written. Close
+    a lazy database (or use it as a context manager) to release the mapping.
     """
     SECTOR_SIZE = 0x800
 
@@ -28,7 +34,20 @@ class Database(Archive[bytes]):
         """
         super().__init__()
         self.extended = extended
-        self.files = []
+        self.files: list[bytes | memoryview] = []
+        self._map: mmap.mmap | None = None
+        self._view: memoryview | None = None
+
+    def __enter__(self) -> Self:
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+    @property
+    def is_lazy(self) -> bool:
+        """Whether any entries in this database are still views of a memory-mapped file"""
+        return self._map is not None
 
     @property
     def suggested_extension(self) -> str:
@@ -66,19 +85,14 @@ class Database(Archive[bytes]):
         return path
 
     @classmethod
-    def read(cls, f: BinaryIO, **kwargs) -> Self:
-        """
-        Read a database file from a given path
-
-        :param f: Binary data stream to read the database file from
-        """
+    def _read_directory(cls, f: BinaryIO) -> tuple[bool, list[tuple[int, int]]]:
         num_entries = util.int_from_bytes(f.read(2))
         extended = util.int_from_bytes(f.read(2)) != 0
-        db = cls(extended)
         if extended:
             # skip over 4 dummy bytes
             f.seek(4, 1)
         directory = f.read((8 if extended else 4)*num_entries)
+        entries = []
         i = 0
         while i < len(directory):
             start_sector = util.int_from_bytes(directory[i:i+2])
@@ -89,18 +103,102 @@ class Database(Archive[bytes]):
             else:
                 final_sector_len = cls.SECTOR_SIZE
                 i += 4
-            f.seek(start_sector*cls.SECTOR_SIZE)
             size = (num_sectors - 1)*cls.SECTOR_SIZE + final_sector_len
+            entries.append((start_sector*cls.SECTOR_SIZE, size))
+        return extended, entries
+
+    @classmethod
+    def read(cls, f: BinaryIO, *, lazy: bool = False, **kwargs) -> Self:
+        """
+        Read a database file from a given path
+
+        :param f: Binary data stream to read the database file from
+        :param lazy: If True and f is a file on disk, memory-map the file and only read the directory. The mapping stays
+            valid after f is closed. Otherwise, or if the file can't be mapped, every entry is read into memory.
+        """
+        if lazy:
+            try:
+                data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+            except (io.UnsupportedOperation, ValueError, OSError):
+                # not a real file (or an empty one), so read it the normal way
+                pass
+            else:
+                return cls._read_mapped(data)
+
+        extended, entries = cls._read_directory(f)
+        db = cls(extended)
+        for start, size in entries:
+            f.seek(start)
             db.append(util.read_some(f, size))
+        return db
 
+    @classmethod
+    def _read_mapped(cls, data: mmap.mmap) -> Self:
+        view = memoryview(data)
+        db = None
+        try:
+            extended, entries = cls._read_directory(data)
+            db = cls(extended)
+            for start, size in entries:
+                if start >= len(view) and size != 0:
+                    raise EOFError(f'EOF encountered when attempting to read {size} bytes')
+                db.files.append(view[start:start + size])
+        except Exception:
+            if db is not None:
+                for entry in db.files:
+                    entry.release()
+            view.release()
+            data.close()
+            raise
+        db._map = data
+        db._view = view
         return db
 
+    def materialize(self):
+        """Copy any entries that are still views of a memory-mapped file into memory and release the mapping"""
+        if self._map is None:
+            return
+
+        for i, data in enumerate(self.files):
+            if isinstance(data, memoryview):
+                self.files[i] = data.tobytes()
+                data.release()
+        self._release_map()
+
+    def close(self):
+        """
+        Release the memory mapping of a lazy database
+
+        Entries that were still views of the mapping can't be used afterward, so call materialize first to keep using the
+        database. If views returned by __getitem__ are still alive, the mapping will stay open until they're released.
+        """
+        if self._map is None:
+            return
+
+        for data in self.files:
+            if isinstance(data, memoryview):
+                data.release()
+        self._release_map()
+
+    def _release_map(self):
+        self._view.release()
+        try:
+            self._map.close()
+        except BufferError:
+            # a caller still holds a view of the mapping; it'll be closed when the last one is garbage-collected
+            pass
+        self._map = None
+        self._view = None
+
     def write(self, f: BinaryIO, **kwargs):
         """
         Write the files in this database to a single packed database file
 
+        If the database is lazy, its entries are copied into memory first, since f may be the file they're mapped from.
+
         :param f: Binary data stream to write the database file to
         """
+        self.materialize()
         f.write(len(self.files).to_bytes(2, 'little'))
         if self.extended:
             f.write(b'\x01\0\0\0\0\0')
@@ -132,12 +230,16 @@ class Database(Archive[bytes]):
             if bytes_over > 0:
                 f.write(b'\0' * (self.SECTOR_SIZE - bytes_over))
 
-    def __iter__(self) -> Iterable[bytes]:
+    def __iter__(self) -> Iterable[bytes | memoryview]:
         """Iterate over the files in the database"""
         yield from self.files
 
-    def __getitem__(self, item: int) -> bytes:
-        """Get the contents of the file in the database at the given index"""
+    def __getitem__(self, item: int) -> bytes | memoryview:
+        """
+        Get the contents of the file in the database at the given index
+
+        For a lazy database, this is a read-only view of the memory-mapped file unless the entry has been replaced.
+        """
         return self.files[item]
 
     def __setitem__(self, key: int, value: bytes):
@@ -193,13 +295,14 @@ def pack(extended: bool, files: Iterable[Path], cdb: Path):
 
 def unpack(cdb: str, target: str, indexes: Container[int] = None):
     with open(cdb, 'rb') as f:
-        db = Database.read(f)
-    for i, data in enumerate(db):
-        if indexes and i not in indexes:
-            continue
-        output_path = os.path.join(target, f'{i:03}')
-        with open(output_path, 'wb') as f:
-            f.write(data)
+        db = Database.read(f, lazy=True)
+    with db:
+        for i, data in enumerate(db):
+            if indexes and i not in indexes:
+                continue
+            output_path = os.path.join(target, f'{i:03}')
+            with open(output_path, 'wb') as f:
+                f.write(data)
 
 
 if __name__ == '__main__':
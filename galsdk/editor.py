@@ -110,6 +110,8 @@ class Editor(ShowBase):
 
         self.create_project_button = ttk.Button(self.new_project_view, text='Create Project',
                                                 command=self.create_project)
+        self.create_progress_var = tk.StringVar()
+        create_progress = ttk.Label(self.new_project_view, textvariable=self.create_progress_var, anchor=tk.W)
 
         self.new_project_view.grid_rowconfigure(0, weight=1)
         self.new_project_view.grid_rowconfigure(7, weight=1)
@@ -131,6 +133,7 @@ class Editor(ShowBase):
         project_path.grid(padx=5, row=6, column=1, columnspan=3, sticky=tk.E+tk.W)
         browse_project_path.grid(padx=5, row=6, column=4, sticky=tk.W)
         self.create_project_button.grid(row=7, column=0, sticky=tk.N+tk.E)
+        create_progress.grid(padx=5, row=7, column=1, columnspan=4, sticky=tk.N+tk.W)
 
         rows, cols = self.new_project_view.grid_size()
         for i in range(rows):
@@ -240,11 +243,18 @@ class Editor(ShowBase):
         image_path = self.image_path_var.get()
         project_path = self.project_path_var.get()
         Manifest.revert_all_unsaved_changes()
+
+        def show_progress(message: str, done: int, total: int):
+            self.create_progress_var.set(f'{message} ({done}/{total})')
+            self.tkRoot.update_idletasks()
+
         try:
-            project = Project.create_from_cd(image_path, project_path)
+            project = Project.create_from_cd(image_path, project_path, progress=show_progress)
         except Exception as e:
             tkmsg.showerror('Failed to create project', str(e))
             return
+        finally:
+            self.create_progress_var.set('')
 
         self.open_project(project)
 
@@ -0,0 +1,508 @@
+from __future__ import annotations
+
+import struct
+from typing import Callable
+
+
+class EmulationError(Exception):
+    """The emulated code did something the emulator can't handle, like an exception or an unsupported instruction"""
+
+    def __init__(self, message: str, pc: int):
+        super().__init__(f'{message} at {pc:08X}')
+        self.pc = pc
+
+
+class StopExecution(Exception):
+    """Raised by a hook to stop Cpu.run, e.g. when emulated code yields to the next frame"""
+
+
+class Memory:
+    """
+    The PlayStation's main RAM and scratchpad
+
+    Addresses are translated the way the CPU does it, so KUSEG, KSEG0, and KSEG1 addresses all refer to the same RAM,
+    and the 2MB of RAM is mirrored through the first 8MB. Accesses to anything else (I/O ports, BIOS) read as 0 and
+    writes are ignored, since room code has no business touching hardware directly.
+    """
+
+    RAM_SIZE = 0x200000
+    RAM_MIRROR_END = 0x800000
+    SCRATCHPAD_START = 0x1F800000
+    SCRATCHPAD_SIZE = 0x400
+
+    def __init__(self):
+        self.ram = bytearray(self.RAM_SIZE)
+        self.scratchpad = bytearray(self.SCRATCHPAD_SIZE)
+
+    def _translate(self, address: int, size: int) -> tuple[bytearray | None, int]:
+        physical = address & 0x1FFFFFFF
+        if physical < self.RAM_MIRROR_END:
+            offset = physical & (self.RAM_SIZE - 1)
+            if offset + size <= self.RAM_SIZE:
+                return self.ram, offset
+        elif self.SCRATCHPAD_START <= physical < self.SCRATCHPAD_START + self.SCRATCHPAD_SIZE:
+            offset = physical - self.SCRATCHPAD_START
+            if offset + size <= self.SCRATCHPAD_SIZE:
+                return self.scratchpad, offset
+        return None, 0
+
+    def read8(self, address: int) -> int:
+        buf, offset = self._translate(address, 1)
+        return buf[offset] if buf is not None else 0
+
+    def read16(self, address: int) -> int:
+        buf, offset = self._translate(address, 2)
+        return buf[offset] | (buf[offset + 1] << 8) if buf is not None else 0
+
+    def read32(self, address: int) -> int:
+        buf, offset = self._translate(address, 4)
+        return struct.unpack_from('<I', buf, offset)[0] if buf is not None else 0
+
+    def write8(self, address: int, value: int):
+        buf, offset = self._translate(address, 1)
+        if buf is not None:
+            buf[offset] = value & 0xFF
+
+    def write16(self, address: int, value: int):
+        buf, offset = self._translate(address, 2)
+        if buf is not None:
+            struct.pack_into('<H', buf, offset, value & 0xFFFF)
+
+    def write32(self, address: int, value: int):
+        buf, offset = self._translate(address, 4)
+        if buf is not None:
+            struct.pack_into('<I', buf, offset, value & 0xFFFFFFFF)
+
+    def read(self, address: int, size: int) -> bytes:
+        """
+        Read a block of memory
+
+        :param address: Address to read from
+        :param size: Number of bytes to read
+        :return: The bytes at the address. Bytes outside RAM and the scratchpad read as 0.
+        """
+        buf, offset = self._translate(address, size)
+        if buf is not None:
+            return bytes(buf[offset:offset + size])
+        return bytes(self.read8(address + i) for i in range(size))
+
+    def write(self, address: int, data: bytes):
+        """
+        Write a block of memory
+
+        :param address: Address to write to
+        :param data: Bytes to write
+        """
+        buf, offset = self._translate(address, len(data))
+        if buf is not None:
+            buf[offset:offset + len(data)] = data
+        else:
+            for i, b in enumerate(data):
+                self.write8(address + i, b)
+
+
+def _signed16(value: int) -> int:
+    return value - 0x10000 if value & 0x8000 else value
+
+
+def _signed32(value: int) -> int:
+    return value - 0x100000000 if value & 0x80000000 else value
+
+
+class Cpu:
+    """
+    An interpreter for the PlayStation's R3000A CPU
+
+    This is meant for measuring how much work code does, not for running the game, so it takes some shortcuts:
+
+    * Loads take effect immediately instead of after the load delay slot. gcc doesn't rely on the old value being
+      visible in the delay slot, so compiled code behaves the same either way.
+    * There's no exception handling. Anything that would raise an exception on the real CPU (overflow, address errors,
+      syscall, break) raises EmulationError instead.
+    * GTE (COP2) registers can be read and written, but GTE commands don't calculate anything; they only add their
+      documented cycle counts. Code whose results depend on the GTE should be built with GALERIANS_NO_GTE.
+
+    The cycle count is an estimate: one cycle per instruction, plus the documented extra time for multiplication,
+    division, and GTE commands, plus a cycle for each memory access. It's accurate enough to compare two builds of the
+    same code, but it will be lower than the real hardware, which also waits on the instruction cache and the bus.
+    """
+
+    RA = 31
+    SP = 29
+    A0 = 4
+    V0 = 2
+
+    DIV_CYCLES = 36
+    MEMORY_ACCESS_CYCLES = 1
+    DEFAULT_GTE_CYCLES = 8
+    # cycles for GTE commands by function number
+    GTE_CYCLES = {
+        0x01: 15,  # RTPS
+        0x06: 8,   # NCLIP
+        0x0C: 6,   # OP
+        0x10: 8,   # DPCS
+        0x11: 8,   # INTPL
+        0x12: 8,   # MVMVA
+        0x13: 19,  # NCDS
+        0x14: 13,  # CDP
+        0x16: 44,  # NCDT
+        0x1B: 17,  # NCCS
+        0x1C: 11,  # CC
+        0x1E: 14,  # NCS
+        0x20: 30,  # NCT
+        0x28: 5,   # SQR
+        0x29: 8,   # DCPL
+        0x2A: 17,  # DPCT
+        0x2D: 5,   # AVSZ3
+        0x2E: 6,   # AVSZ4
+        0x30: 23,  # RTPT
+        0x3D: 5,   # GPF
+        0x3E: 5,   # GPL
+        0x3F: 39,  # NCCT
+    }
+
+    def __init__(self, memory: Memory = None):
+        self.memory = memory or Memory()
+        self.regs = [0] * 32
+        self.hi = 0
+        self.lo = 0
+        self.pc = 0
+        self.next_pc = 4
+        self.cop0 = [0] * 32
+        self.cop2_data = [0] * 32
+        self.cop2_control = [0] * 32
+        self.instructions = 0
+        self.cycles = 0
+        self.gte_commands = 0
+        # functions to call instead of executing the code at an address. the hook is responsible for setting pc (e.g.
+        # to ra, to return from a stubbed function).
+        self.hooks: dict[int, Callable[[Cpu], None]] = {}
+        # called when pc is outside the executable range and there's no hook for it
+        self.missing_hook: Callable[[Cpu], None] | None = None
+        self.executable = range(0, 0)
+
+    def jump(self, address: int):
+        """Continue execution at an address, with no delay slot"""
+        self.pc = address & 0xFFFFFFFF
+        self.next_pc = (address + 4) & 0xFFFFFFFF
+
+    def return_from_call(self, value: int = None):
+        """
+        Finish a stubbed function call by returning to ra
+
+        :param value: If not None, the value to return in v0
+        """
+        if value is not None:
+            self.regs[self.V0] = value & 0xFFFFFFFF
+        self.jump(self.regs[self.RA])
+
+    def get_arg(self, index: int) -> int:
+        """
+        Get one of the first four arguments of a function call
+
+        :param index: Index of the argument, from 0 to 3
+        :return: The argument's value as an unsigned 32-bit integer
+        """
+        return self.regs[self.A0 + index]
+
+    def _set(self, reg: int, value: int):
+        if reg != 0:
+            self.regs[reg] = value & 0xFFFFFFFF
+
+    def run(self, stop_address: int, max_instructions: int) -> bool:
+        """
+        Run until pc reaches an address or a hook stops execution
+
+        :param stop_address: Run until pc reaches this address
+        :param max_instructions: Raise EmulationError if more than this many instructions are executed, since the code
+            is probably stuck
+        :return: True if pc reached stop_address, or False if a hook raised StopExecution
+        """
+        limit = self.instructions + max_instructions
+        try:
+            while self.pc != stop_address:
+                if self.instructions >= limit:
+                    raise EmulationError(f'Exceeded {max_instructions} instructions', self.pc)
+                self.step()
+        except StopExecution:
+            return False
+        return True
+
+    def step(self):
+        """Execute one instruction, or call the hook for the current address"""
+        pc = self.pc
+        if (hook := self.hooks.get(pc)) is not None:
+            hook(self)
+            return
+        if pc not in self.executable:
+            if self.missing_hook is None:
+                raise EmulationError('Jumped outside of executable memory', pc)
+            self.missing_hook(self)
+            return
+        if pc & 3:
+            raise EmulationError('Misaligned instruction address', pc)
+
+        inst = self.memory.read32(pc)
+        self.pc = self.next_pc
+        self.next_pc = (self.next_pc + 4) & 0xFFFFFFFF
+        self.instructions += 1
+        self.cycles += 1
+
+        op = inst >> 26
+        rs = (inst >> 21) & 0x1F
+        rt = (inst >> 16) & 0x1F
+        regs = self.regs
+        if op == 0:
+            self._special(inst, pc, rs, rt)
+        elif op == 1:
+            value = _signed32(regs[rs])
+            if rt & 0x10:
+                # bltzal/bgezal always link, even if the branch isn't taken
+                self._set(self.RA, pc + 8)
+            if (value >= 0) == bool(rt & 1):
+                self.next_pc = (pc + 4 + (_signed16(inst & 0xFFFF) << 2)) & 0xFFFFFFFF
+        elif op == 2:
+            self.next_pc = (self.pc & 0xF0000000) | ((inst & 0x3FFFFFF) << 2)
+        elif op == 3:
+            self._set(self.RA, pc + 8)
+            self.next_pc = (self.pc & 0xF0000000) | ((inst & 0x3FFFFFF) << 2)
+        elif op < 8:
+            a = _signed32(regs[rs])
+            b = _signed32(regs[rt])
+            if op == 4:
+                taken = a == b
+            elif op == 5:
+                taken = a != b
+            elif op == 6:
+                taken = a <= 0
+            else:
+                taken = a > 0
+            if taken:
+                self.next_pc = (pc + 4 + (_signed16(inst & 0xFFFF) << 2)) & 0xFFFFFFFF
+        elif op < 16:
+            self._immediate(inst, pc, op, rs, rt)
+        elif op == 16:
+            self._cop0(inst, pc, rs, rt)
+        elif op == 18:
+            self._cop2(inst, pc, rs, rt)
+        elif op >= 32:
+            self._memory(inst, pc, op, rs, rt)
+        else:
+            raise EmulationError(f'Unsupported instruction {inst:08X}', pc)
+
+    def _special(self, inst: int, pc: int, rs: int, rt: int):
+        regs = self.regs
+        rd = (inst >> 11) & 0x1F
+        shamt = (inst >> 6) & 0x1F
+        funct = inst & 0x3F
+        match funct:
+            case 0x00:  # sll
+                self._set(rd, regs[rt] << shamt)
+            case 0x02:  # srl
+                self._set(rd, regs[rt] >> shamt)
+            case 0x03:  # sra
+                self._set(rd, _signed32(regs[rt]) >> shamt)
+            case 0x04:  # sllv
+                self._set(rd, regs[rt] << (regs[rs] & 0x1F))
+            case 0x06:  # srlv
+                self._set(rd, regs[rt] >> (regs[rs] & 0x1F))
+            case 0x07:  # srav
+                self._set(rd, _signed32(regs[rt]) >> (regs[rs] & 0x1F))
+            case 0x08:  # jr
+                self.next_pc = regs[rs]
+            case 0x09:  # jalr
+                target = regs[rs]
+                self._set(rd, pc + 8)
+                self.next_pc = target
+            case 0x0C:
+                raise EmulationError('syscall', pc)
+            case 0x0D:
+                raise EmulationError('break', pc)
+            case 0x10:  # mfhi
+                self._set(rd, self.hi)
+            case 0x11:  # mthi
+                self.hi = regs[rs]
+            case 0x12:  # mflo
+                self._set(rd, self.lo)
+            case 0x13:  # mtlo
+                self.lo = regs[rs]
+            case 0x18 | 0x19:  # mult, multu
+                if funct == 0x18:
+                    a = _signed32(regs[rs])
+                    b = _signed32(regs[rt])
+                else:
+                    a = regs[rs]
+                    b = regs[rt]
+                result = (a * b) & 0xFFFFFFFFFFFFFFFF
+                self.lo = result & 0xFFFFFFFF
+                self.hi = result >> 32
+                # the multiplier finishes early for small values of rs
+                magnitude = abs(a) if funct == 0x18 else a
+                if magnitude < 0x800:
+                    self.cycles += 5
+                elif magnitude < 0x100000:
+                    self.cycles += 8
+                else:
+                    self.cycles += 12
+            case 0x1A:  # div
+                a = _signed32(regs[rs])
+                b = _signed32(regs[rt])
+                if b == 0:
+                    # the hardware doesn't trap; these are the values it produces
+                    self.lo = 1 if a < 0 else 0xFFFFFFFF
+                    self.hi = a & 0xFFFFFFFF
+                else:
+                    quotient = abs(a) // abs(b)
+                    if (a < 0) != (b < 0):
+                        quotient = -quotient
+                    self.lo = quotient & 0xFFFFFFFF
+                    self.hi = (a - quotient * b) & 0xFFFFFFFF
+                self.cycles += self.DIV_CYCLES - 1
+            case 0x1B:  # divu
+                a = regs[rs]
+                b = regs[rt]
+                if b == 0:
+                    self.lo = 0xFFFFFFFF
+                    self.hi = a
+                else:
+                    self.lo = a // b
+                    self.hi = a % b
+                self.cycles += self.DIV_CYCLES - 1
+            case 0x20:  # add
+                result = _signed32(regs[rs]) + _signed32(regs[rt])
+                if not -0x80000000 <= result <= 0x7FFFFFFF:
+                    raise EmulationError('Integer overflow', pc)
+                self._set(rd, result)
+            case 0x21:  # addu
+                self._set(rd, regs[rs] + regs[rt])
+            case 0x22:  # sub
+                result = _signed32(regs[rs]) - _signed32(regs[rt])
+                if not -0x80000000 <= result <= 0x7FFFFFFF:
+                    raise EmulationError('Integer overflow', pc)
+                self._set(rd, result)
+            case 0x23:  # subu
+                self._set(rd, regs[rs] - regs[rt])
+            case 0x24:  # and
+                self._set(rd, regs[rs] & regs[rt])
+            case 0x25:  # or
+                self._set(rd, regs[rs] | regs[rt])
+            case 0x26:  # xor
+                self._set(rd, regs[rs] ^ regs[rt])
+            case 0x27:  # nor
+                self._set(rd, ~(regs[rs] | regs[rt]))
+            case 0x2A:  # slt
+                self._set(rd, int(_signed32(regs[rs]) < _signed32(regs[rt])))
+            case 0x2B:  # sltu
+                self._set(rd, int(regs[rs] < regs[rt]))
+            case _:
+                raise EmulationError(f'Unsupported instruction {inst:08X}', pc)
+
+    def _immediate(self, inst: int, pc: int, op: int, rs: int, rt: int):
+        regs = self.regs
+        imm = inst & 0xFFFF
+        simm = _signed16(imm)
+        match op:
+            case 8:  # addi
+                result = _signed32(regs[rs]) + simm
+                if not -0x80000000 <= result <= 0x7FFFFFFF:
+                    raise EmulationError('Integer overflow', pc)
+                self._set(rt, result)
+            case 9:  # addiu
+                self._set(rt, regs[rs] + simm)
+            case 10:  # slti
+                self._set(rt, int(_signed32(regs[rs]) < simm))
+            case 11:  # sltiu
+                self._set(rt, int(regs[rs] < (simm & 0xFFFFFFFF)))
+            case 12:  # andi
+                self._set(rt, regs[rs] & imm)
+            case 13:  # ori
+                self._set(rt, regs[rs] | imm)
+            case 14:  # xori
+                self._set(rt, regs[rs] ^ imm)
+            case 15:  # lui
+                self._set(rt, imm << 16)
+
+    def _cop0(self, inst: int, pc: int, rs: int, rt: int):
+        rd = (inst >> 11) & 0x1F
+        if rs == 0:  # mfc0
+            self._set(rt, self.cop0[rd])
+        elif rs == 4:  # mtc0
+            self.cop0[rd] = self.regs[rt]
+        else:
+            raise EmulationError(f'Unsupported COP0 instruction {inst:08X}', pc)
+
+    def _cop2(self, inst: int, pc: int, rs: int, rt: int):
+        rd = (inst >> 11) & 0x1F
+        if rs & 0x10:
+            self.gte_commands += 1
+            self.cycles += self.GTE_CYCLES.get(inst & 0x3F, self.DEFAULT_GTE_CYCLES) - 1
+        elif rs == 0:  # mfc2
+            self._set(rt, self.cop2_data[rd])
+        elif rs == 2:  # cfc2
+            self._set(rt, self.cop2_control[rd])
+        elif rs == 4:  # mtc2
+            self.cop2_data[rd] = self.regs[rt]
+        elif rs == 6:  # ctc2
+            self.cop2_control[rd] = self.regs[rt]
+        else:
+            raise EmulationError(f'Unsupported COP2 instruction {inst:08X}', pc)
+
+    def _memory(self, inst: int, pc: int, op: int, rs: int, rt: int):
+        regs = self.regs
+        memory = self.memory
+        address = (regs[rs] + _signed16(inst & 0xFFFF)) & 0xFFFFFFFF
+        self.cycles += self.MEMORY_ACCESS_CYCLES
+        match op:
+            case 32:  # lb
+                value = memory.read8(address)
+                self._set(rt, value - 0x100 if value & 0x80 else value)
+            case 33:  # lh
+                self._check_alignment(address, 2, pc)
+                self._set(rt, _signed16(memory.read16(address)))
+            case 34:  # lwl
+                shift = (address & 3) * 8
+                word = memory.read32(address & ~3)
+                self._set(rt, (regs[rt] & (0x00FFFFFF >> shift)) | (word << (24 - shift)))
+            case 35:  # lw
+                self._check_alignment(address, 4, pc)
+                self._set(rt, memory.read32(address))
+            case 36:  # lbu
+                self._set(rt, memory.read8(address))
+            case 37:  # lhu
+                self._check_alignment(address, 2, pc)
+                self._set(rt, memory.read16(address))
+            case 38:  # lwr
+                shift = (address & 3) * 8
+                word = memory.read32(address & ~3)
+                self._set(rt, (regs[rt] & ((0xFFFFFF00 << (24 - shift)) & 0xFFFFFFFF)) | (word >> shift))
+            case 40:  # sb
+                memory.write8(address, regs[rt])
+            case 41:  # sh
+                self._check_alignment(address, 2, pc)
+                memory.write16(address, regs[rt])
+            case 42:  # swl
+                shift = (address & 3) * 8
+                aligned = address & ~3
+                word = memory.read32(aligned)
+                memory.write32(aligned, (word & ((0xFFFFFF00 << shift) & 0xFFFFFFFF)) | (regs[rt] >> (24 - shift)))
+            case 43:  # sw
+                self._check_alignment(address, 4, pc)
+                memory.write32(address, regs[rt])
+            case 46:  # swr
+                shift = (address & 3) * 8
+                aligned = address & ~3
+                word = memory.read32(aligned)
+                memory.write32(aligned, (word & (0x00FFFFFF >> (24 - shift))) | (regs[rt] << shift))
+            case 50:  # lwc2
+                self._check_alignment(address, 4, pc)
+                self.cop2_data[rt] = memory.read32(address)
+            case 58:  # swc2
+                self._check_alignment(address, 4, pc)
+                memory.write32(address, self.cop2_data[rt])
+            case _:
+                raise EmulationError(f'Unsupported instruction {inst:08X}', pc)
+
+    @staticmethod
+    def _check_alignment(address: int, size: int, pc: int):
+        if address & (size - 1):
+            raise EmulationError(f'Misaligned {size}-byte access to {address:08X}', pc)
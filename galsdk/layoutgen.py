@@ -0,0 +1,262 @@
+from __future__ import annotations
+
+from dataclasses import astuple
+from pathlib import Path
+from typing import Iterable
+
+from galsdk.game import Stage
+from galsdk.module import (ActorLayout, CircleCollider, ColliderType, RectangleCollider, RoomLayout, RoomModule,
+                           TriangleCollider)
+
+
+COLLIDER_TYPE_NAMES = {
+    ColliderType.WALL: 'COLLIDER_WALL',
+    ColliderType.RECTANGLE: 'COLLIDER_RECT',
+    ColliderType.TRIANGLE: 'COLLIDER_TRI',
+    ColliderType.CIRCLE: 'COLLIDER_CIRCLE',
+}
+
+
+class LayoutGenerator:
+    """
+    Generate C source for a room's layout and actor layouts
+
+    The output is a header meant to be included by a single room source file. The room layout is emitted as a
+    CompactRoomLayout (see sdk/include/galerians/layout.h) containing only the entries the room actually uses, and
+    identical collider shapes are stored once and shared between colliders.
+    """
+
+    def __init__(self, prefix: str = 'room', dedupe: bool = True):
+        """
+        :param prefix: Prefix for the names of the generated variables
+        :param dedupe: Whether colliders with identical shapes should share a single shape entry. Disable this if the
+            room modifies its collider shapes at runtime.
+        """
+        self.prefix = prefix
+        self.dedupe = dedupe
+
+    def name(self, suffix: str) -> str:
+        return f'{self.prefix}{suffix}'
+
+    @staticmethod
+    def format_array(c_type: str, name: str, entries: Iterable[str], qualifiers: str = 'static') -> list[str]:
+        lines = [f'{qualifiers} {c_type} {name}[] = {{']
+        lines.extend(f'    {entry},' for entry in entries)
+        lines.append('};')
+        return lines
+
+    @staticmethod
+    def format_fields(fields: dict[str, int | str]) -> str:
+        return '{ ' + ', '.join(f'.{key} = {value}' for key, value in fields.items()) + ' }'
+
+    def shape_pointer(self, kind: str, shape_lists: dict[str, list]) -> str:
+        return self.name(kind) if shape_lists[kind] else 'NULL'
+
+    def generate_layout(self, layout: RoomLayout) -> list[str]:
+        shape_lists: dict[str, list[RectangleCollider | TriangleCollider | CircleCollider]] = {
+            'Rects': [], 'Tris': [], 'Circles': [],
+        }
+        shape_indexes: dict[str, dict[tuple, int]] = {key: {} for key in shape_lists}
+        sources = {
+            'Rects': iter(layout.rectangle_colliders),
+            'Tris': iter(layout.triangle_colliders),
+            'Circles': iter(layout.circle_colliders),
+        }
+
+        colliders = []
+        for collider in layout.colliders:
+            match collider.type:
+                case ColliderType.TRIANGLE:
+                    kind = 'Tris'
+                case ColliderType.CIRCLE:
+                    kind = 'Circles'
+                case _:
+                    # walls use rectangle shapes
+                    kind = 'Rects'
+            shape = next(sources[kind])
+            key = astuple(shape)
+            if self.dedupe and key in shape_indexes[kind]:
+                index = shape_indexes[kind][key]
+            else:
+                index = len(shape_lists[kind])
+                shape_lists[kind].append(shape)
+                shape_indexes[kind][key] = index
+            fields = {
+                'type': COLLIDER_TYPE_NAMES.get(collider.type, str(int(collider.type))),
+                'shape': f'&{self.name(kind)}[{index}]',
+            }
+            if collider.unknown != 0:
+                fields['unknown08'] = collider.unknown
+            colliders.append(self.format_fields(fields))
+
+        lines = []
+        if shape_lists['Rects']:
+            lines += self.format_array('RectangleCollider', self.name('Rects'), (
+                self.format_fields({'xPos': r.x_pos, 'zPos': r.z_pos, 'xSize': r.x_size, 'zSize': r.z_size,
+                                    'unknown10': r.unknown})
+                for r in shape_lists['Rects']
+            ))
+            lines.append('')
+
+        if shape_lists['Tris']:
+            lines += self.format_array('TriangleCollider', self.name('Tris'), (
+                self.format_fields({'x1': t.x1, 'z1': t.z1, 'x2': t.x2, 'z2': t.z2, 'x3': t.x3, 'z3': t.z3})
+                for t in shape_lists['Tris']
+            ))
+            lines.append('')
+
+        if shape_lists['Circles']:
+            lines += self.format_array('CircleCollider', self.name('Circles'), (
+                self.format_fields({'x': c.x, 'z': c.z, 'radius': c.radius}) for c in shape_lists['Circles']
+            ))
+            lines.append('')
+
+        if colliders:
+            lines += self.format_array('Collider', self.name('Colliders'), colliders)
+            lines.append('')
+
+        if layout.cameras:
+            lines += self.format_array('Camera', self.name('Cameras'), (
+                self.format_fields({
+                    'orientation': c.orientation, 'verticalFov': c.vertical_fov, 'scale': c.scale,
+                    'x': c.x, 'y': c.y, 'z': c.z, 'targetX': c.target_x, 'targetY': c.target_y,
+                    'targetZ': c.target_z, 'unknown12': c.unknown,
+                }) for c in layout.cameras
+            ))
+            lines.append('')
+
+        cuts = [
+            self.format_fields({
+                'marker': 0, 'index': c.index, 'x1': c.x1, 'z1': c.z1, 'x2': c.x2, 'z2': c.z2,
+                'x3': c.x3, 'z3': c.z3, 'x4': c.x4, 'z4': c.z4,
+            }) for c in layout.cuts
+        ]
+        cuts.append('CAMERA_CUT_END')
+        lines += self.format_array('CameraCut', self.name('Cuts'), cuts)
+        lines.append('')
+
+        if layout.interactables:
+            lines += self.format_array('Interactable', self.name('Interactables'), (
+                self.format_fields({'id': i.id, 'xPos': i.x_pos, 'zPos': i.z_pos, 'xSize': i.x_size,
+                                    'zSize': i.z_size})
+                for i in layout.interactables
+            ))
+            lines.append('')
+
+        lines += [
+            f'static CompactRoomLayout {self.name("Layout")} = {{',
+            f'    .numColliders = {len(colliders)},',
+            f'    .numCameras = {len(layout.cameras)},',
+            f'    .numInteractables = {len(layout.interactables)},',
+            '    .flags = COMPACT_LAYOUT_LINKED,',
+            f'    .colliders = {self.name("Colliders") if colliders else "NULL"},',
+            f'    .rectColliders = {self.shape_pointer("Rects", shape_lists)},',
+            f'    .triColliders = {self.shape_pointer("Tris", shape_lists)},',
+            f'    .circleColliders = {self.shape_pointer("Circles", shape_lists)},',
+            f'    .cameras = {self.name("Cameras") if layout.cameras else "NULL"},',
+            f'    .cuts = {self.name("Cuts")},',
+            f'    .interactables = {self.name("Interactables") if layout.interactables else "NULL"},',
+            '};',
+        ]
+        return lines
+
+    def generate_actor_layouts(self, name: str, layouts: list[ActorLayout]) -> list[str]:
+        entries = []
+        for layout in layouts:
+            name_chars = ', '.join(f"'{c}'" for c in layout.name[:5])
+            lines = [
+                '{',
+                f'        .name = {{{name_chars}, 0}},',
+            ]
+            if any(layout.unknown):
+                lines.append(f'        .unknown06 = {{{", ".join(str(b) for b in layout.unknown)}}},')
+            lines.append('        .actors = {')
+            for actor in layout.actors:
+                fields = {'id': actor.id, 'type': actor.type, 'x': actor.x, 'y': actor.y, 'z': actor.z}
+                if actor.unknown1 != 0:
+                    fields['unknown0A'] = actor.unknown1
+                if actor.orientation != 0:
+                    fields['angle'] = actor.orientation
+                if actor.unknown2 != 0:
+                    fields['unknown0E'] = actor.unknown2
+                lines.append(f'            {self.format_fields(fields)},')
+            lines += ['        },', '    }']
+            entries.append('\n'.join(lines))
+        return self.format_array('ActorLayout', name, entries)
+
+    def generate(self, module: RoomModule, source: str = None) -> str:
+        """
+        Generate a header for a room module
+
+        :param module: The room module to generate the header from
+        :param source: Description of where the module came from, for the header comment
+        :return: The contents of the header
+        """
+        lines = [f'// generated by galsdk.layoutgen{f" from {source}" if source else ""}; do not edit', '#pragma once',
+                 '', '#include <stddef.h>', '#include <galerians.h>', '']
+        lines += self.generate_layout(module.layout)
+
+        layout_sets = [layout_set for layout_set in module.actor_layouts if layout_set.layouts]
+        for i, layout_set in enumerate(layout_sets):
+            name = self.name('ActorLayouts') if len(layout_sets) == 1 else self.name(f'ActorLayouts{i}')
+            lines.append('')
+            lines += self.generate_actor_layouts(name, layout_set.layouts)
+
+        return '\n'.join(lines) + '\n'
+
+
+def find_project_room(project_path: str, room_name: str) -> RoomModule:
+    from galsdk.project import Project
+
+    project = Project.open(project_path)
+    for stage in Stage:
+        for room in project.get_stage_rooms(stage):
+            if room.obj.name == room_name:
+                return room.obj
+    raise KeyError(f'No room named {room_name} in project {project_path}')
+
+
+def write_if_changed(path: Path, text: str):
+    """Write a file only if its contents changed, so that make doesn't rebuild modules unnecessarily"""
+    if not path.exists() or path.read_text() != text:
+        path.write_text(text)
+
+
+def generate_header(module: RoomModule, source: str, output: str | None, prefix: str | None, dedupe: bool):
+    if prefix is None:
+        prefix = module.name.lower() if module.name else 'room'
+    text = LayoutGenerator(prefix, dedupe).generate(module, source)
+    if output is None:
+        print(text, end='')
+    else:
+        write_if_changed(Path(output), text)
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(description='Generate C layout tables for a room for use in SDK room modules')
+    parser.add_argument('-o', '--output', help='Path to write the generated header to. If not provided, the header '
+                        'will be written to stdout.')
+    parser.add_argument('-p', '--prefix', help='Prefix for the names of the generated variables. Defaults to the '
+                        'lowercase room name.')
+    parser.add_argument('-n', '--no-dedupe', help="Don't share identical collider shapes between colliders. Use "
+                        'this if the room modifies its collider shapes at runtime.', action='store_true')
+    subparsers = parser.add_subparsers()
+
+    project_parser = subparsers.add_parser('project', help='Generate the layout for a room in a project')
+    project_parser.add_argument('project', help='Path to the project directory')
+    project_parser.add_argument('room', help='Name of the room, e.g. A0101')
+    project_parser.set_defaults(action=lambda a: generate_header(find_project_room(a.project, a.room), a.room,
+                                                                 a.output, a.prefix, not a.no_dedupe))
+
+    module_parser = subparsers.add_parser('module', help='Generate the layout for a room module file. The module '
+                                          'must have a JSON metadata file alongside it.')
+    module_parser.add_argument('-v', '--version', help='The ID of the game version this room module is from')
+    module_parser.add_argument('module', help='Path to the room module')
+    module_parser.set_defaults(action=lambda a: generate_header(
+        RoomModule.load_with_metadata(Path(a.module), a.version), Path(a.module).name, a.output, a.prefix,
+        not a.no_dedupe))
+
+    args = parser.parse_args()
+    args.action(args)
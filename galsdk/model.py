@@ -17,6 +17,7 @@ from PIL import Image
 
 from galsdk import file, graphics
 from galsdk.animation import Animation, AnimationDb
+from galsdk.cache import AssetCache
 from galsdk.coords import Dimension, Point
 from galsdk.format import FileFormat
 from psx.tim import BitsPerPixel, Tim, Transparency
@@ -388,6 +389,9 @@ TEXTURE_WIDTH = 0x100
 TEXTURE_HEIGHT = 0x100
 VERT_SIZE = 3 * 4
 UV_SIZE = 2 * 4
+# bump these when get_panda3d_model or get_panda3d_texture changes to invalidate cached conversions
+PANDA3D_MODEL_VERSION = 1
+PANDA3D_TEXTURE_VERSION = 1
 
 
 class Model(FileFormat):
@@ -402,10 +406,21 @@ class Model(FileFormat):
         self.use_transparency = use_transparency
         self.anim_index = anim_index
         self.animations = None
+        self.asset_cache = None
+        self.source_path = None
 
     def set_animations(self, animations: AnimationDb | None):
         self.animations = animations
 
+    def set_asset_cache(self, asset_cache: AssetCache | None, source_path: Path | None):
+        """Cache the Panda3D model and texture converted from this model, which was read from source_path"""
+        self.asset_cache = asset_cache
+        self.source_path = source_path
+
+    @property
+    def cache_params(self) -> str:
+        return f'{type(self).__name__}:{int(self.use_transparency)}'
+
     @property
     @abstractmethod
     def suggested_extension(self) -> str:
@@ -413,6 +428,12 @@ class Model(FileFormat):
 
     @functools.cache
     def get_panda3d_model(self) -> NodePath:
+        if self.asset_cache is not None:
+            return self.asset_cache.get_panda3d_model([self.source_path], 'panda3d_model', PANDA3D_MODEL_VERSION,
+                                                      self._make_panda3d_model, self.cache_params)
+        return self._make_panda3d_model()
+
+    def _make_panda3d_model(self) -> NodePath:
         vdata = GeomVertexData('', GeomVertexFormat.getV3t2(), Geom.UHStatic)
         vdata.setNumRows(len(self.attributes))
 
@@ -433,6 +454,12 @@ class Model(FileFormat):
 
     @functools.cache
     def get_panda3d_texture(self) -> Texture:
+        if self.asset_cache is not None:
+            return self.asset_cache.get_panda3d_texture([self.source_path], 'panda3d_texture', PANDA3D_TEXTURE_VERSION,
+                                                        self._make_panda3d_texture, self.cache_params)
+        return self._make_panda3d_texture()
+
+    def _make_panda3d_texture(self) -> Texture:
         image = self.get_texture_image()
         buffer = io.BytesIO()
         image.save(buffer, format='png')
@@ -1040,6 +1067,11 @@ class ActorModel(Model):
     def suggested_extension(self) -> str:
         return '.G3A'
 
+    @property
+    def cache_params(self) -> str:
+        # the actor determines the skeleton the segments are arranged in
+        return f'{super().cache_params}:{self.id}'
+
     @classmethod
     def add_segment(cls, root: Segment, segments: list[Segment], skeleton: dict[int, dict]):
         for index, sub_skeleton in skeleton.items():
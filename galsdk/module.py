@@ -1,5 +1,6 @@
 from __future__ import annotations
 
+import io
 import json
 import re
 import struct
@@ -293,6 +294,59 @@ class Interactable:
         return struct.pack('<5h', *astuple(self))
 
 
+@dataclass
+class ModuleHeader:
+    """
+    Header that SDK modules linked with the *_gc.ld linker scripts have after their module ID
+
+    Those modules don't store their zero-initialized data in the file, so the header records how much memory past the
+    end of the file belongs to the module. See sdk/include/galerians/module.h.
+    """
+
+    MAGIC = b'GMOD'
+    OFFSET = 4
+    SIZE = 16
+    VERSION = 1
+
+    file_size: int
+    bss_size: int
+
+    @classmethod
+    def parse(cls, data: bytes) -> ModuleHeader | None:
+        """
+        Parse the module header, if the module has one
+
+        :param data: Contents of the module file, optionally with the zero-initialized data already appended
+        :return: The header, or None if the module doesn't have one
+        """
+        if data[cls.OFFSET:cls.OFFSET + 4] != cls.MAGIC:
+            return None
+        version, size, file_size, bss_size = struct.unpack_from('<2H2I', data, cls.OFFSET + 4)
+        if version != cls.VERSION or size < cls.SIZE:
+            return None
+        # the file size in the header is aligned to the start of .bss, but modules linked before the linker scripts
+        # padded .data can be up to 3 bytes short of it
+        if not 0 <= file_size - len(data) <= 3 and file_size + bss_size != len(data):
+            return None
+        return cls(file_size, bss_size)
+
+    @classmethod
+    def expand(cls, data: bytes) -> bytes:
+        """
+        Get the module's memory image including its zero-initialized data
+
+        :param data: Contents of the module file
+        :return: The module data followed by the zero-initialized data, if it has any
+        """
+        if header := cls.parse(data):
+            # ljust also pads out a file that's short of the aligned file size
+            return data[:header.file_size].ljust(header.file_size + header.bss_size, b'\0')
+        return data
+
+    def encode(self) -> bytes:
+        return self.MAGIC + struct.pack('<2H2I', self.VERSION, self.SIZE, self.file_size, self.bss_size)
+
+
 @dataclass
 class RoomLayout:
     address: int = 0
@@ -535,6 +589,21 @@ class RoomModule(FileFormat):
     def write(self, f: BinaryIO, *, version: str = None, **kwargs):
         self.validate_for_write()
 
+        header = ModuleHeader.parse(self.raw_data)
+        if header is None:
+            self.write_data(f, version)
+            return
+
+        # the zero-initialized data isn't stored in the file, so any changes to it can't be saved
+        buf = io.BytesIO()
+        self.write_data(buf, version)
+        data = buf.getvalue()
+        if any(data[header.file_size:]):
+            raise ValueError('Module data in the zero-initialized region was changed; this module must be rebuilt '
+                             'with the data initialized')
+        f.write(data[:header.file_size])
+
+    def write_data(self, f: BinaryIO, version: str | None):
         f.write(self.raw_data)
 
         f.seek(0)
@@ -745,7 +814,7 @@ class RoomModule(FileFormat):
                                        set(metadata['entrances']), metadata['numEntrances'],
                                        metadata.get('numTriggers'))
 
-        data = path.read_bytes()
+        data = ModuleHeader.expand(path.read_bytes())
         return cls.parse_with_addresses(data, load_address, room_addresses, functions, known_functions, entry_point)
 
     @classmethod
@@ -1387,7 +1456,7 @@ class RoomModule(FileFormat):
 
     @classmethod
     def parse(cls, f: BinaryIO, version: str, entry_point: int) -> RoomModule:
-        data = f.read()
+        data = ModuleHeader.expand(f.read())
         module_id = int.from_bytes(data[:4], 'little')
 
         addresses = ADDRESSES[version]
@@ -1416,13 +1485,15 @@ class RoomModule(FileFormat):
 
     @classmethod
     def load(cls, f: BinaryIO, load_address: int) -> RoomModule:
-        data = f.read()
+        data = ModuleHeader.expand(f.read())
         module_id = int.from_bytes(data[:4], 'little')
 
         # the rest of the module is just a binary blob, so we have to heuristically search for the data structures we're
         # interested in
         # start by recording which addresses are used by other stuff
         used_addresses = [range(4)]
+        if ModuleHeader.parse(data):
+            used_addresses.append(range(ModuleHeader.OFFSET, ModuleHeader.OFFSET + ModuleHeader.SIZE))
 
         # look for the actor layouts, which can be identified by regex
         actor_layouts = []
@@ -0,0 +1,306 @@
+from __future__ import annotations
+
+import struct
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Iterable, Self
+
+
+@dataclass
+class ProfileSample:
+    zone: str
+    frame: int
+    ticks: int
+
+
+@dataclass
+class ZoneStats:
+    zone: str
+    count: int
+    min_ticks: int
+    max_ticks: int
+    total_ticks: int
+    num_frames: int
+
+    @property
+    def avg_ticks(self) -> float:
+        return self.total_ticks / self.count if self.count > 0 else 0.
+
+
+class ProfileBuffer:
+    """
+    Ring buffer of timing samples recorded by the SDK's profile.h
+
+    The buffer lives in a module's data, so it's located by scanning a RAM dump for its signature. The layout must be
+    kept in sync with ProfileBuffer in sdk/include/galerians/profile.h.
+    """
+
+    MAGIC = b'GPRF'
+    VERSION = 1
+    HEADER_SIZE = 0x10
+    SAMPLE_SIZE = 8
+    CYCLES_PER_TICK = 8
+    RAM_BASE = 0x80000000
+    RAM_SIZE = 0x200000
+
+    def __init__(self, address: int, capacity: int, next_index: int, count: int, samples: list[ProfileSample]):
+        self.address = address
+        self.capacity = capacity
+        self.next_index = next_index
+        self.count = count
+        self.samples = samples
+
+    @property
+    def dropped(self) -> int:
+        """The number of samples that were overwritten before the dump was taken"""
+        return max(self.count - self.capacity, 0)
+
+    @classmethod
+    def find_all(cls, ram: bytes, base_address: int = RAM_BASE) -> Iterable[Self]:
+        """
+        Find all profile buffers in a RAM dump
+
+        :param ram: Contents of main RAM
+        :param base_address: Address that the start of the data corresponds to
+        :return: Every profile buffer found in the data. There may be more than one if multiple loaded modules were
+            built with profiling enabled.
+        """
+        offset = ram.find(cls.MAGIC)
+        while offset >= 0:
+            if offset % 4 == 0:
+                try:
+                    yield cls.parse(ram, offset, base_address)
+                except ValueError:
+                    pass
+            offset = ram.find(cls.MAGIC, offset + 1)
+
+    @classmethod
+    def parse(cls, ram: bytes, offset: int, base_address: int = RAM_BASE) -> Self:
+        """
+        Parse a profile buffer at a given offset in a RAM dump
+
+        :param ram: Contents of main RAM
+        :param offset: Offset of the buffer in the data
+        :param base_address: Address that the start of the data corresponds to
+        :return: The parsed profile buffer with samples ordered from oldest to newest
+        """
+        magic, version, capacity, next_index, count = struct.unpack_from('<4s3H2xI', ram, offset)
+        if magic != cls.MAGIC or version != cls.VERSION:
+            raise ValueError('Not a profile buffer')
+        if capacity == 0 or next_index >= capacity or offset + cls.HEADER_SIZE + capacity * cls.SAMPLE_SIZE > len(ram):
+            raise ValueError('Invalid profile buffer header')
+
+        num_samples = min(count, capacity)
+        # once the buffer has wrapped, the oldest sample is the one that will be overwritten next
+        first = next_index if count > capacity else 0
+        samples = []
+        zone_names = {}
+        for i in range(num_samples):
+            sample_offset = offset + cls.HEADER_SIZE + ((first + i) % capacity) * cls.SAMPLE_SIZE
+            zone_ptr, frame, ticks = struct.unpack_from('<I2H', ram, sample_offset)
+            if zone_ptr not in zone_names:
+                zone_names[zone_ptr] = cls.read_zone_name(ram, zone_ptr, base_address)
+            samples.append(ProfileSample(zone_names[zone_ptr], frame, ticks))
+
+        return cls(base_address + offset, capacity, next_index, count, samples)
+
+    @staticmethod
+    def read_zone_name(ram: bytes, address: int, base_address: int) -> str:
+        """Read a zone name string, falling back to the address if it doesn't point to a valid string"""
+        offset = address - base_address
+        if 0 <= offset < len(ram):
+            end = ram.find(b'\0', offset, offset + 256)
+            if end > offset:
+                try:
+                    return ram[offset:end].decode('ascii')
+                except UnicodeDecodeError:
+                    pass
+        return f'<{address:08X}>'
+
+    def summarize(self) -> list[ZoneStats]:
+        """
+        Calculate per-zone statistics
+
+        :return: Statistics for each zone, sorted by the most time spent per sample
+        """
+        stats: dict[str, ZoneStats] = {}
+        frames: dict[str, set[int]] = {}
+        for sample in self.samples:
+            if zone_stats := stats.get(sample.zone):
+                zone_stats.count += 1
+                zone_stats.min_ticks = min(zone_stats.min_ticks, sample.ticks)
+                zone_stats.max_ticks = max(zone_stats.max_ticks, sample.ticks)
+                zone_stats.total_ticks += sample.ticks
+            else:
+                stats[sample.zone] = ZoneStats(sample.zone, 1, sample.ticks, sample.ticks, sample.ticks, 0)
+                frames[sample.zone] = set()
+            frames[sample.zone].add(sample.frame)
+
+        for zone, zone_stats in stats.items():
+            zone_stats.num_frames = len(frames[zone])
+
+        return sorted(stats.values(), key=lambda s: s.max_ticks, reverse=True)
+
+
+@dataclass
+class AiStateStats:
+    state: int
+    count: int
+    avg_ticks: int
+    max_ticks: int
+    last_frame: int
+
+
+@dataclass
+class AiActorStats:
+    index: int
+    routine: int
+    last_result: int
+    last_ticks: int
+    avg_ticks: int
+    max_ticks: int
+    skipped_frames: int
+    count: int
+    states: list[AiStateStats]
+
+
+class AiBudgetTable:
+    """
+    Per-actor AI routine timings recorded by the SDK's aibudget.h
+
+    Like the profile buffer, the table is located by scanning a RAM dump for its signature. The layout must be kept in
+    sync with AiBudgetTable in sdk/include/galerians/aibudget.h.
+    """
+
+    MAGIC = b'GAIB'
+    VERSION = 1
+    HEADER_SIZE = 0x10
+    ACTOR_HEADER_SIZE = 0x14
+    STATE_SIZE = 0x0C
+
+    def __init__(self, address: int, frame: int, frame_ticks: int, budget_ticks: int, actors: list[AiActorStats]):
+        self.address = address
+        self.frame = frame
+        self.frame_ticks = frame_ticks
+        self.budget_ticks = budget_ticks
+        self.actors = actors
+
+    @classmethod
+    def find_all(cls, ram: bytes, base_address: int = ProfileBuffer.RAM_BASE) -> Iterable[Self]:
+        """
+        Find all AI budget tables in a RAM dump
+
+        :param ram: Contents of main RAM
+        :param base_address: Address that the start of the data corresponds to
+        :return: Every budget table found in the data
+        """
+        offset = ram.find(cls.MAGIC)
+        while offset >= 0:
+            if offset % 4 == 0:
+                try:
+                    yield cls.parse(ram, offset, base_address)
+                except ValueError:
+                    pass
+            offset = ram.find(cls.MAGIC, offset + 1)
+
+    @classmethod
+    def parse(cls, ram: bytes, offset: int, base_address: int = ProfileBuffer.RAM_BASE) -> Self:
+        """
+        Parse an AI budget table at a given offset in a RAM dump
+
+        :param ram: Contents of main RAM
+        :param offset: Offset of the table in the data
+        :param base_address: Address that the start of the data corresponds to
+        :return: The parsed table. Actors that aren't being timed are left out.
+        """
+        magic, version, num_actors, num_states, frame, frame_ticks, budget_ticks = struct.unpack_from(
+            '<4sH2B3H2x', ram, offset)
+        if magic != cls.MAGIC or version != cls.VERSION:
+            raise ValueError('Not an AI budget table')
+        actor_size = cls.ACTOR_HEADER_SIZE + num_states * cls.STATE_SIZE
+        if num_actors == 0 or num_states == 0 or offset + cls.HEADER_SIZE + num_actors * actor_size > len(ram):
+            raise ValueError('Invalid AI budget table header')
+
+        actors = []
+        for i in range(num_actors):
+            actor_offset = offset + cls.HEADER_SIZE + i * actor_size
+            routine, last_result, last_ticks, avg_ticks, max_ticks, skipped, _, count = struct.unpack_from(
+                '<Ii6H', ram, actor_offset)
+            if routine == 0:
+                continue
+            states = []
+            for j in range(num_states):
+                state = AiStateStats(*struct.unpack_from('<5H2x', ram,
+                                                         actor_offset + cls.ACTOR_HEADER_SIZE + j * cls.STATE_SIZE))
+                if state.count > 0:
+                    states.append(state)
+            states.sort(key=lambda s: s.state)
+            actors.append(AiActorStats(i, routine, last_result, last_ticks, avg_ticks, max_ticks, skipped, count,
+                                       states))
+
+        return cls(base_address + offset, frame, frame_ticks, budget_ticks, actors)
+
+
+def report(dump_path: str, base_address: int, offset: int, cycles: bool):
+    ram = Path(dump_path).read_bytes()[offset:offset + ProfileBuffer.RAM_SIZE]
+    buffers = list(ProfileBuffer.find_all(ram, base_address))
+    if not buffers:
+        print(f'No profile buffer found in {dump_path}')
+        return
+
+    scale = ProfileBuffer.CYCLES_PER_TICK if cycles else 1
+    unit = 'cycles' if cycles else 'ticks'
+    for buffer in buffers:
+        print(f'Profile buffer at {buffer.address:08X}: {len(buffer.samples)} samples, {buffer.dropped} dropped')
+        if not buffer.samples:
+            continue
+
+        name_width = max(len('Zone'), *(len(s.zone) for s in buffer.summarize()))
+        print(f'{"Zone":<{name_width}}  {"Count":>6}  {"Frames":>6}  {"Min":>10}  {"Avg":>10}  {"Max":>10}  ({unit})')
+        for stats in buffer.summarize():
+            print(f'{stats.zone:<{name_width}}  {stats.count:>6}  {stats.num_frames:>6}  {stats.min_ticks * scale:>10}  '
+                  f'{stats.avg_ticks * scale:>10.1f}  {stats.max_ticks * scale:>10}')
+
+
+def report_ai(dump_path: str, base_address: int, offset: int, cycles: bool):
+    ram = Path(dump_path).read_bytes()[offset:offset + ProfileBuffer.RAM_SIZE]
+    tables = list(AiBudgetTable.find_all(ram, base_address))
+    if not tables:
+        print(f'No AI budget table found in {dump_path}')
+        return
+
+    scale = ProfileBuffer.CYCLES_PER_TICK if cycles else 1
+    unit = 'cycles' if cycles else 'ticks'
+    for table in tables:
+        budget = f'{table.budget_ticks * scale} {unit}' if table.budget_ticks else 'none'
+        print(f'AI budget table at {table.address:08X}: frame {table.frame}, '
+              f'{table.frame_ticks * scale} {unit} used, budget {budget}')
+        print(f'{"Actor":<5}  {"Routine":<8}  {"State":>5}  {"Count":>6}  {"Avg":>10}  {"Max":>10}  {"Skipped":>7}  '
+              f'({unit})')
+        for actor in table.actors:
+            print(f'{actor.index:<5}  {actor.routine:08X}  {"all":>5}  {actor.count:>6}  '
+                  f'{actor.avg_ticks * scale:>10}  {actor.max_ticks * scale:>10}  {actor.skipped_frames:>7}')
+            for state in actor.states:
+                print(f'{"":<5}  {"":<8}  {state.state:>5}  {state.count:>6}  {state.avg_ticks * scale:>10}  '
+                      f'{state.max_ticks * scale:>10}')
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(description='Report timing samples recorded by modules built with GALERIANS_PROFILE')
+    parser.add_argument('-b', '--base', help='Address in hexadecimal that the start of the RAM data corresponds to',
+                        type=lambda b: int(b, 16), default=ProfileBuffer.RAM_BASE)
+    parser.add_argument('-o', '--offset', help='Offset in the file where main RAM begins. Use this for save states '
+                        'that store RAM after a header.', type=lambda o: int(o, 0), default=0)
+    parser.add_argument('-c', '--cycles', help='Report times in CPU cycles rather than counter ticks',
+                        action='store_true')
+    parser.add_argument('-a', '--ai', help='Report per-actor AI routine timings recorded by aibudget.h instead of '
+                        'profile samples', action='store_true')
+    parser.add_argument('dump', help='Path to a dump of main RAM or an uncompressed save state')
+
+    args = parser.parse_args()
+    if args.ai:
+        report_ai(args.dump, args.base, args.offset, args.cycles)
+    else:
+        report(args.dump, args.base, args.offset, args.cycles)
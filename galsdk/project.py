@@ -8,14 +8,17 @@ import re
 import shutil
 import struct
 import tempfile
+from concurrent.futures import Future, ProcessPoolExecutor
 from dataclasses import asdict, dataclass
 from pathlib import Path, PurePath
-from typing import Iterable
+from typing import Callable, Iterable
 
 from galsdk import file
+from galsdk.cache import AssetCache
 from galsdk.db import Database
 from galsdk.credits import Credits
 from galsdk.font import Font, LatinFont, JapaneseFont
+from galsdk.format import FileFormat
 from galsdk.game import Stage, NUM_MAPS, MAP_NAMES, MODULE_ENTRY_SIZE, STAGE_MAPS, GameVersion, VERSIONS, ADDRESSES
 from galsdk.manifest import FromManifest, Manifest
 from galsdk.menu import ComponentInstance, Menu
@@ -65,6 +68,126 @@ class Map:
         return b''.join(room.to_bytes() for room in self.rooms)
 
 
+# called with a description of the current step, the number of steps completed, and the total number of steps
+ProgressCallback = Callable[[str, int, int], None]
+
+ART_DBS = ['BGTIM_A.CDB', 'BGTIM_B.CDB', 'BGTIM_C.CDB', 'BGTIM_D.CDB', 'CARD.CDB', 'DISPLAY.CDB', 'FONT.CDB',
+           'ITEMTIM.CDB', 'MAIN_TEX.CDB', 'MENU.CDB', 'TIT.CDB']
+ART_SNIFF = (LatinStringDb, XaDatabase, Menu, TimDb, TimFormat, Credits)
+
+
+@dataclass(frozen=True)
+class ArchiveJob:
+    """One of the game's archives that gets unpacked into a manifest when a project is created"""
+
+    file_name: str
+    manifest_dir: str
+    name: str
+    sniff: tuple[type[FileFormat], ...] = ()
+    recursive: bool = True
+
+    def run(self, db_path: Path, project_path: Path):
+        manifest_path = project_path / self.manifest_dir
+        manifest_path.mkdir(parents=True, exist_ok=True)
+        with db_path.open('rb') as f, Database.read(f, lazy=True) as db:
+            Manifest.from_archive(manifest_path, self.name, db, sniff=list(self.sniff) or False,
+                                  recursive=self.recursive, original_path=db_path)
+
+
+# archives that don't depend on anything else in the project, so they can be unpacked in any order. these are most of
+# the work of creating a project.
+ARCHIVE_JOBS = {job.file_name: job for job in [
+    *(ArchiveJob(db_name, f'art/{Path(db_name).stem}', Path(db_name).stem, ART_SNIFF) for db_name in ART_DBS),
+    ArchiveJob('MODEL.CDB', 'models', 'MODEL', (ActorModel, ItemModel)),
+    ArchiveJob('MOT.CDB', 'animations', 'MOT', recursive=False),
+    ArchiveJob('MODULE.BIN', 'modules', 'MODULE'),
+    ArchiveJob('SOUND.CDB', 'sound', 'SOUND', (VabDb,)),
+]}
+
+
+class ArchiveExtractor:
+    """
+    Unpacks the archives in ARCHIVE_JOBS into a new project in a pool of worker processes
+
+    Each archive is handed to the pool as soon as its file is available. When creating a project from a CD image, that's
+    as soon as the file has been extracted from the image, so unpacking overlaps with extracting the rest of the disc.
+    Project creation then collects the results with wait in a fixed order and does any post-processing that depends on
+    them, so the project comes out the same regardless of which archives finish first.
+    """
+
+    def __init__(self, project_path: Path, max_workers: int | None = None, progress: ProgressCallback | None = None):
+        """
+        :param project_path: Path to the project being created
+        :param max_workers: Maximum number of worker processes. None uses one per CPU, and 1 unpacks each archive in
+            this process when it's waited for.
+        :param progress: Function to call each time an archive has been unpacked
+        """
+        self.project_path = project_path
+        self.max_workers = max_workers
+        self.progress = progress
+        self.executor: ProcessPoolExecutor | None = None
+        self.pending: dict[str, tuple[Path, Future | None]] = {}
+        self.completed = 0
+
+    def __enter__(self) -> ArchiveExtractor:
+        self.project_path.mkdir(exist_ok=True)
+        if self.max_workers != 1:
+            self.executor = ProcessPoolExecutor(self.max_workers)
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        if self.executor is not None:
+            # if project creation failed, don't keep unpacking archives nobody is going to use
+            self.executor.shutdown(cancel_futures=exc_type is not None)
+            self.executor = None
+
+    def submit(self, path: Path) -> bool:
+        """
+        Start unpacking a file if it's one of the archives in ARCHIVE_JOBS
+
+        :param path: Path to the extracted file
+        :return: Whether the file will be unpacked
+        """
+        job = ARCHIVE_JOBS.get(path.name)
+        if job is None or path.name in self.pending:
+            return False
+        future = None if self.executor is None else self.executor.submit(job.run, path, self.project_path)
+        self.pending[path.name] = (path, future)
+        return True
+
+    def submit_all(self, game_data: Path):
+        """Start unpacking all the archives in a directory of game files that haven't already been submitted"""
+        paths = [game_data / name for name in ARCHIVE_JOBS if name not in self.pending and (game_data / name).exists()]
+        # start the biggest archives first so a big one doesn't end up running by itself at the end
+        for path in sorted(paths, key=lambda p: p.stat().st_size, reverse=True):
+            self.submit(path)
+
+    def wait(self, file_name: str) -> Manifest | None:
+        """
+        Wait for an archive to finish unpacking
+
+        :param file_name: Name of the archive file, e.g. MODEL.CDB
+        :return: The archive's manifest, or None if the archive wasn't submitted because this version of the game
+            doesn't have it
+        """
+        if file_name not in self.pending:
+            return None
+        path, future = self.pending[file_name]
+        job = ARCHIVE_JOBS[file_name]
+        if future is None:
+            job.run(path, self.project_path)
+        else:
+            future.result()
+        self.completed += 1
+        if self.progress is not None:
+            self.progress(f'Unpacked {file_name}', self.completed, len(self.pending))
+
+        # the manifest was saved by another process, so make sure we don't get a stale copy from the cache
+        manifest = Manifest(self.project_path / job.manifest_dir)
+        manifest.load()
+        return manifest
+
+
 class Project:
     """
     Container for the data and metadata of the game being edited
@@ -91,14 +214,20 @@ class Project:
         self.addresses = ADDRESSES[self.version.id]
 
     @classmethod
-    def _extract_dir(cls, path: str, destination: Path, cd: PsxCd, raw: bool = False, extend: bool = False):
+    def _count_files(cls, path: str, cd: PsxCd) -> int:
+        return sum(cls._count_files(entry.path, cd) if entry.is_directory else 1 for entry in cd.list_dir(path))
+
+    @classmethod
+    def _extract_dir(cls, path: str, destination: Path, cd: PsxCd, raw: bool = False, extend: bool = False,
+                     on_extracted: Callable[[Path], None] = None):
         for entry in cd.list_dir(path):
             if entry.is_directory:
                 sub_path = destination / entry.name
                 sub_path.mkdir(exist_ok=True)
                 # raw extraction if this is the XA directory in the Japanese version or a movie directory in any version
                 is_xa = entry.name == 'XA'
-                cls._extract_dir(entry.path, sub_path, cd, is_xa or entry.name.startswith('MOV'), is_xa)
+                cls._extract_dir(entry.path, sub_path, cd, is_xa or entry.name.startswith('MOV'), is_xa,
+                                 on_extracted)
             else:
                 # remove the CD file version number
                 base_name = entry.name.rsplit(';', 1)[0]
@@ -108,6 +237,8 @@ class Project:
                     # set the extend flag because the filesystem doesn't record the true full size of XA.MXA.
                     is_xa = entry.name == 'XA.MXA;1'
                     cd.extract(entry.path, f, raw or is_xa, extend or is_xa)
+                if on_extracted is not None:
+                    on_extracted(sub_path)
 
     @classmethod
     def _detect_version(cls, system_cnf: str) -> GameVersion:
@@ -132,23 +263,44 @@ class Project:
             return cls._detect_version(buf.getvalue().decode())
 
     @classmethod
-    def create_from_cd(cls, cd_path: str, project_dir: str) -> Project:
+    def create_from_cd(cls, cd_path: str, project_dir: str, max_workers: int | None = None,
+                       progress: ProgressCallback | None = None) -> Project:
         """
         Create a new project from the given CD image in the specified directory
 
         :param cd_path: Path to the CD image to be extracted
         :param project_dir: Path to a directory where the project will be created. The directory will be created if it
             doesn't exist.
+        :param max_workers: Maximum number of processes to unpack the game's archives in. None uses one per CPU, and 1
+            does everything in this process.
+        :param progress: Function to call as each file is extracted from the image and each archive is unpacked
         :return: The new project
         """
         with open(cd_path, 'rb') as f:
             cd = PsxCd(f, ignore_invalid=True)
-        with tempfile.TemporaryDirectory() as d:
-            cls._extract_dir('\\', Path(d), cd)
-            return cls.create_from_directory(d, cd_path, project_dir)
+        num_files = cls._count_files('\\', cd)
+        num_extracted = 0
+
+        extractor = ArchiveExtractor(Path(project_dir), max_workers, progress)
+        with tempfile.TemporaryDirectory() as d, extractor:
+            game_data = Path(d) / 'T4'
+
+            def on_extracted(path: Path):
+                nonlocal num_extracted
+                num_extracted += 1
+                if progress is not None:
+                    progress(f'Extracted {path.relative_to(d)}', num_extracted, num_files)
+                # start unpacking archives while the rest of the disc is extracted
+                if path.parent == game_data:
+                    extractor.submit(path)
+
+            cls._extract_dir('\\', Path(d), cd, on_extracted=on_extracted)
+            return cls.create_from_directory(d, cd_path, project_dir, extractor=extractor)
 
     @classmethod
-    def create_from_directory(cls, game_dir: str, base_image: str, project_dir: str) -> Project:
+    def create_from_directory(cls, game_dir: str, base_image: str, project_dir: str, max_workers: int | None = None,
+                              progress: ProgressCallback | None = None,
+                              extractor: ArchiveExtractor = None) -> Project:
         """
         Create a new project from a directory containing previously extracted game files
 
@@ -159,8 +311,17 @@ class Project:
         :param base_image: Path to a CD image that will be used as a template for saving changes to the game
         :param project_dir: Path to a directory where the project will be created. The directory will be created if it
             doesn't exist.
+        :param max_workers: Maximum number of processes to unpack the game's archives in. None uses one per CPU, and 1
+            does everything in this process.
+        :param progress: Function to call as each archive is unpacked
+        :param extractor: An extractor that archives have already been submitted to, as used by create_from_cd. If
+            provided, max_workers and progress are ignored.
         :return: The new project
         """
+        if extractor is None:
+            with ArchiveExtractor(Path(project_dir), max_workers, progress) as extractor:
+                return cls.create_from_directory(game_dir, base_image, project_dir, extractor=extractor)
+
         project_path = Path(project_dir)
         game_path = Path(game_dir)
 
@@ -185,24 +346,19 @@ class Project:
         shutil.copy(exe_path, boot_dir / exe_path.name)
         shutil.copy(config_path, boot_dir / config_path.name)
 
+        # start unpacking the big archives in the background. we wait for each below where it's needed, in the same
+        # order as if they were unpacked serially.
+        extractor.submit_all(game_data)
+
         art_dir = project_path / 'art'
         art_dir.mkdir(exist_ok=True)
-        art_dbs = ['BGTIM_A.CDB', 'BGTIM_B.CDB', 'BGTIM_C.CDB', 'BGTIM_D.CDB', 'CARD.CDB', 'DISPLAY.CDB', 'FONT.CDB',
-                   'ITEMTIM.CDB', 'MAIN_TEX.CDB', 'MENU.CDB', 'TIT.CDB']
 
-        for art_db_name in art_dbs:
+        for art_db_name in ART_DBS:
             art_db_path = game_data / art_db_name
-            if not art_db_path.exists():  # several of these only exist in the Japanese version
+            art_manifest = extractor.wait(art_db_name)
+            if art_manifest is None:  # several of these only exist in the Japanese version
                 continue
 
-            with art_db_path.open('rb') as f:
-                art_db = Database.read(f)
-            project_art_dir = art_dir / art_db_path.stem
-            project_art_dir.mkdir(exist_ok=True)
-            art_manifest = Manifest.from_archive(project_art_dir, art_db_path.stem, art_db,
-                                                 sniff=[LatinStringDb, XaDatabase, Menu, TimDb, TimFormat, Credits],
-                                                 original_path=art_db_path)
-
             if version.region == Region.NTSC_J and art_db_path.name.startswith('BGTIM_'):
                 # we want every entry in the BGTIM archives to be a manifest, but in the Japanese version, the entries
                 # are TIM streams, and we treat TIM streams with one element as just individual TIMs, which aren't
@@ -306,12 +462,7 @@ class Project:
             with stage_info_path.open('w') as f:
                 json.dump(stage_info, f)
 
-        model_db_path = game_data / 'MODEL.CDB'
-        model_dir = project_path / 'models'
-        model_dir.mkdir(exist_ok=True)
-        with model_db_path.open('rb') as f:
-            model_db = Database.read(f)
-        Manifest.from_archive(model_dir, 'MODEL', model_db, sniff=[ActorModel, ItemModel], original_path=model_db_path)
+        extractor.wait('MODEL.CDB')
         # only actors without a manually-assigned model index are in the list
         actors = ZANMAI_ACTORS if version.is_zanmai else ACTORS
         actors_by_id = {actor.id: actor for actor in actors}
@@ -326,13 +477,8 @@ class Project:
         actor_graphics = [ActorGraphics(model_index, anim_index)
                           for model_index, anim_index in zip(actor_models, actor_animations, strict=True)]
 
-        anim_db_path = game_data / 'MOT.CDB'
-        anim_dir = project_path / 'animations'
-        anim_dir.mkdir(exist_ok=True)
-        with anim_db_path.open('rb') as f:
-            anim_db = Database.read(f)
-        with Manifest.from_archive(anim_dir, 'MOT', anim_db, recursive=False,
-                                   original_path=anim_db_path) as anim_manifest:
+        anim_manifest = extractor.wait('MOT.CDB')
+        with anim_manifest:
             renamed_indexes = set()
             for i, anim_index in enumerate(actor_animations):
                 if anim_index not in renamed_indexes and (actor := actors_by_id.get(i)):
@@ -341,12 +487,7 @@ class Project:
                     renamed_indexes.add(anim_index)
 
         module_dir = project_path / 'modules'
-        module_dir.mkdir(exist_ok=True)
-
-        module_db_path = game_data / 'MODULE.BIN'
-        with module_db_path.open('rb') as f:
-            module_db = Database.read(f)
-        module_manifest = Manifest.from_archive(module_dir, 'MODULE', module_db, original_path=module_db_path)
+        module_manifest = extractor.wait('MODULE.BIN')
 
         maps = cls._get_maps(addresses['MapModules'], exe)
 
@@ -473,12 +614,7 @@ class Project:
         with item_path.open('w') as f:
             json.dump(items, f)
 
-        sound_dir = project_path / 'sound'
-        sound_dir.mkdir(exist_ok=True)
-        sound_db_path = game_data / 'SOUND.CDB'
-        with sound_db_path.open('rb') as f:
-            sound_db = Database.read(f)
-        Manifest.from_archive(sound_dir, 'SOUND', sound_db, sniff=[VabDb], original_path=sound_db_path)
+        extractor.wait('SOUND.CDB')
 
         voice_dir = project_path / 'voice'
         voice_dir.mkdir(exist_ok=True)
@@ -784,7 +920,14 @@ class Project:
 
             model_file = manifest[model_index]
             with model_file.path.open('rb') as f:
-                yield ActorModel.read(f, actor=actor, anim_index=anim_index)
+                model = ActorModel.read(f, actor=actor, anim_index=anim_index)
+            model.set_asset_cache(self.get_asset_cache(), model_file.path)
+            yield model
+
+    @functools.cache
+    def get_asset_cache(self) -> AssetCache:
+        """Get the cache of game assets converted for display in the editor, which is stored in the project directory"""
+        return AssetCache(self.project_dir / 'cache')
 
     @functools.cache
     def get_animations(self) -> Manifest:
@@ -830,6 +973,7 @@ class Project:
                 model_file = model_manifest[entry['model']]
                 with model_file.path.open('rb') as f:
                     model = ItemModel.read(f, name=name, use_transparency=entry['flags'] & 1 == 0)
+                model.set_asset_cache(self.get_asset_cache(), model_file.path)
             else:
                 name = self.version.med_item_names[entry['id']]
                 model = None
@@ -880,6 +1024,11 @@ class Project:
                         if not is_zanmai:
                             raise
 
+        asset_cache = self.get_asset_cache()
+        for models in [actors, items, other]:
+            for i, model in models.items():
+                model.set_asset_cache(asset_cache, model_manifest[i].path)
+
         return actors, items, other
 
     def get_menus(self) -> Iterable[tuple[str, Menu]]:
@@ -1067,12 +1216,11 @@ class Project:
         with base_image.open('rb') as f:
             cd = PsxCd(f)
         cd.patch(patches)
-        # we use this temporary buffer so that, if the write were to fail, we wouldn't have already wiped the output
-        # image
-        with io.BytesIO() as f:
-            cd.write(f)
-            cd_data = f.getvalue()
-        output_image.write_bytes(cd_data)
+        # when exporting over the base image, only the sectors that changed need to be written. otherwise, the image is
+        # written to a temporary file first so that, if the write were to fail, we wouldn't have already wiped the
+        # output image.
+        incremental = output_image.exists() and output_image.samefile(base_image)
+        cd.write_to_path(output_image, incremental)
 
         self.last_export_date = datetime.datetime.now(datetime.UTC)
         self.save()
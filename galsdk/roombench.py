@@ -0,0 +1,446 @@
+from __future__ import annotations
+
+import json
+import re
+import sys
+from dataclasses import asdict, dataclass
+from pathlib import Path
+from typing import Callable, Hashable, Iterable, Self, TextIO
+
+from galsdk.emulator import Cpu, EmulationError, Memory, StopExecution
+from galsdk.game import GameStateOffsets
+from galsdk.sizereport import LinkerMap
+
+
+DEFAULT_SYMBOLS = Path(__file__).parent.parent / 'sdk' / 'ldscripts' / 'na_symbols.ld'
+
+
+def read_symbols(f: TextIO) -> dict[str, int]:
+    """
+    Read symbol definitions from one of the SDK's *_symbols.ld linker scripts
+
+    :param f: Text stream to read the linker script from
+    :return: Addresses of the symbols by name
+    """
+    symbols = {}
+    for line in f:
+        if m := re.match(r'\s*(\w+)\s*=\s*0x([0-9A-Fa-f]+)\s*;', line):
+            symbols[m[1]] = int(m[2], 16)
+    return symbols
+
+
+@dataclass
+class CallbackStats:
+    """
+    Instruction and cycle counts for one callback, accumulated over every time it ran
+
+    A callback that yields runs once per frame until it finishes, and a callback shared by several triggers or actors
+    runs once for each of them per frame, so runs can be more than the number of frames.
+    """
+
+    name: str
+    runs: int = 0
+    instructions: int = 0
+    cycles: int = 0
+    max_instructions: int = 0
+    max_cycles: int = 0
+
+    @property
+    def avg_instructions(self) -> float:
+        return self.instructions / self.runs if self.runs > 0 else 0.
+
+    @property
+    def avg_cycles(self) -> float:
+        return self.cycles / self.runs if self.runs > 0 else 0.
+
+    def add(self, instructions: int, cycles: int):
+        self.runs += 1
+        self.instructions += instructions
+        self.cycles += cycles
+        self.max_instructions = max(self.max_instructions, instructions)
+        self.max_cycles = max(self.max_cycles, cycles)
+
+
+@dataclass
+class Task:
+    """A callback in progress. Callbacks that yield are resumed on the next frame, like game tasks."""
+
+    name: str
+    key: Hashable
+    stack_top: int
+    regs: list[int]
+    pc: int
+    next_pc: int
+    hi: int = 0
+    lo: int = 0
+
+
+class RoomBenchmark:
+    """
+    Runs a room module's code in an emulated R3000 without the game
+
+    The module is loaded at its link address, and the game's functions are replaced by stubs. Most stubs do nothing and
+    return 0; the ones that matter for driving the room (Yield, SetRoomLayout, SetActorAiRoutine, memcpy, etc.) do
+    enough to keep the room's code on its normal path. Game and Actors start out zeroed at their usual addresses.
+
+    Each frame, the benchmark resumes any callbacks that yielded on the previous frame (starting with the room's entry
+    point), then calls each trigger's enabledCallback (and, if requested, its triggerCallback), then calls the AI
+    routine of each actor whose routine is in the module. A trigger or actor whose callback yielded isn't called again
+    until that callback finishes, but other triggers or actors sharing the same callback still are. Instructions and
+    cycles are counted for each callback each time it runs. Time spent in the game's own functions isn't counted, since those are stubbed out.
+    """
+
+    ROOM_ORIGIN = 0x801EC628
+    ROOM_LENGTH = 46904
+    # where callbacks return to when they're done. this is in the BIOS's area of RAM, which modules never execute.
+    RETURN_ADDRESS = 0x80000100
+    # the stacks for callbacks are carved from the top of RAM, above the module region
+    STACK_REGION_TOP = 0x801FFF00
+    STACK_SIZE = 0x1000
+    MAX_TASKS = 6
+    MAX_INSTRUCTIONS = 10_000_000
+
+    NUM_ACTORS = 4
+    ACTOR_SIZE = 0x18C0
+    ACTOR_AI_ROUTINE = 0x187C
+    TRIGGER_SIZE = 0x10
+    TRIGGER_ENABLED_CALLBACK = 0
+    TRIGGER_CALLBACK = 8
+    LAYOUT_NUM_INTERACTABLES = 0x2970
+
+    def __init__(self, module: bytes, game_symbols: dict[str, int], module_symbols: dict[str, int] = None,
+                 origin: int = ROOM_ORIGIN, fire_triggers: bool = False, entry_point: int = None):
+        """
+        Create a benchmark for a room module
+
+        :param module: Contents of the module file
+        :param game_symbols: Addresses of the game's functions and variables by name
+        :param module_symbols: Addresses of the module's functions and variables by name, used to name callbacks
+        :param origin: Address the module was linked at
+        :param fire_triggers: If True, call each trigger's triggerCallback on every frame that its enabledCallback (if
+            any) returns true. Otherwise, only the enabledCallbacks are called.
+        :param entry_point: Address of the room's entry point, if known from the module's metadata
+        """
+        self.memory = Memory()
+        self.cpu = Cpu(self.memory)
+        self.origin = origin
+        self.module_range = range(origin, origin + len(module))
+        self.game_symbols = game_symbols
+        self.module_symbols = module_symbols or {}
+        self.fire_triggers = fire_triggers
+        self.entry_point = entry_point
+        self.stats: dict[str, CallbackStats] = {}
+        self.stub_calls: dict[str, int] = {}
+        self.tasks: list[Task] = []
+        self.free_stacks = [self.STACK_REGION_TOP - i * self.STACK_SIZE for i in range(self.MAX_TASKS)]
+        self.frame = 0
+
+        self._names = {address: name for name, address in game_symbols.items()}
+        self._callback_names = {address: name for name, address in self.module_symbols.items()}
+        self.game = game_symbols['Game']
+        self.actors = game_symbols['Actors']
+
+        self.memory.write(origin, module)
+        self.cpu.executable = self.module_range
+        self.cpu.missing_hook = self._default_stub
+        if 'pGame' in game_symbols:
+            self.memory.write32(game_symbols['pGame'], self.game)
+        for name, stub in self._stubs().items():
+            if name in game_symbols:
+                self.cpu.hooks[game_symbols[name]] = stub
+
+    @classmethod
+    def load(cls, module_path: Path, map_path: Path = None, symbols_path: Path = DEFAULT_SYMBOLS,
+             fire_triggers: bool = False) -> Self:
+        """
+        Load a module built by the SDK
+
+        :param module_path: Path to the module file
+        :param map_path: Path to the module's linker map. If not given, the .map file next to the module is used if
+            there is one.
+        :param symbols_path: Path to the *_symbols.ld file for the game version the module was built for
+        :param fire_triggers: If True, call trigger callbacks as well as enabled callbacks
+        :return: The benchmark
+        """
+        if map_path is None and (candidate := module_path.with_name(module_path.name + '.map')).exists():
+            map_path = candidate
+        with symbols_path.open() as f:
+            game_symbols = read_symbols(f)
+
+        origin = cls.ROOM_ORIGIN
+        entry_point = None
+        # the .json metadata the editor exports alongside a module has its load address and entry point
+        if (meta_path := module_path.with_suffix('.json')).exists():
+            with meta_path.open() as f:
+                metadata = json.load(f)
+            origin = metadata.get('loadAddress', origin)
+            entry_point = metadata.get('entryPoint') or None
+
+        module_symbols = {}
+        if map_path is not None:
+            linker_map = LinkerMap.load(map_path)
+            if linker_map.region_origin:
+                origin = linker_map.region_origin
+            module_symbols = {symbol.name: symbol.address for symbol in linker_map.symbols}
+
+        return cls(module_path.read_bytes(), game_symbols, module_symbols, origin, fire_triggers, entry_point)
+
+    def resolve(self, name_or_address: str) -> int:
+        """
+        Get the address of a function in the module
+
+        :param name_or_address: Name of the function in the linker map, or its address in hexadecimal
+        :return: The address
+        """
+        if name_or_address in self.module_symbols:
+            return self.module_symbols[name_or_address]
+        try:
+            return int(name_or_address, 16)
+        except ValueError:
+            raise KeyError(f'Unknown symbol {name_or_address}') from None
+
+    def resolve_entry(self, name_or_address: str = None) -> int:
+        """
+        Get the address of the room's entry point
+
+        :param name_or_address: Name of the entry point in the linker map, or its address in hexadecimal. If not given,
+            the room function in the linker map is used, or the entry point from the module's metadata if there's no
+            such function.
+        :return: The address
+        """
+        if name_or_address is not None:
+            return self.resolve(name_or_address)
+        if 'room' in self.module_symbols:
+            return self.module_symbols['room']
+        if self.entry_point is not None:
+            return self.entry_point
+        raise KeyError('No room function in the linker map and no entryPoint in the module metadata')
+
+    def _callback_name(self, kind: str, address: int) -> str:
+        return self._callback_names.get(address, f'{kind}_{address:08X}')
+
+    def _stubs(self) -> dict[str, Callable[[Cpu], None]]:
+        return {
+            'Yield': self._yield,
+            'YieldIf': self._yield,
+            'YieldWait': self._yield,
+            'SetRoomLayout': self._set_room_layout,
+            'SetActorAiRoutine': self._set_actor_ai_routine,
+            'LoadFileFromDb': lambda cpu: cpu.return_from_call(cpu.get_arg(2)),
+            'StartLoadFile': lambda cpu: cpu.return_from_call(cpu.get_arg(2)),
+            'memcpy': self._memcpy,
+            'memset': self._memset,
+            'bzero': self._bzero,
+        }
+
+    def _count_stub(self, cpu: Cpu) -> str:
+        name = self._names.get(cpu.pc, f'{cpu.pc:08X}')
+        self.stub_calls[name] = self.stub_calls.get(name, 0) + 1
+        return name
+
+    def _default_stub(self, cpu: Cpu):
+        if cpu.pc not in self._names:
+            raise EmulationError('Jumped to an address that is neither in the module nor a known game function',
+                                 cpu.pc)
+        self._count_stub(cpu)
+        cpu.return_from_call(0)
+
+    def _yield(self, cpu: Cpu):
+        self._count_stub(cpu)
+        cpu.return_from_call()
+        raise StopExecution()
+
+    def _set_room_layout(self, cpu: Cpu):
+        self._count_stub(cpu)
+        game = cpu.get_arg(0)
+        layout = cpu.get_arg(2)
+        # every interactable has a trigger with the same index
+        num_triggers = self.memory.read32(layout + self.LAYOUT_NUM_INTERACTABLES)
+        self.memory.write16(game + GameStateOffsets.NUM_TRIGGERS, num_triggers)
+        cpu.return_from_call()
+
+    def _set_actor_ai_routine(self, cpu: Cpu):
+        self._count_stub(cpu)
+        self.memory.write32(cpu.get_arg(0) + self.ACTOR_AI_ROUTINE, cpu.get_arg(1))
+        cpu.return_from_call()
+
+    def _memcpy(self, cpu: Cpu):
+        self._count_stub(cpu)
+        dest, src, size = cpu.get_arg(0), cpu.get_arg(1), cpu.get_arg(2)
+        self.memory.write(dest, self.memory.read(src, size))
+        cpu.return_from_call(dest)
+
+    def _memset(self, cpu: Cpu):
+        self._count_stub(cpu)
+        dest, value, size = cpu.get_arg(0), cpu.get_arg(1), cpu.get_arg(2)
+        self.memory.write(dest, bytes([value & 0xFF]) * size)
+        cpu.return_from_call(dest)
+
+    def _bzero(self, cpu: Cpu):
+        self._count_stub(cpu)
+        self.memory.write(cpu.get_arg(0), bytes(cpu.get_arg(1)))
+        cpu.return_from_call()
+
+    def is_task_running(self, key: Hashable) -> bool:
+        return any(task.key == key for task in self.tasks)
+
+    def start(self, name: str, address: int, args: Iterable[int] = (), key: Hashable = None):
+        """
+        Start a callback and run it until it returns or yields
+
+        If it yields, it will be resumed on the next frame.
+
+        :param name: Name to record the callback's stats under
+        :param address: Address of the callback
+        :param args: Up to four arguments to pass to the callback
+        :param key: Identifies the caller for is_task_running while the callback is waiting to resume. Defaults to the
+            name.
+        """
+        if not self.free_stacks:
+            raise EmulationError(f'Too many callbacks waiting to resume when starting {name}', address)
+
+        stack_top = self.free_stacks.pop()
+        regs = [0] * 32
+        for i, arg in enumerate(args):
+            regs[Cpu.A0 + i] = arg & 0xFFFFFFFF
+        regs[Cpu.SP] = stack_top - 0x10  # leave space for the callee to save its arguments
+        regs[Cpu.RA] = self.RETURN_ADDRESS
+        self._run(Task(name, name if key is None else key, stack_top, regs, address, address + 4))
+
+    def _run(self, task: Task) -> int:
+        cpu = self.cpu
+        cpu.regs = list(task.regs)
+        cpu.hi = task.hi
+        cpu.lo = task.lo
+        cpu.pc = task.pc
+        cpu.next_pc = task.next_pc
+        start_instructions = cpu.instructions
+        start_cycles = cpu.cycles
+
+        finished = cpu.run(self.RETURN_ADDRESS, self.MAX_INSTRUCTIONS)
+
+        if task.name not in self.stats:
+            self.stats[task.name] = CallbackStats(task.name)
+        self.stats[task.name].add(cpu.instructions - start_instructions, cpu.cycles - start_cycles)
+
+        if finished:
+            self.free_stacks.append(task.stack_top)
+        else:
+            task.regs = list(cpu.regs)
+            task.hi = cpu.hi
+            task.lo = cpu.lo
+            task.pc = cpu.pc
+            task.next_pc = cpu.next_pc
+            self.tasks.append(task)
+        return cpu.regs[Cpu.V0]
+
+    def _call(self, kind: str, index: int, address: int, args: Iterable[int]) -> int | None:
+        if address not in self.module_range:
+            return None
+
+        # tasks are tracked per trigger or actor so a callback shared by several of them still runs for the others
+        # while one of them is waiting
+        key = (kind, index)
+        if self.is_task_running(key):
+            return None  # it's still waiting on something from a previous frame
+        self.start(self._callback_name(kind, address), address, args, key)
+        # a callback that yielded hasn't returned anything yet
+        return None if self.is_task_running(key) else self.cpu.regs[Cpu.V0]
+
+    def step_frame(self):
+        """Run one frame"""
+        self.memory.write16(self.game_symbols['FrameCount'], self.frame)
+
+        waiting = self.tasks
+        self.tasks = []
+        for task in waiting:
+            self._run(task)
+
+        triggers = self.memory.read32(self.game + GameStateOffsets.TRIGGERS)
+        num_triggers = self.memory.read16(self.game + GameStateOffsets.NUM_TRIGGERS)
+        if triggers != 0:
+            for i in range(min(num_triggers, 100)):
+                trigger = triggers + i * self.TRIGGER_SIZE
+                enabled_callback = self.memory.read32(trigger + self.TRIGGER_ENABLED_CALLBACK)
+                callback = self.memory.read32(trigger + self.TRIGGER_CALLBACK)
+                is_enabled = True
+                if enabled_callback != 0:
+                    is_enabled = bool(self._call('enabled', i, enabled_callback, [self.game]))
+                if self.fire_triggers and is_enabled and callback != 0:
+                    self._call('trigger', i, callback, [self.game])
+
+        for i in range(self.NUM_ACTORS):
+            actor = self.actors + i * self.ACTOR_SIZE
+            routine = self.memory.read32(actor + self.ACTOR_AI_ROUTINE)
+            if routine != 0:
+                self._call('ai', i, routine, [self.game, actor])
+
+        self.frame += 1
+
+    def run(self, entry: int, frames: int):
+        """
+        Start the room and run it for a number of frames
+
+        :param entry: Address of the room's entry point
+        :param frames: Number of frames to run
+        """
+        self.start(self._callback_name('entry', entry), entry, [self.game])
+        # the entry point's first run happens before the first frame's callbacks, as when the game loads a room
+        for _ in range(frames):
+            self.step_frame()
+
+    def report(self) -> dict:
+        return {
+            'frames': self.frame,
+            'callbacks': [asdict(stats) | {'avg_instructions': stats.avg_instructions, 'avg_cycles': stats.avg_cycles}
+                          for stats in self.stats.values()],
+            'stub_calls': dict(sorted(self.stub_calls.items())),
+        }
+
+
+def benchmark(module: str, map_path: str | None, symbols: str, entry: str | None, frames: int, fire_triggers: bool,
+              json_path: str | None) -> bool:
+    bench = RoomBenchmark.load(Path(module), Path(map_path) if map_path else None, Path(symbols), fire_triggers)
+    try:
+        entry_point = bench.resolve_entry(entry)
+    except KeyError as e:
+        print(f'Unable to find the entry point of {module}: {e.args[0]}', file=sys.stderr)
+        return False
+    bench.run(entry_point, frames)
+
+    print(f'{"callback":<32} {"runs":>6} {"avg insts":>10} {"max insts":>10} {"avg cycles":>11} {"max cycles":>11}')
+    for stats in sorted(bench.stats.values(), key=lambda s: s.max_cycles, reverse=True):
+        print(f'{stats.name:<32} {stats.runs:>6} {stats.avg_instructions:>10.1f} {stats.max_instructions:>10} '
+              f'{stats.avg_cycles:>11.1f} {stats.max_cycles:>11}')
+    if bench.stub_calls:
+        print()
+        print(f'{"game function":<32} {"calls":>6}')
+        for name, count in sorted(bench.stub_calls.items(), key=lambda i: i[1], reverse=True):
+            print(f'{name:<32} {count:>6}')
+
+    if json_path:
+        with open(json_path, 'w') as f:
+            json.dump(bench.report(), f, indent=4)
+    return True
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(description='Run a room module built with the SDK in an emulated CPU and report '
+                                                 'instruction and cycle counts for its callbacks')
+    parser.add_argument('-m', '--map', help='Linker map for the module. Defaults to the .map file next to the module.')
+    parser.add_argument('-s', '--symbols', help='Game symbols linker script for the version the module was built for',
+                        default=str(DEFAULT_SYMBOLS))
+    parser.add_argument('-e', '--entry', help="Name of the module's entry point in the linker map, or its address in "
+                        "hexadecimal. Defaults to room in the linker map, or the entryPoint in the module's .json "
+                        "metadata if the map doesn't have it.")
+    parser.add_argument('-f', '--frames', help='Number of frames to run', type=int, default=60)
+    parser.add_argument('-t', '--fire-triggers', help="Call every enabled trigger's callback every frame, as if the "
+                        "player were activating it", action='store_true')
+    parser.add_argument('-j', '--json', help='Also write the results to this path as JSON')
+    parser.add_argument('module', help='Path to the module file')
+
+    args = parser.parse_args()
+    if not benchmark(args.module, args.map, args.symbols, args.entry, args.frames, args.fire_triggers, args.json):
+        sys.exit(1)
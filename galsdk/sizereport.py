@@ -0,0 +1,241 @@
+from __future__ import annotations
+
+import re
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Iterable, Self, TextIO
+
+
+@dataclass
+class MapSymbol:
+    name: str
+    address: int
+    size: int
+    section: str
+    file: str
+
+
+@dataclass
+class InputSection:
+    name: str
+    address: int
+    size: int
+    file: str
+    symbols: list[tuple[int, str]] = field(default_factory=list)
+
+    def sized_symbols(self, output_section: str) -> Iterable[MapSymbol]:
+        """
+        Calculate the size of each symbol in the section from the distance to the next symbol
+
+        Static functions and variables aren't listed in the map, so any bytes before the first symbol are attributed to
+        the section itself. With -ffunction-sections and -fdata-sections, the section name includes the name of the
+        static symbol.
+        """
+        end = self.address + self.size
+        symbols = sorted(self.symbols)
+        first = symbols[0][0] if symbols else end
+        if first > self.address:
+            prefix = f'{output_section}.'
+            name = self.name[len(prefix):] if self.name.startswith(prefix) else f'<{self.name}>'
+            yield MapSymbol(name, self.address, first - self.address, output_section, self.file)
+        for i, (address, name) in enumerate(symbols):
+            next_address = symbols[i + 1][0] if i + 1 < len(symbols) else end
+            yield MapSymbol(name, address, next_address - address, output_section, self.file)
+
+
+@dataclass
+class OutputSection:
+    name: str
+    address: int
+    size: int
+    inputs: list[InputSection] = field(default_factory=list)
+
+    @property
+    def is_bss(self) -> bool:
+        """Whether the section takes up memory but not space in the module file"""
+        return self.name in ('.bss', '.sbss')
+
+
+class LinkerMap:
+    """
+    A GNU ld map file, as produced by linking with -Map or -M
+
+    This only understands enough of the format to report how much space a module takes up.
+    """
+
+    # room modules are linked into ROOM, and stage libraries into STAGE
+    REGION_NAMES = ('ROOM', 'STAGE')
+
+    HEX = r'0x([0-9a-fA-F]+)'
+    SECTION_RE = re.compile(rf'^\s*(?:(\S+)\s+)?{HEX}\s+{HEX}(?:\s+(\S.*))?$')
+    SYMBOL_RE = re.compile(rf'^\s+{HEX}\s+([A-Za-z_.$][\w.$]*)$')
+    MEMORY_RE = re.compile(rf'^(\S+)\s+{HEX}\s+{HEX}')
+    ASSIGNMENT_RE = re.compile(rf'^\s+{HEX}\s+([A-Za-z_.$][\w.$]*) = ')
+
+    def __init__(self, region_origin: int, region_length: int, sections: list[OutputSection],
+                 discarded: list[InputSection], assignments: dict[str, int] | None = None):
+        self.region_origin = region_origin
+        self.region_length = region_length
+        self.sections = sections
+        self.discarded = discarded
+        self.assignments = assignments or {}
+
+    @classmethod
+    def read(cls, f: TextIO) -> Self:
+        region_origin = region_length = 0
+        sections: list[OutputSection] = []
+        discarded: list[InputSection] = []
+        assignments: dict[str, int] = {}
+        mode = None
+        # long section names are printed on their own line with the address and size on the next line
+        pending_name = None
+        pending_is_input = False
+
+        for line in f:
+            line = line.rstrip('\n')
+            stripped = line.strip()
+            if stripped == 'Discarded input sections':
+                mode = 'discarded'
+                continue
+            if stripped == 'Memory Configuration':
+                mode = 'memory'
+                continue
+            if stripped == 'Linker script and memory map':
+                mode = 'map'
+                continue
+            if not stripped:
+                continue
+
+            if mode == 'memory':
+                if m := cls.MEMORY_RE.match(line):
+                    if m[1] in cls.REGION_NAMES and region_length == 0:
+                        region_origin = int(m[2], 16)
+                        region_length = int(m[3], 16)
+                continue
+
+            if mode == 'map' and (m := cls.ASSIGNMENT_RE.match(line)):
+                assignments[m[2]] = int(m[1], 16)
+                continue
+
+            if mode not in ('discarded', 'map') or '=' in line or stripped.startswith(('*', 'LOAD ', 'OUTPUT(')):
+                continue
+
+            if m := cls.SYMBOL_RE.match(line):
+                if mode == 'map' and sections and sections[-1].inputs:
+                    sections[-1].inputs[-1].symbols.append((int(m[1], 16), m[2]))
+                continue
+
+            is_input = line.startswith(' ')
+            if m := cls.SECTION_RE.match(line):
+                name = m[1]
+                if name is None:
+                    # continuation of a long name
+                    name = pending_name
+                    is_input = pending_is_input
+                    pending_name = None
+                if name is None:
+                    continue
+                address = int(m[2], 16)
+                size = int(m[3], 16)
+                if mode == 'discarded':
+                    discarded.append(InputSection(name, address, size, m[4] or ''))
+                elif is_input:
+                    if sections:
+                        sections[-1].inputs.append(InputSection(name, address, size, m[4] or ''))
+                else:
+                    sections.append(OutputSection(name, address, size))
+            elif ' ' not in stripped:
+                pending_name = stripped
+                pending_is_input = is_input
+
+        return cls(region_origin, region_length, sections, discarded, assignments)
+
+    @classmethod
+    def load(cls, path: Path) -> Self:
+        with path.open() as f:
+            return cls.read(f)
+
+    @property
+    def region_sections(self) -> list[OutputSection]:
+        """Output sections that are placed in the module region"""
+        end = self.region_origin + self.region_length
+        return [s for s in self.sections if s.size > 0 and self.region_origin <= s.address < end]
+
+    @property
+    def available_size(self) -> int:
+        """
+        Amount of memory the module can use, which is less than the region if a stage library is at the end of it
+        """
+        end = self.assignments.get('ModuleRegionEnd')
+        if end is not None and self.region_origin <= end <= self.region_origin + self.region_length:
+            return end - self.region_origin
+        return self.region_length
+
+    @property
+    def file_size(self) -> int:
+        """Size of the module file"""
+        ends = [s.address + s.size for s in self.region_sections if not s.is_bss]
+        return max(ends) - self.region_origin if ends else 0
+
+    @property
+    def memory_size(self) -> int:
+        """Amount of memory the module uses when loaded, including zero-initialized data"""
+        ends = [s.address + s.size for s in self.region_sections]
+        return max(ends) - self.region_origin if ends else 0
+
+    @property
+    def discarded_size(self) -> int:
+        return sum(s.size for s in self.discarded)
+
+    def symbols(self) -> list[MapSymbol]:
+        """Get all symbols in the module region, largest first"""
+        symbols = [symbol for section in self.region_sections for input_ in section.inputs
+                   for symbol in input_.sized_symbols(section.name) if symbol.size > 0]
+        return sorted(symbols, key=lambda s: s.size, reverse=True)
+
+
+def report(map_path: str, limit: int | None, top: int | None) -> bool:
+    linker_map = LinkerMap.load(Path(map_path))
+    if limit is None:
+        limit = linker_map.available_size
+
+    print(f'{"Section":<12}  {"Address":>8}  {"Size":>6}')
+    for section in linker_map.region_sections:
+        print(f'{section.name:<12}  {section.address:08X}  {section.size:>6}')
+
+    symbols = linker_map.symbols()
+    if top is not None:
+        symbols = symbols[:top]
+    if symbols:
+        name_width = max(len('Symbol'), *(len(s.name) for s in symbols))
+        print()
+        print(f'{"Symbol":<{name_width}}  {"Section":<12}  {"Address":>8}  {"Size":>6}')
+        for symbol in symbols:
+            print(f'{symbol.name:<{name_width}}  {symbol.section:<12}  {symbol.address:08X}  {symbol.size:>6}')
+
+    print()
+    if linker_map.discarded:
+        print(f'Discarded {linker_map.discarded_size} bytes in {len(linker_map.discarded)} unused sections')
+    used = linker_map.memory_size
+    percent = used * 100 / limit if limit > 0 else 100.
+    print(f'File size: {linker_map.file_size} bytes; memory used: {used} of {limit} bytes ({percent:.1f}%), '
+          f'{limit - used} free')
+    if used > limit:
+        print(f'ERROR: module is {used - limit} bytes over the limit')
+        return False
+    return True
+
+
+if __name__ == '__main__':
+    import argparse
+    import sys
+
+    parser = argparse.ArgumentParser(description='Report the size of a module from its linker map')
+    parser.add_argument('-l', '--limit', help='Maximum size of the module in bytes. Defaults to the size of the ROOM '
+                        'memory region in the map, less any space reserved for a stage library.', type=int)
+    parser.add_argument('-t', '--top', help='Only list this many of the largest symbols', type=int)
+    parser.add_argument('map', help='Path to the linker map file')
+
+    args = parser.parse_args()
+    if not report(args.map, args.limit, args.top):
+        sys.exit(1)
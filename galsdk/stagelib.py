@@ -0,0 +1,137 @@
+from __future__ import annotations
+
+import struct
+from dataclasses import dataclass
+from pathlib import Path
+
+from galsdk.sizereport import LinkerMap
+
+
+MAGIC = b'GSTG'
+VERSION = 1
+HEADER_FORMAT = '<4s2H3I'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+CHECKSUM_OFFSET = 0x0C
+EXPORT_SECTION = 'STAGE_EXPORTS'
+EXPORT_PREFIX = 'StageExport_'
+
+
+def checksum(data: bytes) -> int:
+    """Calculate a stage library checksum the same way as ComputeStageLibraryChecksum in stagelib.h"""
+    total = 0
+    for (word,) in struct.iter_unpack('<I', data[:len(data) & ~3]):
+        total = (((total << 1) | (total >> 31)) + word) & 0xffffffff
+    return total
+
+
+@dataclass
+class StageLibrary:
+    """
+    A linked stage library module (see sdk/include/galerians/stagelib.h)
+
+    The library's header is filled in by the *_stage.ld linker scripts except for the checksum, which this fills in.
+    The addresses of the exports are taken from the linker map, since the library binary itself doesn't have symbols.
+    """
+
+    data: bytes
+    start: int
+    exports: dict[str, int]
+
+    @classmethod
+    def load(cls, library_path: Path, map_path: Path | None = None) -> StageLibrary:
+        if map_path is None:
+            map_path = library_path.with_name(library_path.name + '.map')
+        return cls.parse(library_path.read_bytes(), LinkerMap.load(map_path))
+
+    @classmethod
+    def parse(cls, data: bytes, linker_map: LinkerMap) -> StageLibrary:
+        if len(data) < HEADER_SIZE:
+            raise ValueError('Stage library is too small to have a header')
+        magic, version, num_exports, code_size, _, file_size = struct.unpack_from(HEADER_FORMAT, data)
+        if magic != MAGIC:
+            raise ValueError('Not a stage library; was it linked with one of the *_stage.ld scripts?')
+        if version != VERSION:
+            raise ValueError(f'Unsupported stage library version {version}')
+        if file_size != len(data) or HEADER_SIZE + code_size > file_size:
+            raise ValueError(f'Stage library header gives file size {file_size} and code size {code_size} but the '
+                             f'file is {len(data)} bytes')
+
+        start = linker_map.assignments.get('StageLibraryStart')
+        if start is None:
+            raise ValueError('StageLibraryStart is missing from the linker map')
+
+        exports = {}
+        for section in linker_map.sections:
+            for input_section in section.inputs:
+                if input_section.name != EXPORT_SECTION:
+                    continue
+                for address, name in input_section.symbols:
+                    if name.startswith(EXPORT_PREFIX):
+                        exports[name[len(EXPORT_PREFIX):]] = address
+        if len(exports) != num_exports:
+            raise ValueError(f'Stage library header lists {num_exports} exports but the linker map has '
+                             f'{len(exports)}')
+        return cls(data, start, exports)
+
+    @property
+    def code_size(self) -> int:
+        return struct.unpack_from('<I', self.data, 8)[0]
+
+    @property
+    def checksum(self) -> int:
+        return checksum(self.data[HEADER_SIZE:HEADER_SIZE + self.code_size])
+
+    def with_checksum(self) -> bytes:
+        """Get the library file with its checksum filled in"""
+        return self.data[:CHECKSUM_OFFSET] + struct.pack('<I', self.checksum) + self.data[CHECKSUM_OFFSET + 4:]
+
+    def symbol_file(self, index: int, source: str) -> str:
+        """
+        Generate the linker script that room modules link against
+
+        :param index: Index of the library in MODULE.BIN
+        :param source: Name of the library file, for the comment at the top of the script
+        :return: Text of the linker script
+        """
+        lines = [
+            f'/* generated by galsdk.stagelib from {source}. link room modules with this after the linker script. */',
+            f'StageLibraryStart = 0x{self.start:08X};',
+            f'StageLibraryIndex = {index};',
+            f'StageLibraryChecksum = 0x{self.checksum:08X};',
+        ]
+        for name, address in sorted(self.exports.items(), key=lambda e: e[1]):
+            lines.append(f'{name} = 0x{address:08X};')
+        return '\n'.join(lines) + '\n'
+
+
+def write_if_changed(path: Path, text: str):
+    """Write a file only if its contents changed, so that make doesn't relink room modules unnecessarily"""
+    if not path.exists() or path.read_text() != text:
+        path.write_text(text)
+
+
+def prepare(library_path: str, index: int, output: str | None, map_path: str | None):
+    path = Path(library_path)
+    library = StageLibrary.load(path, Path(map_path) if map_path else None)
+    data = library.with_checksum()
+    if data != library.data:
+        path.write_bytes(data)
+    if output is None:
+        output = str(path.with_name(path.name + '.ld'))
+    write_if_changed(Path(output), library.symbol_file(index, path.name))
+    print(f'{path.name}: {len(library.exports)} exports, checksum {library.checksum:08X}')
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(description='Fill in the checksum of a linked stage library and generate the '
+                                     'symbol file that room modules link against')
+    parser.add_argument('-i', '--index', help='Index of the library in MODULE.BIN', type=int, required=True)
+    parser.add_argument('-o', '--output', help='Path to write the symbol file to. Defaults to the library path with '
+                        '.ld appended.')
+    parser.add_argument('-m', '--map', help='Path to the linker map. Defaults to the library path with .map appended.')
+    parser.add_argument('library', help='Path to the linked library')
+
+    args = parser.parse_args()
+    prepare(args.library, args.index, args.output, args.map)
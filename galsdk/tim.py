@@ -194,17 +194,20 @@ class TimDb(Archive[Tim]):
 
         return db
 
-    def write(self, f: BinaryIO, *, fmt: Format = None, **kwargs):
+    def write(self, f: BinaryIO, *, fmt: Format = None, max_workers: int | None = None, **kwargs):
         """
         Write the images in this object out to a database file
 
         :param f: Binary data stream to write the TIM database to
         :param fmt: Format to save the TIM database in
+        :param max_workers: Maximum number of processes to compress images in, for compressed formats. None uses one
+            process per CPU when there's enough data to be worth it, and 1 compresses everything in this process.
         """
         if fmt is None:
             fmt = self.format
 
         raw_tims = []
+        to_compress = []
         self.offsets = {}
         for image in self.images:
             if not isinstance(image, TimDb) or not (data := image.raw_data):
@@ -212,8 +215,11 @@ class TimDb(Archive[Tim]):
                     image.write(buf)
                     data = buf.getvalue()
             if fmt.is_compressed and isinstance(image, Tim):
-                data = dictcmp.compress(data)
+                to_compress.append(len(raw_tims))
             raw_tims.append(data)
+        # the images are compressed independently, so do them all at once
+        for i, data in zip(to_compress, dictcmp.compress_many((raw_tims[i] for i in to_compress), max_workers)):
+            raw_tims[i] = data
 
         if not fmt.is_stream:
             f.write(len(self.images).to_bytes(4, 'little'))
@@ -42,6 +42,10 @@ from galsdk.ui.viewport import Cursor, Viewport
 from psx.tim import Transparency
 
 
+# bump this when the background conversion in set_bg changes to invalidate cached backgrounds
+BACKGROUND_CACHE_VERSION = 1
+
+
 class DragMode(Enum):
     MOVE_H = auto()
     MOVE_V = auto()
@@ -123,7 +127,7 @@ class RoomViewport(Viewport):
         self.current_bg = 0
         self.current_entrance_set = -1
         self.num_bgs = 0
-        self.loaded_tims = {}
+        self.background_paths = {}
         self.actor_layouts = []
         self.current_layout = -1
         self.camera_view = None
@@ -138,7 +142,7 @@ class RoomViewport(Viewport):
         if self.background:
             self.background.remove_from_scene()
             self.background = None
-        self.loaded_tims = {}
+        self.background_paths = {}
         for obj in [*self.colliders, *self.triggers, *self.cuts, *self.cameras, *self.actors, *self.entrances]:
             obj.remove_from_scene()
         self.colliders = []
@@ -247,7 +251,14 @@ class RoomViewport(Viewport):
         if bg_index == -1:
             bg_image = self.missing_bg
         else:
-            bg_image = self.loaded_tims[bg_index][0].to_image(0, Transparency.NONE)
+            bg_path = self.background_paths[bg_index]
+
+            def decode_background() -> Image.Image:
+                with bg_path.open('rb') as f:
+                    return TimFormat.read(f).to_image(0, Transparency.NONE)
+
+            bg_image = self.project.get_asset_cache().get_image([bg_path], 'background', BACKGROUND_CACHE_VERSION,
+                                                                decode_background)
         self.background = BillboardObject('room_viewport_background', bg_image)
         self.background.add_to_scene(self.camera)
         self.update_camera_view()
@@ -434,10 +445,13 @@ class RoomViewport(Viewport):
             camera_object.add_to_scene(self.camera_node)
             self.cameras.append(camera_object)
             for background in backgrounds:
-                if background.index >= 0 and background.index not in self.loaded_tims:
+                if background.index >= 0 and background.index not in self.background_paths:
                     path = self.stage_backgrounds[self.current_stage][background.index].path
                     manifest = Manifest.load_from(path)
-                    self.loaded_tims[background.index] = [fm.obj for fm in manifest.load_files(TimFormat)]
+                    # only the first image is shown. it's decoded by set_bg, through the asset cache.
+                    self.background_paths[background.index] = next(
+                        manifest.expand_file(mf).path for mf in manifest.files if not mf.is_manifest or mf.flatten
+                    )
 
         for layout_set in module.actor_layouts:
             self.actor_layouts.extend(layout_set.layouts)
@@ -1,5 +1,6 @@
 from __future__ import annotations
 
+import functools
 from dataclasses import dataclass
 from pathlib import Path
 from typing import BinaryIO, ByteString, Iterable, Self
@@ -17,6 +18,45 @@ from psx.cd.disc import Sector, SubMode
 from psx.exe import Exe
 
 
+# offsets of sub-header fields in a raw sector. the sub-header is repeated at +4.
+MODE_OFFSET = 0x0f
+CHANNEL_OFFSET = 0x11
+SUB_MODE_OFFSET = 0x12
+SUB_HEADER_OFFSET = 0x10
+DATA_OFFSET = 0x18
+FORM1_EDC_OFFSET = 0x818
+
+
+@functools.cache
+def _cleared_sector_edc(sub_header: bytes) -> int:
+    # the data of a cleared sector is all zeroes, so its EDC only depends on the sub-header. XA files only use a handful
+    # of different sub-headers, so caching this saves calculating the EDC of almost every cleared sector.
+    sector = Sector(mode=2)
+    sector.view[SUB_HEADER_OFFSET:DATA_OFFSET] = sub_header
+    return sector.calculate_edc()
+
+
+def _scan_sectors(data: ByteString, start: int, end: int) -> Iterable[tuple[int, int | None, int | None]]:
+    """
+    Scan the sub-headers of raw sectors without creating Sector objects for them
+
+    :param data: Raw sector data
+    :param start: Byte offset of the first sector to scan
+    :param end: Byte offset to stop scanning at
+    :return: The byte offset, channel, and sub-mode of each sector. As with Sector, the channel and sub-mode are None
+        for sectors that aren't mode 2.
+    """
+    size = Sector.SIZE
+    # strided slices pick out the same field of every sector in one operation
+    for offset, mode, channel, sub_mode in zip(range(start, end, size), data[start + MODE_OFFSET:end:size],
+                                               data[start + CHANNEL_OFFSET:end:size],
+                                               data[start + SUB_MODE_OFFSET:end:size]):
+        if mode == 2:
+            yield offset, channel, sub_mode
+        else:
+            yield offset, None, None
+
+
 class XaAudio(Media):
     def __init__(self, path: Path):
         super().__init__(path, 'wav')
@@ -78,18 +118,20 @@ class XaRegion:
 
     @property
     def first_audio_sector(self) -> tuple[int, Sector | None]:
-        for i in range(0, len(self.data), Sector.SIZE):
-            sector = Sector(self.data[i:i + Sector.SIZE])
-            if sector.sub_mode & SubMode.AUDIO and sector.channel == self.channel:
-                return i // Sector.SIZE, sector
+        for i, channel, sub_mode in _scan_sectors(self.data, 0, len(self.data)):
+            if sub_mode is not None and sub_mode & SubMode.AUDIO and channel == self.channel:
+                return i // Sector.SIZE, Sector(self.data[i:i + Sector.SIZE])
         return -1, None
 
     @property
     def own_sectors(self) -> Iterable[Sector]:
-        for i in range(0, self.num_sectors * Sector.SIZE, Sector.SIZE):
-            sector = Sector(self.data[i:i + Sector.SIZE])
-            if sector.channel == self.channel and sector.sub_mode & SubMode.AUDIO:
-                yield sector
+        end = self.num_sectors * Sector.SIZE
+        if len(self.data) < end:
+            raise ValueError(f'XA region should have {self.num_sectors} sectors but its data is only {len(self.data)} '
+                             'bytes')
+        for i, channel, sub_mode in _scan_sectors(self.data, 0, end):
+            if channel == self.channel and sub_mode & SubMode.AUDIO:
+                yield Sector(self.data[i:i + Sector.SIZE])
 
     @property
     def num_sectors(self) -> int:
@@ -111,20 +153,32 @@ class XaDatabase(Archive[bytes]):
     def clean_regions(regions: list[XaRegion], data: ByteString = None):
         for region in regions:
             input_data = region.data if data is None else data
-            sector_data = bytearray()
-            for i in range(region.start, region.end + 1):
-                start = i * Sector.SIZE
-                # if we reach EOF, just go with what we've got
-                if start >= len(input_data):
-                    region.end = i - 1
-                    break
-                end = (i + 1) * Sector.SIZE
-                sector = Sector(input_data[start:end])
-                if sector.channel != region.channel:
-                    # zero out other channels
-                    sector.sub_mode = SubMode.DATA
-                    sector.data[:] = bytes(sector.data_size)
-                sector_data.extend(sector.raw)
+            region_end = region.end
+            # if we reach EOF, just go with what we've got
+            num_sectors = -(-len(input_data) // Sector.SIZE)
+            if region_end >= num_sectors:
+                region_end = max(region.start, num_sectors) - 1
+            sector_data = bytearray(input_data[region.start * Sector.SIZE:(region_end + 1) * Sector.SIZE])
+
+            if len(sector_data) % Sector.SIZE != 0:
+                # incomplete sector at the end; this raises the same error as reading it would
+                Sector(sector_data[len(sector_data) - len(sector_data) % Sector.SIZE:])
+            for i, channel, _ in _scan_sectors(sector_data, 0, len(sector_data)):
+                if channel is None or sector_data[i:i + len(Sector.SYNC_HEADER)] != Sector.SYNC_HEADER:
+                    # not a valid XA sector; let Sector deal with it
+                    sector = Sector(sector_data[i:i + Sector.SIZE])
+                    if sector.channel != region.channel:
+                        sector.sub_mode = SubMode.DATA
+                        sector.data[:] = bytes(sector.data_size)
+                    sector_data[i:i + Sector.SIZE] = sector.raw
+                elif channel != region.channel:
+                    # zero out other channels. this is the same as setting the sector's sub-mode to DATA (which also
+                    # makes it form 1) and clearing its data, without recalculating the EDC from scratch every time.
+                    sector_data[i + SUB_MODE_OFFSET] = sector_data[i + SUB_MODE_OFFSET + 4] = SubMode.DATA
+                    sector_data[i + DATA_OFFSET:i + FORM1_EDC_OFFSET] = bytes(FORM1_EDC_OFFSET - DATA_OFFSET)
+                    edc = _cleared_sector_edc(bytes(sector_data[i + SUB_HEADER_OFFSET:i + DATA_OFFSET]))
+                    sector_data[i + FORM1_EDC_OFFSET:i + FORM1_EDC_OFFSET + 4] = edc.to_bytes(4, 'little')
+            region.end = region_end
             region.data = sector_data
 
     def set_data(self, data: ByteString):
@@ -138,9 +192,8 @@ class XaDatabase(Archive[bytes]):
         if not self.data:
             return -1
 
-        for i in range(start_sector * Sector.SIZE, len(self.data), Sector.SIZE):
-            sector = Sector(self.data[i:i+Sector.SIZE])
-            if sector.channel == channel:
+        for i, sector_channel, _ in _scan_sectors(self.data, start_sector * Sector.SIZE, len(self.data)):
+            if sector_channel == channel:
                 return i
         return -1
 
@@ -183,13 +236,15 @@ class XaDatabase(Archive[bytes]):
         raise NotImplementedError
 
     def extend(self, other: XaDatabase):
+        if self.data is None:
+            self.data = bytearray()
         num_sectors = self.num_sectors
-        for region in other.regions:
-            num_bytes = (region.end + 1) * Sector.SIZE
-            self.regions.append(XaRegion(region.channel, region.start + num_sectors, region.end + num_sectors,
-                                         region.data[:num_bytes]))
+        new_regions = [XaRegion(region.channel, region.start + num_sectors, region.end + num_sectors)
+                       for region in other.regions]
         self.data += other.data
-        self.clean_regions(self.regions)
+        # only the new regions need cleaning, and their data comes from the combined data they now index into
+        self.clean_regions(new_regions, self.data)
+        self.regions.extend(new_regions)
 
     def compact(self) -> XaDatabase:
         regions = []
@@ -334,20 +389,25 @@ def export_mxa(exe_path: Path, disc: int, target_path: Path, packs: list[Path],
         exe = Exe.read(f)
 
     region_sets = XaRegion.get_jp_xa_regions(addresses, disc, exe)
+    if len(region_sets) != len(packs):
+        raise ValueError(f'Disc {disc} has {len(region_sets)} XA packs but {len(packs)} were given')
+
     all_regions = []
     all_data = bytearray()
     sector_offset = 0
     pack_offsets = []
-    for region_set, pack in zip(region_sets, packs, strict=True):
+    for region_set, pack in zip(region_sets, packs):
         if pack_offsets:
             pack_offsets.append(pack_offsets[-1] + len(region_set))
         else:
             pack_offsets.append(0)
         data = pack.read_bytes()
-        XaDatabase.clean_regions(region_set, data)
+        # the regions are cleaned once the packs are combined, but the ends of any that run past the end of their pack
+        # need to be cut off here so they don't pick up sectors from the next pack
+        num_sectors = -(-len(data) // Sector.SIZE)
         for region in region_set:
-            all_regions.append(XaRegion(region.channel, region.start + sector_offset, region.end + sector_offset,
-                                        region.data))
+            end = min(region.end, max(region.start, num_sectors) - 1)
+            all_regions.append(XaRegion(region.channel, region.start + sector_offset, end + sector_offset))
         sector_offset += len(data) // Sector.SIZE
         all_data += data
 
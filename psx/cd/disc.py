@@ -2,7 +2,7 @@ from __future__ import annotations
 
 from array import array
 from enum import IntEnum
-from typing import BinaryIO, ByteString, ClassVar, Sequence
+from typing import BinaryIO, ByteString, ClassVar, Iterable, Sequence
 
 
 class SubMode(IntEnum):
@@ -68,6 +68,10 @@ class Sector:
         """
         self.edit_count = 0
         self.need_error_code_update = False
+        # whether the sector has changed since it was read (or last written with PsxCd.write_to_path)
+        self.is_dirty = raw is None
+        # whether the EDC needs to be recalculated before it's next used
+        self.is_edc_stale = False
         if raw is None:
             self._raw = bytearray(Sector.SIZE)
             self._raw[:len(self.SYNC_HEADER)] = self.SYNC_HEADER
@@ -125,22 +129,27 @@ class Sector:
             self.update_edc()
             self.need_error_code_update = False
 
-    def calculate_edc(self) -> int:
+    @property
+    def edc_range(self) -> tuple[int, int] | None:
+        """The range of bytes in the raw sector covered by the EDC, or None if the sector has no EDC"""
         match self.mode:
             case 0:
-                return 0
+                return None
             case 1:
-                start = 0
-                end = 0x810
+                return 0, 0x810
             case 2 if self.form == 1:
-                start = 0x10
-                end = 0x818
+                return 0x10, 0x818
             case 2:
-                start = 0x10
-                end = 0x92c
+                return 0x10, 0x92c
             case _:
                 raise ValueError(f'Invalid mode {self.mode}; expected 0, 1, or 2')
 
+    def calculate_edc(self) -> int:
+        edc_range = self.edc_range
+        if edc_range is None:
+            return 0
+        start, end = edc_range
+
         edc_table = self.edc_table
         edc = 0
         for b in self._raw[start:end]:
@@ -148,17 +157,89 @@ class Sector:
             edc = (edc >> 8) ^ edc_table[edc & 0xff]
         return edc
 
-    def update_edc(self, force: bool = False):
+    def _needs_edc(self, force: bool = False) -> bool:
         # mode 0 sectors have no EDC
         if self.mode == 0:
-            return
+            return False
 
         # EDC is optional for mode 2/form 2, so if we don't have one already, don't bother setting it unless it was
         # explicitly requested
-        if not force and self.mode == 2 and self.form == 2 and self.edc == 0:
-            return
+        if not force and self.mode == 2 and self.form == 2 and self._stored_edc == 0:
+            return False
+
+        return True
+
+    def update_edc(self, force: bool = False):
+        self.is_dirty = True
+        self.is_edc_stale = False
+        if self._needs_edc(force):
+            self.edc = self.calculate_edc()
+
+    def invalidate_edc(self):
+        """
+        Mark the sector as changed so that its EDC will be recalculated before it's next used
+
+        This is cheaper than update_edc when a sector is changed many times, and lets Sector.update_edcs calculate the
+        EDCs of many sectors at once.
+        """
+        self.is_dirty = True
+        self.is_edc_stale = True
+
+    def _flush_edc(self):
+        if self.is_edc_stale:
+            self.update_edc()
+
+    @classmethod
+    def update_edcs(cls, sectors: Iterable[Sector], min_batch_size: int = 16):
+        """
+        Recalculate the EDCs of all sectors whose EDCs are stale
+
+        When numpy is available, the calculation is vectorized across sectors, which is much faster than calculating
+        each sector's EDC separately when a large file has been patched.
 
-        self.edc = self.calculate_edc()
+        :param sectors: Sectors to update. Sectors whose EDCs are already up to date are skipped.
+        :param min_batch_size: Minimum number of sectors to vectorize; smaller batches are calculated one at a time
+        """
+        batches: dict[tuple[int, int], list[Sector]] = {}
+        for sector in sectors:
+            if not sector.is_edc_stale:
+                continue
+            if not sector._needs_edc():
+                sector.is_edc_stale = False
+                continue
+            batches.setdefault(sector.edc_range, []).append(sector)
+
+        for (start, end), batch in batches.items():
+            edcs = None
+            if len(batch) >= min_batch_size:
+                edcs = cls._calculate_edcs_vectorized(batch, start, end)
+            if edcs is None:
+                edcs = [sector.calculate_edc() for sector in batch]
+            for sector, edc in zip(batch, edcs):
+                sector.edc = edc
+                sector.is_edc_stale = False
+
+    @classmethod
+    def _calculate_edcs_vectorized(cls, sectors: list[Sector], start: int, end: int,
+                                   chunk_size: int = 1024) -> list[int] | None:
+        try:
+            import numpy as np
+        except ImportError:
+            return None
+
+        table = np.array(cls.edc_table, np.uint32)
+        edcs = []
+        for i in range(0, len(sectors), chunk_size):
+            chunk = sectors[i:i + chunk_size]
+            data = np.frombuffer(b''.join(sector._raw[start:end] for sector in chunk), np.uint8)
+            # one row per byte position so each step of the CRC works on a contiguous row of all the sectors
+            columns = np.ascontiguousarray(data.reshape(len(chunk), end - start).T)
+            edc = np.zeros(len(chunk), np.uint32)
+            for column in columns:
+                edc ^= column
+                edc = (edc >> 8) ^ table[edc & 0xff]
+            edcs.extend(int(value) for value in edc)
+        return edcs
 
     def validate_edc(self) -> bool:
         edc = self.edc
@@ -174,11 +255,12 @@ class Sector:
             self.need_error_code_update = True
             return
 
-        self.update_edc()
+        self.invalidate_edc()
         self.need_error_code_update = False
 
     @property
     def raw(self) -> bytes:
+        self._flush_edc()
         return bytes(self._raw)
 
     @property
@@ -187,6 +269,7 @@ class Sector:
 
     @minute.setter
     def minute(self, value: int):
+        self.is_dirty = True
         self._raw[0xc] = self.to_bcd(value)
         if self.mode == 1:
             self.request_error_code_update()
@@ -197,6 +280,7 @@ class Sector:
 
     @second.setter
     def second(self, value: int):
+        self.is_dirty = True
         self._raw[0xd] = self.to_bcd(value)
         if self.mode == 1:
             self.request_error_code_update()
@@ -207,6 +291,7 @@ class Sector:
 
     @sector.setter
     def sector(self, value: int):
+        self.is_dirty = True
         self._raw[0xe] = self.to_bcd(value)
         if self.mode == 1:
             self.request_error_code_update()
@@ -286,6 +371,11 @@ class Sector:
 
     @property
     def edc(self) -> int:
+        self._flush_edc()
+        return self._stored_edc
+
+    @property
+    def _stored_edc(self) -> int:
         match self.mode:
             case 0:
                 return 0
@@ -300,6 +390,7 @@ class Sector:
 
     @edc.setter
     def edc(self, edc: int):
+        self.is_dirty = True
         edc_bytes = edc.to_bytes(4, 'little')
         match self.mode:
             case 0:
@@ -323,6 +414,7 @@ class Sector:
     def ecc(self, ecc: bytes | bytearray | memoryview):
         if self.mode != 1 and (self.mode != 2 or self.form != 1):
             raise AttributeError('Cannot set ECC on a mode 0 or mode 2/form 2 sector')
+        self.is_dirty = True
         self._raw[0x81c:self.SIZE] = ecc
 
     @property
@@ -354,7 +446,9 @@ class Sector:
 
     def copy(self, other: Sector):
         """Copy data and attributes from another sector while leaving location intact"""
+        other._flush_edc()
         self._raw[0xf:] = other._raw[0xf:]
+        self.is_dirty = True
         # we don't bother updating error codes for mode 2/form 2 sectors because the EDC doesn't include the part of
         # the sector that was retained from the original sector. this assumes that the EDC of the sector being copied,
         # if present, was already correct.
@@ -431,6 +525,12 @@ class Disc:
         self.data.write(sector.raw)
         self.offset += Sector.SIZE
 
+    def write_sectors(self, sectors: Sequence[Sector]):
+        """Write multiple sectors to the disc, updating any stale EDCs together first"""
+        Sector.update_edcs(sectors)
+        for sector in sectors:
+            self.write_sector(sector)
+
     @property
     def num_sectors(self) -> int:
         """The number of whole sectors in the disc image"""
@@ -1,3 +1,4 @@
+import mmap
 import os
 import re
 
@@ -307,15 +308,63 @@ class PsxCd:
             if next_region is not None:
                 next_region.write_data(destination)
 
+    @property
+    def sectors(self) -> list[Sector]:
+        """All sectors on the CD, in order"""
+        return [sector for region in self.regions for sector in region.sectors]
+
     def write(self, destination: BinaryIO):
         """
         Write the contents of the CD, with any patches applied, to the given stream
 
         :param destination: File-like object to write the CD image to
         """
-        out_disc = Disc(destination)
-        for region in self.regions:
-            region.write(out_disc)
+        Disc(destination).write_sectors(self.sectors)
+
+    def write_to_path(self, path: Path, incremental: bool = False) -> int:
+        """
+        Write the contents of the CD, with any patches applied, to the given file
+
+        Patching never changes the number of sectors on the CD or the order of the sectors, only their contents, so if
+        the file already contains the image this CD was loaded from, only the sectors that have changed need to be
+        written. Otherwise, the whole image is written to a temporary file which then replaces the destination, so the
+        destination isn't lost if the write fails.
+
+        :param path: Path to the CD image to write
+        :param incremental: If True and the file at the path is the same size as this CD, assume it contains the image
+            this CD was loaded from (or last written to with this method) and only write the sectors that have changed
+        :return: The number of sectors written
+        """
+        sectors = self.sectors
+        # do all error code calculations up front so an in-place write touches the file for as short a time as possible
+        Sector.update_edcs(sectors)
+        image_size = len(sectors) * Sector.SIZE
+
+        if incremental and path.exists() and path.stat().st_size == image_size and image_size > 0:
+            num_written = 0
+            with path.open('r+b') as f, mmap.mmap(f.fileno(), image_size) as out:
+                for i, sector in enumerate(sectors):
+                    if sector.is_dirty:
+                        offset = i * Sector.SIZE
+                        out[offset:offset + Sector.SIZE] = sector.raw
+                        num_written += 1
+                out.flush()
+        else:
+            temp_path = path.with_name(path.name + '.tmp')
+            with temp_path.open('w+b') as f:
+                f.truncate(image_size)
+                if image_size > 0:
+                    with mmap.mmap(f.fileno(), image_size) as out:
+                        for i, sector in enumerate(sectors):
+                            offset = i * Sector.SIZE
+                            out[offset:offset + Sector.SIZE] = sector.raw
+                        out.flush()
+            os.replace(temp_path, path)
+            num_written = len(sectors)
+
+        for sector in sectors:
+            sector.is_dirty = False
+        return num_written
 
     def _patch_sort(self, patch: Patch):
         path = patch.path.lower()
@@ -335,8 +384,7 @@ def patch_cd(image_path: Path, cd_path: str, input_path: Path, raw: bool, ignore
         data = f.read()
     patch = Patch(cd_path, data, raw)
     cd.patch([patch])
-    with image_path.open('wb') as f:
-        cd.write(f)
+    cd.write_to_path(image_path, True)
 
 
 def extract_file(cd: PsxCd, output_path: Path, cd_path: str, raw: bool, extend: bool, keep_hierarchy: bool,
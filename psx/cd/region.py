@@ -122,9 +122,9 @@ class CdRegion(ABC):
         for sector in self.sectors:
             data_size = sector.data_size
             chunk_size = min(data_size, data_len - i)
-            # FIXME: re-calculate EDC and ECC
+            # FIXME: re-calculate ECC
             sector.data[:chunk_size] = data[i:i+chunk_size]
-            sector.update_edc()
+            sector.invalidate_edc()
             i += data_size
             if i >= len(data):
                 break
@@ -222,18 +222,18 @@ class CdRegion(ABC):
             bytes_here = len(sector_data) - data_index
             bytes_there = len(data) - bytes_here
             sector_data[data_index:data_index + bytes_here] = data[:bytes_here]
+            sector.invalidate_edc()
             sector = self.sectors[sector_index + 1]
             sector_data = sector.data
             sector_data[:bytes_there] = data[bytes_here:]
         else:
             # field to patch is entirely in this sector
             sector_data[data_index:data_index + len(data)] = data
-        sector.update_edc()
+        sector.invalidate_edc()
 
     def write(self, disc: Disc):
         """Write this region to the provided disc image"""
-        for sector in self.sectors:
-            disc.write_sector(sector)
+        disc.write_sectors(self.sectors)
 
     def write_data(self, destination: BinaryIO):
         """
@@ -0,0 +1,16 @@
+#include <galerians.h>
+
+/*
+ * An example stage library. Room modules linked with examples/stage/STAGEA.LIB.ld can call these after
+ * LoadStageLibrary, for example as a trigger's enabledCallback.
+ */
+
+int32_t IsStateFlagClear(GameState *game, int16_t flag) {
+    return !GetStateFlagInline(game, flag);
+}
+STAGE_EXPORT(IsStateFlagClear);
+
+int32_t IsStateFlagSet(GameState *game, int16_t flag) {
+    return GetStateFlagInline(game, flag);
+}
+STAGE_EXPORT(IsStateFlagSet);
@@ -7,6 +7,17 @@ extern "C" {
 #include <galerians/types.h>
 #include <galerians/globals.h>
 #include <galerians/api.h>
+#include <galerians/flags.h>
+#include <galerians/layout.h>
+#include <galerians/collision.h>
+#include <galerians/vram.h>
+#include <galerians/sched.h>
+#include <galerians/module.h>
+#include <galerians/stagelib.h>
+
+// the remaining headers (arena.h, async.h, prefetch.h, grid.h, dynamic.h, relation.h, anim.h, model.h, mask.h,
+// render.h, profile.h, aibudget.h) define weak storage for their state, so include them directly where they're used
+// rather than paying for them in every module
 
 #ifdef __cplusplus
 }
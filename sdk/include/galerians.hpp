@@ -0,0 +1,341 @@
+#pragma once
+
+/**
+ * Optional C++ layer over the C headers.
+ *
+ * Everything here is a thin inline wrapper around the C types and functions, so it compiles to the same code as the
+ * equivalent C. It only relies on the compiler, not the C++ standard library, and doesn't use exceptions, RTTI, or
+ * static constructors, so it works in a freestanding build with -fno-exceptions -fno-rtti (see `make cxx-check`).
+ * Requires C++17.
+ *
+ * Region differences are available as constants in RegionTraits so that generic code can use `if constexpr` on them
+ * instead of #ifdef, and the RoomLayout arrays can be iterated with range-based for loops through View.
+ */
+
+#if __cplusplus < 201703L
+#error "galerians.hpp requires C++17 or later"
+#endif
+
+// the C headers use designated initializers that only set some fields, which is fine in C but warns in C++ (and before
+// C++20, is an extension). older compilers don't know -Wc++20-extensions, hence -Wpragmas.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#pragma GCC diagnostic ignored "-Wpedantic"
+#pragma GCC diagnostic ignored "-Wc++20-extensions"
+#include <galerians.h>
+#pragma GCC diagnostic pop
+
+namespace galerians {
+
+/**
+ * Versions of the game with different layouts or APIs.
+ */
+enum class Region {
+    Western,    // North America and Europe
+    Japan,
+};
+
+/**
+ * Layout and API differences between regions.
+ */
+template <Region R>
+struct RegionTraits;
+
+template <>
+struct RegionTraits<Region::Western> {
+    static constexpr size_t gameStateSize = 0xAEC;
+    static constexpr size_t apOffset = 0x664;
+    static constexpr size_t stateFlagsOffset = 0x698;
+    static constexpr uint32_t numModuleTypes = 4;
+    static constexpr bool loadModuleTakesAddress = false;
+    static constexpr bool hasAsyncLoading = true;
+    static constexpr int16_t moduleTypeHealth = -1;
+    static constexpr int16_t moduleTypeCredits = 2;
+    static constexpr int16_t moduleTypeSave = 3;
+};
+
+template <>
+struct RegionTraits<Region::Japan> {
+    static constexpr size_t gameStateSize = 0xAE4;
+    static constexpr size_t apOffset = 0x65C;
+    static constexpr size_t stateFlagsOffset = 0x690;
+    static constexpr uint32_t numModuleTypes = 5;
+    static constexpr bool loadModuleTakesAddress = true;
+    static constexpr bool hasAsyncLoading = false;
+    static constexpr int16_t moduleTypeHealth = 2;
+    static constexpr int16_t moduleTypeCredits = 3;
+    static constexpr int16_t moduleTypeSave = 4;
+};
+
+/**
+ * The region being built for, selected by GALERIANS_REGION_JAPAN like the C headers.
+ */
+#ifdef GALERIANS_REGION_JAPAN
+constexpr Region TargetRegion = Region::Japan;
+#else
+constexpr Region TargetRegion = Region::Western;
+#endif
+
+using Target = RegionTraits<TargetRegion>;
+
+static_assert(sizeof(GameState) == Target::gameStateSize, "GameState doesn't match the target region");
+static_assert(offsetof(GameState, ap) == Target::apOffset, "GameState doesn't match the target region");
+static_assert(offsetof(GameState, stateFlags1) == Target::stateFlagsOffset,
+              "GameState doesn't match the target region");
+static_assert(sizeof(ModuleLoadAddresses) / sizeof(ModuleLoadAddresses[0]) == Target::numModuleTypes,
+              "ModuleLoadAddresses doesn't match the target region");
+static_assert(Target::moduleTypeCredits == MODULE_TYPE_CREDITS && Target::moduleTypeSave == MODULE_TYPE_SAVE,
+              "module types don't match the target region");
+
+/**
+ * Load a module at the standard address for its type, like LoadModuleStd. The type is checked at compile time.
+ *
+ * @tparam Type Type of the module to be loaded.
+ * @param index Index in MODULE.BIN of the module to be loaded.
+ */
+template <int16_t Type>
+inline void LoadModule(int16_t index) {
+    static_assert(Type >= 0 && (uint32_t)Type < Target::numModuleTypes, "module type doesn't exist in this region");
+#ifdef GALERIANS_REGION_JAPAN
+    ::LoadModule(Type, index, ModuleLoadAddresses[Type]);
+#else
+    ::LoadModule(Type, index);
+#endif
+}
+
+/**
+ * A pointer and length, for iterating over the used part of a fixed-size array like those in RoomLayout.
+ *
+ * This has the same interface as std::array (other than the size being known at run time) but doesn't own the elements.
+ */
+template <typename T>
+class View {
+public:
+    using value_type = T;
+    using size_type = uint32_t;
+    using iterator = T *;
+    using reference = T &;
+
+    constexpr View() : data_(nullptr), size_(0) {}
+    constexpr View(T *data, uint32_t size) : data_(data), size_(size) {}
+    template <size_t N>
+    constexpr View(T (&array)[N]) : data_(array), size_(N) {}
+
+    constexpr T *begin() const { return data_; }
+    constexpr T *end() const { return data_ + size_; }
+    constexpr T *data() const { return data_; }
+    constexpr uint32_t size() const { return size_; }
+    constexpr bool empty() const { return size_ == 0; }
+    constexpr T &operator[](uint32_t i) const { return data_[i]; }
+    constexpr T &front() const { return data_[0]; }
+    constexpr T &back() const { return data_[size_ - 1]; }
+
+    /**
+     * Get the first count elements, or all of them if there are fewer.
+     */
+    constexpr View first(uint32_t count) const { return View(data_, count < size_ ? count : size_); }
+
+private:
+    T *data_;
+    uint32_t size_;
+};
+
+namespace detail {
+
+template <typename From, typename To>
+struct CopyConst {
+    using Type = To;
+};
+
+template <typename From, typename To>
+struct CopyConst<const From, To> {
+    using Type = const To;
+};
+
+// number of elements a layout field can hold: the array length for RoomLayout, unlimited for CompactRoomLayout
+template <typename T>
+struct Capacity {
+    static constexpr uint32_t value = 0xFFFFFFFF;
+};
+
+template <typename T, size_t N>
+struct Capacity<T[N]> {
+    static constexpr uint32_t value = N;
+};
+
+constexpr uint32_t Min(uint32_t a, uint32_t b) {
+    return a < b ? a : b;
+}
+
+}
+
+/**
+ * Views over the used entries of a room layout's arrays. These work with both RoomLayout and CompactRoomLayout, and are
+ * const if the layout is. Counts larger than a RoomLayout array are clamped to the array's size.
+ */
+template <typename Layout>
+constexpr View<typename detail::CopyConst<Layout, Collider>::Type> Colliders(Layout &layout) {
+    return {layout.colliders, detail::Min(layout.numColliders, detail::Capacity<decltype(layout.colliders)>::value)};
+}
+
+template <typename Layout>
+constexpr View<typename detail::CopyConst<Layout, Camera>::Type> Cameras(Layout &layout) {
+    return {layout.cameras, detail::Min(layout.numCameras, detail::Capacity<decltype(layout.cameras)>::value)};
+}
+
+template <typename Layout>
+constexpr View<typename detail::CopyConst<Layout, Interactable>::Type> Interactables(Layout &layout) {
+    return {layout.interactables,
+            detail::Min(layout.numInteractables, detail::Capacity<decltype(layout.interactables)>::value)};
+}
+
+/**
+ * View over a layout's camera cuts, up to but not including the entry with a negative marker.
+ */
+template <typename Layout>
+constexpr View<typename detail::CopyConst<Layout, CameraCut>::Type> CameraCuts(Layout &layout) {
+    uint32_t count = 0;
+
+    while (count < detail::Capacity<decltype(layout.cuts)>::value && layout.cuts[count].marker >= 0)
+        count++;
+    return {layout.cuts, count};
+}
+
+/**
+ * View over the actors in the current room. Actors[0] is the player.
+ */
+inline View<Actor> RoomActors() {
+    return View<Actor>(Actors);
+}
+
+/**
+ * The shape type used by each collider type.
+ */
+template <uint32_t ColliderType>
+struct ColliderShape;
+
+template <>
+struct ColliderShape<COLLIDER_WALL> {
+    using Type = RectangleCollider;
+};
+
+template <>
+struct ColliderShape<COLLIDER_RECT> {
+    using Type = RectangleCollider;
+};
+
+template <>
+struct ColliderShape<COLLIDER_TRI> {
+    using Type = TriangleCollider;
+};
+
+template <>
+struct ColliderShape<COLLIDER_CIRCLE> {
+    using Type = CircleCollider;
+};
+
+/**
+ * Get a collider's shape as the type for the given collider type. The caller is responsible for checking the type.
+ */
+template <uint32_t ColliderType>
+constexpr typename ColliderShape<ColliderType>::Type *ShapeOf(const Collider &collider) {
+    return static_cast<typename ColliderShape<ColliderType>::Type *>(collider.shape);
+}
+
+/**
+ * Call a function with a collider's shape as the correct type.
+ *
+ * The function is typically a generic lambda, so the code for each shape is generated from one definition:
+ *
+ *     int32_t x = VisitCollider(collider, [](const auto &shape) { return ShapeX(shape); });
+ *
+ * @param collider The collider.
+ * @param visit Function taking a RectangleCollider &, TriangleCollider &, or CircleCollider &. The return type must be
+ *              the same for every shape.
+ * @return The function's return value.
+ */
+template <typename F>
+constexpr auto VisitCollider(const Collider &collider, F &&visit)
+        -> decltype(visit(*static_cast<RectangleCollider *>(nullptr))) {
+    switch (collider.type) {
+        case COLLIDER_TRI:
+            return visit(*ShapeOf<COLLIDER_TRI>(collider));
+        case COLLIDER_CIRCLE:
+            return visit(*ShapeOf<COLLIDER_CIRCLE>(collider));
+        default:
+            return visit(*ShapeOf<COLLIDER_RECT>(collider));
+    }
+}
+
+/**
+ * Access to a field of GameState, Actor, or any other struct by member pointer.
+ *
+ * Lets generic code take the field to work on as a template argument, e.g. a routine that counts down any of an actor's
+ * timers can be written once as `template <auto Timer> ...` and instantiated with `&Actor::timer1`. The member pointer
+ * is a constant, so each instantiation is a plain load or store at a fixed offset.
+ */
+template <auto Member>
+struct Field;
+
+template <typename C, typename T, T C::*Member>
+struct Field<Member> {
+    using Owner = C;
+    using Type = T;
+
+    static constexpr T &Get(C &object) { return object.*Member; }
+    static constexpr const T &Get(const C &object) { return object.*Member; }
+};
+
+template <auto Member>
+constexpr typename Field<Member>::Type &Get(typename Field<Member>::Owner &object) {
+    return Field<Member>::Get(object);
+}
+
+template <auto Member>
+constexpr const typename Field<Member>::Type &Get(const typename Field<Member>::Owner &object) {
+    return Field<Member>::Get(object);
+}
+
+template <auto Member>
+constexpr void Set(typename Field<Member>::Owner &object, const typename Field<Member>::Type &value) {
+    Field<Member>::Get(object) = value;
+}
+
+/**
+ * A state flag whose index is known at compile time. Out-of-range flags are a compile error, and the word and bit are
+ * constants, so each access is a single load and mask like the flags.h functions with a constant argument.
+ */
+template <uint16_t Flag>
+struct StateFlag {
+    static_assert(Flag < MAX_STATE_FLAGS, "state flag out of range");
+
+    static constexpr uint32_t half = Flag % STATE_FLAGS_PER_WORD / 32;
+    static constexpr uint32_t mask = (uint32_t)1 << (Flag % 32);
+
+    /**
+     * Get the flag for the given stage. Stages that are out of range are always false.
+     */
+    static bool Get(GameState &game, uint32_t stage) {
+        return stage < NUM_STAGES && (GetStateFlagWord(&game, Flag, stage)[half] & mask) != 0;
+    }
+
+    static void Set(GameState &game, uint32_t stage) {
+        if (stage < NUM_STAGES)
+            GetStateFlagWord(&game, Flag, stage)[half] |= mask;
+    }
+
+    static void Clear(GameState &game, uint32_t stage) {
+        if (stage < NUM_STAGES)
+            GetStateFlagWord(&game, Flag, stage)[half] &= ~mask;
+    }
+
+    /**
+     * Get, set, or clear the flag for the current stage.
+     */
+    static bool Get(GameState &game) { return Get(game, game.stageId); }
+    static void Set(GameState &game) { Set(game, game.stageId); }
+    static void Clear(GameState &game) { Clear(game, game.stageId); }
+};
+
+}
@@ -0,0 +1,276 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+#include <galerians/api.h>
+#include <galerians/profile.h>
+
+/**
+ * Per-actor cycle budget meter for AI routines.
+ *
+ * SetActorAiRoutineBudgeted installs AiBudgetDispatch as an actor's AI routine and remembers the real routine in a
+ * small table. Each time the engine runs the actor's AI, the dispatcher times the real routine with root counter 2 and
+ * keeps a rolling average and maximum for the actor as a whole and for each aiState it's been in. Unlike profile.h,
+ * this is always enabled and only costs two counter reads and a few adds per actor per frame, so it can be left on to
+ * find which actors and states are responsible for slowdowns. The table starts with a signature so it can be found in
+ * a RAM dump, and `python -m galsdk.profiler --ai <dump>` will print it; on-screen debug text can read it with
+ * AiBudgetGetAverageCycles.
+ *
+ * If a frame budget is set with AiBudgetInit, states whose average cost is more than their share of the budget are
+ * skipped (the routine isn't called and its previous return value is returned again) on frames where running them would
+ * go over. An actor is never skipped two frames in a row, so a throttled actor still runs at least every other frame.
+ *
+ * Times use the same counter setup as profile.h (system clock / 8), so both can be used together.
+ */
+
+#define AI_BUDGET_MAGIC     0x42494147  // "GAIB"
+#define AI_BUDGET_VERSION   1
+#define AI_BUDGET_ACTORS    4
+
+/**
+ * Number of different aiStates tracked for each actor. When an actor enters a new state and all the slots are in use,
+ * the least recently used one is replaced. Define this before including the header to change it.
+ */
+#ifndef AI_BUDGET_STATES
+#define AI_BUDGET_STATES    6
+#endif
+
+/**
+ * Rolling averages move 1/2^AI_BUDGET_AVERAGE_SHIFT of the way towards each new sample.
+ */
+#define AI_BUDGET_AVERAGE_SHIFT 3
+
+/**
+ * Timing for one of an actor's aiStates.
+ */
+typedef struct _AiBudgetStateStats {
+    uint16_t state;         // 00
+    uint16_t count;         // 02 number of samples, saturating; 0 if the slot is unused
+    uint16_t avgTicks;      // 04
+    uint16_t maxTicks;      // 06
+    uint16_t lastFrame;     // 08
+    uint16_t pad0A;         // 0A
+} AiBudgetStateStats;
+_Static_assert(sizeof(AiBudgetStateStats) == 0x0C, "sizeof(AiBudgetStateStats) not correct");
+
+/**
+ * Timing for one actor.
+ */
+typedef struct _AiBudgetActor {
+    AiRoutine routine;                              // 00 the routine being timed
+    int32_t lastResult;                             // 04 return value of the last call, reused when skipped
+    uint16_t lastTicks;                             // 08
+    uint16_t avgTicks;                              // 0A
+    uint16_t maxTicks;                              // 0C
+    uint16_t skippedFrames;                         // 0E total frames skipped by throttling
+    uint16_t lastSkipFrame;                         // 10
+    uint16_t count;                                 // 12 number of samples, saturating
+    AiBudgetStateStats states[AI_BUDGET_STATES];    // 14
+} AiBudgetActor;
+
+/**
+ * Budget meter for all actors.
+ *
+ * This layout is parsed by galsdk/profiler.py, so the two must be kept in sync.
+ */
+typedef struct _AiBudgetTable {
+    uint32_t magic;                         // 00
+    uint16_t version;                       // 04
+    uint8_t numActors;                      // 06
+    uint8_t numStates;                      // 07
+    uint16_t frame;                         // 08 frame that frameTicks is for
+    uint16_t frameTicks;                    // 0A total AI time so far this frame
+    uint16_t budgetTicks;                   // 0C 0 = no throttling
+    uint16_t pad0E;                         // 0E
+    AiBudgetActor actors[AI_BUDGET_ACTORS]; // 10
+} AiBudgetTable;
+
+/**
+ * The budget table. This is weak so that each source file including this header shares the same table.
+ */
+__attribute__((weak)) AiBudgetTable AiBudget = {
+    .magic = AI_BUDGET_MAGIC,
+    .version = AI_BUDGET_VERSION,
+    .numActors = AI_BUDGET_ACTORS,
+    .numStates = AI_BUDGET_STATES,
+};
+
+/**
+ * Configure root counter 2 for timing and set the AI frame budget.
+ *
+ * Call this once when the module starts. Don't use the budget meter if something else in the game depends on root
+ * counter 2.
+ *
+ * @param budgetCycles Number of CPU cycles all AI routines together may use per frame before expensive states are
+ *                     throttled, or 0 to only measure.
+ */
+static inline void AiBudgetInit(uint32_t budgetCycles) {
+    uint32_t ticks = budgetCycles / PROFILE_CYCLES_PER_TICK;
+
+    PROFILE_COUNTER_MODE = PROFILE_COUNTER_SYSCLOCK_8;
+    AiBudget.budgetTicks = ticks > 0xFFFF ? 0xFFFF : (uint16_t)ticks;
+}
+
+/**
+ * Get the timing for an aiState, claiming a slot for it if it doesn't have one yet.
+ */
+static inline AiBudgetStateStats *AiBudgetGetState(AiBudgetActor *entry, uint16_t state) {
+    AiBudgetStateStats *oldest = &entry->states[0];
+    uint32_t i;
+
+    for (i = 0; i < AI_BUDGET_STATES; i++) {
+        AiBudgetStateStats *stats = &entry->states[i];
+        if (stats->count == 0) {
+            oldest = stats;
+            break;
+        }
+        if (stats->state == state)
+            return stats;
+        if ((uint16_t)(FrameCount - stats->lastFrame) > (uint16_t)(FrameCount - oldest->lastFrame))
+            oldest = stats;
+    }
+
+    oldest->state = state;
+    oldest->count = 0;
+    oldest->avgTicks = 0;
+    oldest->maxTicks = 0;
+    return oldest;
+}
+
+/**
+ * Add a sample to a rolling average. The first sample is taken as-is.
+ */
+static inline uint16_t AiBudgetAverage(uint16_t average, uint16_t ticks, uint16_t count) {
+    if (count == 0)
+        return ticks;
+    return (uint16_t)(average + (((int32_t)ticks - (int32_t)average) >> AI_BUDGET_AVERAGE_SHIFT));
+}
+
+/**
+ * Decide whether to skip an actor's AI this frame.
+ */
+static inline int32_t AiBudgetShouldSkip(const AiBudgetActor *entry, const AiBudgetStateStats *stats) {
+    uint32_t budget = AiBudget.budgetTicks;
+
+    if (budget == 0 || stats->count == 0 || (uint16_t)(FrameCount - entry->lastSkipFrame) < 2)
+        return 0;
+    // only states that cost more than their fair share are considered expensive
+    if (stats->avgTicks <= budget / AI_BUDGET_ACTORS)
+        return 0;
+    return AiBudget.frameTicks + stats->avgTicks > budget;
+}
+
+/**
+ * AI routine that runs and times the actor's real routine. Don't install this directly; use SetActorAiRoutineBudgeted.
+ *
+ * This is weak rather than static so that every source file installs the same function.
+ */
+__attribute__((weak)) int32_t AiBudgetDispatch(GameState *game, Actor *actor) {
+    int32_t slot = (int32_t)(actor - Actors);
+    AiBudgetActor *entry;
+    AiBudgetStateStats *stats;
+    uint16_t start, ticks;
+
+    if (slot < 0 || slot >= AI_BUDGET_ACTORS || AiBudget.actors[slot].routine == NULL)
+        return 0;
+    entry = &AiBudget.actors[slot];
+
+    if (AiBudget.frame != FrameCount) {
+        AiBudget.frame = FrameCount;
+        AiBudget.frameTicks = 0;
+    }
+
+    stats = AiBudgetGetState(entry, actor->aiState);
+    stats->lastFrame = FrameCount;
+    if (AiBudgetShouldSkip(entry, stats)) {
+        entry->lastSkipFrame = FrameCount;
+        if (entry->skippedFrames < 0xFFFF)
+            entry->skippedFrames++;
+        return entry->lastResult;
+    }
+
+    start = (uint16_t)PROFILE_COUNTER_VALUE;
+    entry->lastResult = entry->routine(game, actor);
+    ticks = (uint16_t)((uint16_t)PROFILE_COUNTER_VALUE - start);
+
+    entry->lastTicks = ticks;
+    entry->avgTicks = AiBudgetAverage(entry->avgTicks, ticks, entry->count);
+    if (entry->count < 0xFFFF)
+        entry->count++;
+    if (ticks > entry->maxTicks)
+        entry->maxTicks = ticks;
+
+    stats->avgTicks = AiBudgetAverage(stats->avgTicks, ticks, stats->count);
+    if (ticks > stats->maxTicks)
+        stats->maxTicks = ticks;
+    if (stats->count < 0xFFFF)
+        stats->count++;
+
+    AiBudget.frameTicks = AiBudget.frameTicks + ticks < 0xFFFF ? (uint16_t)(AiBudget.frameTicks + ticks) : 0xFFFF;
+    return entry->lastResult;
+}
+
+/**
+ * Set an actor's AI routine, timing it with the budget meter.
+ *
+ * Changing the routine resets the actor's timing. Passing NULL disables the actor's AI as with SetActorAiRoutine.
+ *
+ * @param actor One of the actors in Actors.
+ * @param aiRoutine The AI routine, or NULL.
+ */
+static inline void SetActorAiRoutineBudgeted(Actor *actor, AiRoutine aiRoutine) {
+    int32_t slot = (int32_t)(actor - Actors);
+    AiBudgetActor *entry;
+    uint32_t i;
+
+    if (slot < 0 || slot >= AI_BUDGET_ACTORS || aiRoutine == NULL || aiRoutine == AiBudgetDispatch) {
+        SetActorAiRoutine(actor, aiRoutine);
+        return;
+    }
+
+    entry = &AiBudget.actors[slot];
+    if (entry->routine != aiRoutine) {
+        entry->routine = aiRoutine;
+        entry->lastResult = 0;
+        entry->lastTicks = entry->avgTicks = entry->maxTicks = entry->count = 0;
+        entry->skippedFrames = 0;
+        entry->lastSkipFrame = (uint16_t)(FrameCount - 2);
+        for (i = 0; i < AI_BUDGET_STATES; i++)
+            entry->states[i].count = 0;
+    }
+    SetActorAiRoutine(actor, AiBudgetDispatch);
+}
+
+/**
+ * Start timing the routines the engine has already given each actor, e.g. after SetupActors or LoadAiModule.
+ */
+static inline void WrapActorAiRoutines(void) {
+    int32_t i;
+
+    for (i = 0; i < AI_BUDGET_ACTORS; i++) {
+        if (Actors[i].aiRoutine != NULL && Actors[i].aiRoutine != AiBudgetDispatch)
+            SetActorAiRoutineBudgeted(&Actors[i], Actors[i].aiRoutine);
+    }
+}
+
+/**
+ * Get the rolling average time an actor's AI routine takes, for debug display.
+ *
+ * @param actorIndex Index of the actor in Actors.
+ * @return The average in CPU cycles, or 0 if the actor isn't being timed.
+ */
+static inline uint32_t AiBudgetGetAverageCycles(int32_t actorIndex) {
+    if (actorIndex < 0 || actorIndex >= AI_BUDGET_ACTORS)
+        return 0;
+    return (uint32_t)AiBudget.actors[actorIndex].avgTicks * PROFILE_CYCLES_PER_TICK;
+}
+
+#ifdef __cplusplus
+}
+#endif
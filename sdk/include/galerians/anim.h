@@ -0,0 +1,263 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+#include <galerians/arena.h>
+#include <galerians/relation.h>
+
+/**
+ * Maximum number of frames in an animation.
+ */
+#define ANIM_MAX_FRAMES 100
+
+/**
+ * All of the segment hit flags. ANIM_FLIP_HIT_SEGMENTS only changes which segments the other flags refer to, so it's
+ * not included.
+ */
+#define ANIM_HIT_SEGMENTS 0x0000FFFE
+
+/**
+ * Frame number used in an AnimationIndex when there's no such frame in the rest of the animation.
+ */
+#define ANIM_NO_FRAME 0xFF
+
+/**
+ * Precomputed lookups for the frame flags in an animation.
+ *
+ * Each entry is indexed by frame number and gives the first frame at or after that frame with the given property, so
+ * questions like "how many frames until this attack hits" don't need to walk the animation's frames. The index assumes
+ * the animation plays forward from frame 0 to the ANIM_END frame.
+ */
+typedef struct _AnimationIndex {
+    const AnimationFrame *frames;                   // 00 animation the index was built from
+    int16_t animationId;                            // 04 animation ID the index was built for, if from an actor
+    uint8_t numFrames;                              // 06 number of frames, including the ANIM_END frame
+    uint8_t firstHitFrame;                          // 07 same as nextHitFrame[0]
+    uint8_t nextHitFrame[ANIM_MAX_FRAMES];          // 08 next frame with any segment hit flag set
+    uint8_t nextFaceTargetFrame[ANIM_MAX_FRAMES];   // 6C next frame with ANIM_FACE_TARGET set
+    uint8_t faceTargetEndFrame[ANIM_MAX_FRAMES];    // D0 next frame WITHOUT ANIM_FACE_TARGET set, or numFrames
+} AnimationIndex;
+_Static_assert(sizeof(AnimationIndex) == 0x134, "sizeof(AnimationIndex) not correct");
+
+/**
+ * Build an index of an animation's frames.
+ *
+ * This makes a single pass over the animation, so it's cheap enough to do whenever an animation is loaded, but not
+ * something to do every frame.
+ *
+ * @param index Index to fill in.
+ * @param frames First frame of the animation.
+ */
+static inline void BuildAnimationIndex(AnimationIndex *index, const AnimationFrame *frames) {
+    int32_t numFrames = ANIM_MAX_FRAMES;
+    uint8_t nextHit = ANIM_NO_FRAME, nextFaceTarget = ANIM_NO_FRAME, faceTargetEnd;
+
+    for (int32_t i = 0; i < ANIM_MAX_FRAMES; i++) {
+        if (frames[i].flags & ANIM_END) {
+            numFrames = i + 1;
+            break;
+        }
+    }
+
+    index->frames = frames;
+    index->animationId = -1;
+    index->numFrames = (uint8_t)numFrames;
+    faceTargetEnd = (uint8_t)numFrames;
+
+    // walk backwards so each frame can take its answer from the frame after it
+    for (int32_t i = numFrames - 1; i >= 0; i--) {
+        uint32_t flags = frames[i].flags;
+
+        if (flags & ANIM_HIT_SEGMENTS)
+            nextHit = (uint8_t)i;
+        if (flags & ANIM_FACE_TARGET) {
+            nextFaceTarget = (uint8_t)i;
+        } else {
+            faceTargetEnd = (uint8_t)i;
+        }
+
+        index->nextHitFrame[i] = nextHit;
+        index->nextFaceTargetFrame[i] = nextFaceTarget;
+        index->faceTargetEndFrame[i] = faceTargetEnd;
+    }
+
+    for (int32_t i = numFrames; i < ANIM_MAX_FRAMES; i++) {
+        index->nextHitFrame[i] = ANIM_NO_FRAME;
+        index->nextFaceTargetFrame[i] = ANIM_NO_FRAME;
+        index->faceTargetEndFrame[i] = (uint8_t)numFrames;
+    }
+
+    index->firstHitFrame = index->nextHitFrame[0];
+}
+
+/**
+ * Allocate an animation index from the room arena and build it.
+ *
+ * @param frames First frame of the animation.
+ * @return The index, or NULL if there isn't enough free space in the room arena.
+ */
+static inline AnimationIndex *CreateAnimationIndex(const AnimationFrame *frames) {
+    AnimationIndex *index = (AnimationIndex *)RoomAlloc(sizeof(AnimationIndex));
+    if (index != NULL)
+        BuildAnimationIndex(index, frames);
+    return index;
+}
+
+/**
+ * Get the number of frames from a frame until the animation's next hit.
+ *
+ * @param index Animation index.
+ * @param frame Current frame number.
+ * @return 0 if the frame itself hits, the number of frames until the next frame that does, or -1 if no later frame in
+ *         the animation hits.
+ */
+static inline int32_t GetFramesUntilHit(const AnimationIndex *index, int32_t frame) {
+    if (frame < 0 || frame >= index->numFrames || index->nextHitFrame[frame] == ANIM_NO_FRAME)
+        return -1;
+    return index->nextHitFrame[frame] - frame;
+}
+
+/**
+ * Get the number of frames from a frame until the animation next faces its target.
+ *
+ * @param index Animation index.
+ * @param frame Current frame number.
+ * @return 0 if the frame itself faces the target, the number of frames until the next frame that does, or -1 if no
+ *         later frame in the animation does.
+ */
+static inline int32_t GetFramesUntilFaceTarget(const AnimationIndex *index, int32_t frame) {
+    if (frame < 0 || frame >= index->numFrames || index->nextFaceTargetFrame[frame] == ANIM_NO_FRAME)
+        return -1;
+    return index->nextFaceTargetFrame[frame] - frame;
+}
+
+/**
+ * Get the number of frames left in the face-target range containing a frame.
+ *
+ * @param index Animation index.
+ * @param frame Current frame number.
+ * @return The number of frames from this one until the first frame that doesn't face the target (or the end of the
+ *         animation), or 0 if this frame doesn't face the target.
+ */
+static inline int32_t GetFaceTargetFramesLeft(const AnimationIndex *index, int32_t frame) {
+    if (frame < 0 || frame >= index->numFrames)
+        return 0;
+    return index->faceTargetEndFrame[frame] - frame;
+}
+
+/**
+ * Get the number of frames from a frame until the end of the animation.
+ *
+ * @param index Animation index.
+ * @param frame Current frame number.
+ * @return The number of frames after this one, or 0 if this is the ANIM_END frame.
+ */
+static inline int32_t GetFramesUntilAnimationEnd(const AnimationIndex *index, int32_t frame) {
+    if (frame < 0 || frame >= index->numFrames)
+        return 0;
+    return index->numFrames - 1 - frame;
+}
+
+/**
+ * Get an actor's current frame number in its current animation.
+ *
+ * @param actor The actor.
+ * @return The frame number, or -1 if the actor doesn't have an animation.
+ */
+static inline int32_t GetActorAnimationFrame(const Actor *actor) {
+    if (actor->animation == NULL || actor->currentAnimFrame == NULL)
+        return -1;
+    return (int32_t)(actor->currentAnimFrame - *actor->animation);
+}
+
+/**
+ * Indexes of the actors' current animations.
+ *
+ * Each actor slot gets one AnimationIndex from the room arena the first time it's needed, which is rebuilt in place
+ * whenever the actor's animation changes, so the cache uses a fixed amount of memory no matter how many animations the
+ * actors play. This is weak so that each source file including this header shares the same cache. Don't access it
+ * directly; use GetActorAnimationIndex.
+ */
+typedef struct _AnimationIndexCache {
+    AnimationIndex *indexes[NUM_ACTORS];
+    uint32_t stageId;
+    uint16_t mapId;
+    uint16_t roomId;
+} AnimationIndexCache;
+
+__attribute__((weak)) AnimationIndexCache ActorAnimationIndexes = { .indexes = { NULL } };
+
+/**
+ * Forget all cached actor animation indexes. This runs automatically when the room arena is reset.
+ */
+static inline void ResetAnimationIndexCache(void) {
+    for (int32_t i = 0; i < NUM_ACTORS; i++)
+        ActorAnimationIndexes.indexes[i] = NULL;
+}
+
+/**
+ * Get the index of an actor's current animation, building it if the animation has changed since the last call.
+ *
+ * The index lives in the room arena, so don't keep the pointer after leaving the room or calling RoomArenaReset. The
+ * cache registers ResetAnimationIndexCache as a room arena reset hook so it doesn't hand out memory that's been reused.
+ *
+ * @param actor One of the actors in Actors.
+ * @return The index, or NULL if the actor doesn't have an animation, isn't in Actors, or there isn't enough free space
+ *         in the room arena or all of its reset hooks are taken.
+ */
+static inline const AnimationIndex *GetActorAnimationIndex(const Actor *actor) {
+    AnimationIndexCache *cache = &ActorAnimationIndexes;
+    int32_t slot = (int32_t)(actor - Actors);
+    AnimationIndex *index;
+
+    if (slot < 0 || slot >= NUM_ACTORS || actor->animation == NULL)
+        return NULL;
+
+    if (cache->stageId != Game.stageId || cache->mapId != Game.mapId || cache->roomId != Game.roomId) {
+        for (int32_t i = 0; i < NUM_ACTORS; i++)
+            cache->indexes[i] = NULL;
+        cache->stageId = Game.stageId;
+        cache->mapId = Game.mapId;
+        cache->roomId = Game.roomId;
+    }
+
+    // an actor's animation buffer may be reused for a different animation, so the ID has to match too
+    index = cache->indexes[slot];
+    if (index == NULL) {
+        if (!AddRoomArenaResetHook(ResetAnimationIndexCache))
+            return NULL;
+        index = (AnimationIndex *)RoomAlloc(sizeof(AnimationIndex));
+        if (index == NULL)
+            return NULL;
+        cache->indexes[slot] = index;
+    } else if (index->frames == *actor->animation && index->animationId == actor->animationId) {
+        return index;
+    }
+
+    BuildAnimationIndex(index, *actor->animation);
+    index->animationId = actor->animationId;
+    return index;
+}
+
+/**
+ * Get the number of frames until an actor's current animation next hits.
+ *
+ * @param actor One of the actors in Actors.
+ * @return 0 if the current frame hits, the number of frames until the next frame that does, or -1 if no later frame in
+ *         the animation hits or the actor doesn't have an animation.
+ */
+static inline int32_t GetActorFramesUntilHit(const Actor *actor) {
+    const AnimationIndex *index = GetActorAnimationIndex(actor);
+    if (index == NULL)
+        return -1;
+    return GetFramesUntilHit(index, GetActorAnimationFrame(actor));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,6 +5,7 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <string.h>
 #include <galerians/types.h>
 #include <galerians/globals.h>
 
@@ -38,6 +39,41 @@ void SetupActors(ActorLayout *layout);
  * @return Pointer to the buffer where the file data was loaded.
  */
 void *LoadFileFromDb(Database *db, uint32_t index, void *buffer);
+#ifndef GALERIANS_REGION_JAPAN
+// the addresses of these functions haven't been identified in the Japanese version yet
+/**
+ * Start loading a file from a database file without waiting for it to complete.
+ *
+ * This is the first half of LoadFileFromDb. Use IsAsyncLoading to check when the load has finished. Only one load can
+ * be in progress at a time.
+ *
+ * @param db The database to load from.
+ * @param index The index of the file in the database to load.
+ * @param buffer Pointer to the buffer to load the file to. Unlike LoadFileFromDb, this should always be provided.
+ * @return Pointer to the buffer the file is being loaded to.
+ */
+void *StartLoadFile(Database *db, uint32_t index, void *buffer);
+/**
+ * Check whether an asynchronous file load is in progress.
+ *
+ * @return Non-zero if a load is still in progress.
+ */
+int32_t IsAsyncLoading();
+/**
+ * Check whether file loads are currently being performed asynchronously.
+ *
+ * @return Non-zero if loads are asynchronous.
+ */
+int32_t GetIsAsyncLoad();
+/**
+ * Check whether the room loading code should load the room's files asynchronously.
+ *
+ * The exact conditions are unknown.
+ *
+ * @return Non-zero if room files should be loaded asynchronously.
+ */
+int32_t ShouldLoadAsync();
+#endif
 /**
  * Get the value (0 or 1) of a state flag for the current stage.
  *
@@ -201,6 +237,13 @@ void SetActorAiRoutine(Actor *actor, AiRoutine aiRoutine);
  * @return Whether the player selected "Yes".
  */
 int16_t PlayerSelectedYes();
+/**
+ * Flush the CPU's instruction cache.
+ *
+ * Call this after loading code into memory yourself (e.g. with LoadFileFromDb) and before calling it, so that
+ * instructions cached from whatever was in that memory before aren't executed.
+ */
+void FlushCache(void);
 
 /**
  * Convenience function for loading a module at the standard address in any region.
@@ -264,6 +307,22 @@ static inline int16_t WaitForMessage(int32_t messageId) {
     return PlayerSelectedYes();
 }
 
+/**
+ * Zero the module's zero-initialized globals.
+ *
+ * When a module is linked with one of the *_gc.ld scripts, zero-initialized data isn't stored in the module file, so
+ * the memory contains whatever was there before the module was loaded. Call this at the very start of the module's
+ * entry point (e.g. the room function), before anything touches a global. With the default linker scripts, this does
+ * nothing.
+ *
+ * The state the SDK headers keep in weak globals (RoomArena, Prefetches, Render, and so on) relies on this. Globals
+ * with an all-zero initializer go in .bss and the rest in .data, and either way they're back to their initial values
+ * every time the module is loaded, but only if a module linked this way calls ClearModuleBss.
+ */
+static inline void ClearModuleBss(void) {
+    memset(ModuleBssStart, 0, (size_t)(ModuleBssEnd - ModuleBssStart));
+}
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,193 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+
+/**
+ * Default alignment of arena allocations. This is the word size, which is enough for any type used by the game.
+ */
+#define ARENA_ALIGNMENT 4
+
+/**
+ * A bump allocator over a fixed block of memory.
+ *
+ * Allocation is just a pointer increment, and there's no way to free individual allocations; the whole arena is freed
+ * at once with ArenaReset.
+ */
+typedef struct _Arena {
+    uint8_t *start;
+    uint8_t *end;
+    uint8_t *next;
+} Arena;
+
+/**
+ * Initialize an arena over a block of memory.
+ *
+ * @param arena Arena to initialize.
+ * @param start Start of the memory to allocate from.
+ * @param size Size of the memory in bytes.
+ */
+static inline void ArenaInit(Arena *arena, void *start, size_t size) {
+    arena->start = (uint8_t *)start;
+    arena->end = arena->start + size;
+    arena->next = arena->start;
+}
+
+/**
+ * Free all allocations in an arena.
+ *
+ * @param arena Arena to reset.
+ */
+static inline void ArenaReset(Arena *arena) {
+    arena->next = arena->start;
+}
+
+/**
+ * Get the number of bytes still available in an arena, ignoring alignment.
+ *
+ * @param arena Arena to check.
+ * @return Number of free bytes.
+ */
+static inline size_t ArenaRemaining(const Arena *arena) {
+    return (size_t)(arena->end - arena->next);
+}
+
+/**
+ * Allocate memory from an arena with a specific alignment.
+ *
+ * The memory is not zeroed.
+ *
+ * @param arena Arena to allocate from.
+ * @param size Number of bytes to allocate.
+ * @param alignment Alignment of the allocation. Must be a power of 2.
+ * @return Pointer to the allocated memory, or NULL if there isn't enough space left in the arena.
+ */
+static inline void *ArenaAllocAligned(Arena *arena, size_t size, size_t alignment) {
+    uintptr_t address = ((uintptr_t)arena->next + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    uint8_t *start = (uint8_t *)address;
+
+    if (start > arena->end || size > (size_t)(arena->end - start))
+        return NULL;
+
+    arena->next = start + size;
+    return start;
+}
+
+/**
+ * Allocate memory from an arena.
+ *
+ * The memory is not zeroed.
+ *
+ * @param arena Arena to allocate from.
+ * @param size Number of bytes to allocate.
+ * @return Pointer to the allocated memory, or NULL if there isn't enough space left in the arena.
+ */
+static inline void *ArenaAlloc(Arena *arena, size_t size) {
+    return ArenaAllocAligned(arena, size, ARENA_ALIGNMENT);
+}
+
+/**
+ * Maximum number of functions that can be registered with AddRoomArenaResetHook.
+ */
+#define ROOM_ARENA_MAX_RESET_HOOKS 4
+
+/**
+ * A function called before the room arena's memory is freed, so anything caching room arena pointers can forget them.
+ */
+typedef void (*RoomArenaResetHook)(void);
+
+/**
+ * State of the room arena.
+ *
+ * The room arena covers the free memory between the end of the module and the end of the module region. This is weak
+ * so that each source file including this header shares the same arena. Like the other SDK headers' state, it's
+ * zero-initialized, so it's reset every time the module is loaded (see ClearModuleBss). Don't access it directly; use
+ * the RoomArena functions.
+ */
+typedef struct _RoomArenaState {
+    Arena arena;
+    uint32_t stageId;
+    uint16_t mapId;
+    uint16_t roomId;
+    RoomArenaResetHook resetHooks[ROOM_ARENA_MAX_RESET_HOOKS];
+} RoomArenaState;
+
+__attribute__((weak)) RoomArenaState RoomArena = { .arena = { NULL, NULL, NULL } };
+
+/**
+ * Get the room arena, resetting it if the player has changed rooms since it was last used.
+ *
+ * The arena is also reset whenever the module is reloaded, so allocations never carry over from one room to the next.
+ * Don't use memory from the room arena after calling GoToRoom or ChangeStage, because the next module will be loaded
+ * over it.
+ *
+ * @return The room arena.
+ */
+static inline Arena *GetRoomArena(void) {
+    if (RoomArena.arena.start == NULL || RoomArena.stageId != Game.stageId || RoomArena.mapId != Game.mapId ||
+        RoomArena.roomId != Game.roomId) {
+        for (int32_t i = 0; i < ROOM_ARENA_MAX_RESET_HOOKS && RoomArena.resetHooks[i] != NULL; i++)
+            RoomArena.resetHooks[i]();
+        ArenaInit(&RoomArena.arena, ModuleEnd, (size_t)(ModuleRegionEnd - ModuleEnd));
+        RoomArena.stageId = Game.stageId;
+        RoomArena.mapId = Game.mapId;
+        RoomArena.roomId = Game.roomId;
+    }
+
+    return &RoomArena.arena;
+}
+
+/**
+ * Allocate memory from the room arena.
+ *
+ * The memory is not zeroed and is freed automatically when leaving the room.
+ *
+ * @param size Number of bytes to allocate.
+ * @return Pointer to the allocated memory, or NULL if there isn't enough free space left in the module region.
+ */
+static inline void *RoomAlloc(size_t size) {
+    return ArenaAlloc(GetRoomArena(), size);
+}
+
+/**
+ * Register a function to be called whenever the room arena is reset.
+ *
+ * Hooks run before the memory is handed out again, both from RoomArenaReset and when GetRoomArena notices the player
+ * has changed rooms. They must not allocate from the room arena. Registrations last until the module is reloaded.
+ *
+ * @param hook Function to call. Registering the same function more than once has no effect.
+ * @return Non-zero if the hook is registered, or 0 if ROOM_ARENA_MAX_RESET_HOOKS hooks are already registered.
+ */
+static inline int32_t AddRoomArenaResetHook(RoomArenaResetHook hook) {
+    for (int32_t i = 0; i < ROOM_ARENA_MAX_RESET_HOOKS; i++) {
+        if (RoomArena.resetHooks[i] == hook)
+            return 1;
+        if (RoomArena.resetHooks[i] == NULL) {
+            RoomArena.resetHooks[i] = hook;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Free all allocations in the room arena, after running the hooks registered with AddRoomArenaResetHook.
+ */
+static inline void RoomArenaReset(void) {
+    Arena *arena = GetRoomArena();
+
+    for (int32_t i = 0; i < ROOM_ARENA_MAX_RESET_HOOKS && RoomArena.resetHooks[i] != NULL; i++)
+        RoomArena.resetHooks[i]();
+    ArenaReset(arena);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,293 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+#include <galerians/api.h>
+
+// StartLoadFile and IsAsyncLoading haven't been identified in the Japanese version yet
+#ifndef GALERIANS_REGION_JAPAN
+
+/**
+ * Maximum number of asynchronous loads that can be queued at once.
+ */
+#define ASYNC_LOAD_QUEUE_SIZE 4
+
+/**
+ * Returned in place of a handle when a load couldn't be queued.
+ */
+#define ASYNC_LOAD_INVALID -1
+
+/**
+ * States of a queued load.
+ */
+#define ASYNC_LOAD_FREE     0
+#define ASYNC_LOAD_QUEUED   1
+#define ASYNC_LOAD_LOADING  2
+#define ASYNC_LOAD_DONE     3
+#define ASYNC_LOAD_CANCELLED 4  // cancelled while loading; freed once the CD finishes with the buffer
+
+/**
+ * Size of a sector in a database file.
+ */
+#define DB_SECTOR_SIZE      2048
+
+/**
+ * Handle to a queued load.
+ */
+typedef int32_t AsyncLoadHandle;
+
+/**
+ * A file load from a database.
+ */
+typedef struct _AsyncLoad {
+    Database *db;
+    uint32_t index;
+    void *buffer;
+    uint32_t state;
+    uint32_t ticket;    // order in which the load was queued
+    uint32_t size;      // size of the file, once the load has started
+} AsyncLoad;
+
+/**
+ * Queue of loads waiting to be started.
+ *
+ * The game can only load one file at a time, so loads are started in the order they were queued as each previous load
+ * completes. This is weak so that each source file including this header shares the same queue.
+ */
+typedef struct _AsyncLoadQueue {
+    AsyncLoad loads[ASYNC_LOAD_QUEUE_SIZE];
+    int32_t active;         // index of the load in progress or -1
+    uint32_t nextTicket;
+} AsyncLoadQueue;
+
+__attribute__((weak)) AsyncLoadQueue AsyncLoads = { .active = -1 };
+
+/**
+ * Get the size of the file a database is loading.
+ *
+ * StartLoadFile looks up the file's sector count and the size of its last sector in the database's directory. Databases
+ * that don't record sizes to the byte leave the last sector size at 0, in which case the whole last sector is counted.
+ *
+ * @param db The database, after StartLoadFile has been called.
+ * @return Size of the file in bytes.
+ */
+static inline uint32_t GetDbLoadSize(const Database *db) {
+    if (db->entryNumSectors == 0)
+        return 0;
+    return (db->entryNumSectors - 1) * DB_SECTOR_SIZE + (db->lastSectorSize ? db->lastSectorSize : DB_SECTOR_SIZE);
+}
+
+/**
+ * Advance the load queue.
+ *
+ * Marks the active load as done if the game has finished loading it and starts the next queued load if the CD is free.
+ * This is called by the other functions in this header, so it's normally not necessary to call it directly, but it can
+ * be called once per frame to keep the queue moving when nothing is waiting on a load.
+ */
+static inline void PumpAsyncLoads(void) {
+    AsyncLoadQueue *queue = &AsyncLoads;
+    int32_t next = -1;
+
+    if (IsAsyncLoading())
+        return;
+
+    if (queue->active >= 0) {
+        AsyncLoad *active = &queue->loads[queue->active];
+        active->state = active->state == ASYNC_LOAD_CANCELLED ? ASYNC_LOAD_FREE : ASYNC_LOAD_DONE;
+        queue->active = -1;
+    }
+
+    for (int32_t i = 0; i < ASYNC_LOAD_QUEUE_SIZE; i++) {
+        AsyncLoad *load = &queue->loads[i];
+        if (load->state == ASYNC_LOAD_QUEUED && (next < 0 || load->ticket < queue->loads[next].ticket))
+            next = i;
+    }
+
+    if (next >= 0) {
+        AsyncLoad *load = &queue->loads[next];
+        load->state = ASYNC_LOAD_LOADING;
+        queue->active = next;
+        StartLoadFile(load->db, load->index, load->buffer);
+        load->size = GetDbLoadSize(load->db);
+    }
+}
+
+/**
+ * Queue a file to be loaded from a database in the background.
+ *
+ * Don't queue loads while the room is changing, because the game will be using the CD for its own loads.
+ *
+ * @param db The database to load from.
+ * @param index The index of the file in the database to load.
+ * @param buffer Pointer to the buffer to load the file to. This must be large enough to hold the whole file and must
+ *               not be touched until the load is complete.
+ * @return Handle to the queued load, or ASYNC_LOAD_INVALID if the queue is full.
+ */
+static inline AsyncLoadHandle QueueAsyncLoad(Database *db, uint32_t index, void *buffer) {
+    AsyncLoadQueue *queue = &AsyncLoads;
+
+    for (int32_t i = 0; i < ASYNC_LOAD_QUEUE_SIZE; i++) {
+        AsyncLoad *load = &queue->loads[i];
+        if (load->state == ASYNC_LOAD_FREE) {
+            load->db = db;
+            load->index = index;
+            load->buffer = buffer;
+            load->state = ASYNC_LOAD_QUEUED;
+            load->ticket = queue->nextTicket++;
+            load->size = 0;
+            PumpAsyncLoads();
+            return i;
+        }
+    }
+
+    return ASYNC_LOAD_INVALID;
+}
+
+/**
+ * Check whether a queued load has completed.
+ *
+ * @param handle Handle of the load to check.
+ * @return Non-zero if the file has been loaded.
+ */
+static inline int32_t IsAsyncLoadDone(AsyncLoadHandle handle) {
+    PumpAsyncLoads();
+    return AsyncLoads.loads[handle].state == ASYNC_LOAD_DONE;
+}
+
+/**
+ * Release a completed load's handle so it can be reused.
+ *
+ * @param handle Handle of the completed load.
+ * @return Pointer to the buffer the file was loaded to.
+ */
+static inline void *FinishAsyncLoad(AsyncLoadHandle handle) {
+    AsyncLoad *load = &AsyncLoads.loads[handle];
+    load->state = ASYNC_LOAD_FREE;
+    return load->buffer;
+}
+
+/**
+ * Cancel a queued load and release its handle.
+ *
+ * A load that hasn't started yet is dropped from the queue. A load that's already in progress can't be stopped, so its
+ * handle is released once the CD has finished reading into the buffer.
+ *
+ * @param handle Handle of the load to cancel.
+ * @return Non-zero if the buffer can be reused immediately, or 0 if the CD is still reading into it. In the latter
+ *         case, wait until IsAsyncLoading returns 0 before reusing the buffer.
+ */
+static inline int32_t CancelAsyncLoad(AsyncLoadHandle handle) {
+    AsyncLoad *load = &AsyncLoads.loads[handle];
+
+    PumpAsyncLoads();
+    if (load->state == ASYNC_LOAD_LOADING) {
+        load->state = ASYNC_LOAD_CANCELLED;
+        return 0;
+    }
+
+    load->state = ASYNC_LOAD_FREE;
+    return 1;
+}
+
+/**
+ * Get the size of a file whose load has completed.
+ *
+ * @param handle Handle of the completed load. It must not have been released with FinishAsyncLoad yet.
+ * @return Size of the file in bytes.
+ */
+static inline uint32_t GetAsyncLoadSize(AsyncLoadHandle handle) {
+    return AsyncLoads.loads[handle].size;
+}
+
+/**
+ * Yield until a queued load completes and release its handle.
+ *
+ * This must only be called from a game task, i.e. the room function or a trigger callback.
+ *
+ * @param handle Handle of the load to wait for.
+ * @return Pointer to the buffer the file was loaded to.
+ */
+static inline void *WaitForAsyncLoad(AsyncLoadHandle handle) {
+    while (!IsAsyncLoadDone(handle))
+        Yield();
+
+    return FinishAsyncLoad(handle);
+}
+
+/**
+ * A pair of buffers for loading the next file while the current one is in use.
+ */
+typedef struct _AsyncDoubleBuffer {
+    void *buffers[2];
+    uint32_t front;
+    AsyncLoadHandle pending;
+} AsyncDoubleBuffer;
+
+/**
+ * Initialize a double buffer.
+ *
+ * @param buffer Double buffer to initialize.
+ * @param first Buffer that will start as the front buffer.
+ * @param second Buffer that will start as the back buffer.
+ */
+static inline void InitAsyncDoubleBuffer(AsyncDoubleBuffer *buffer, void *first, void *second) {
+    buffer->buffers[0] = first;
+    buffer->buffers[1] = second;
+    buffer->front = 0;
+    buffer->pending = ASYNC_LOAD_INVALID;
+}
+
+/**
+ * Get the front buffer, i.e. the one holding the most recently completed load.
+ *
+ * @param buffer Double buffer.
+ * @return The front buffer.
+ */
+static inline void *GetAsyncFrontBuffer(AsyncDoubleBuffer *buffer) {
+    return buffer->buffers[buffer->front];
+}
+
+/**
+ * Start loading a file into the back buffer.
+ *
+ * @param buffer Double buffer.
+ * @param db The database to load from.
+ * @param index The index of the file in the database to load.
+ * @return Non-zero if the load was queued. Fails if a previous load into the back buffer hasn't been swapped in yet or
+ *         the load queue is full.
+ */
+static inline int32_t LoadAsyncBackBuffer(AsyncDoubleBuffer *buffer, Database *db, uint32_t index) {
+    if (buffer->pending != ASYNC_LOAD_INVALID)
+        return 0;
+
+    buffer->pending = QueueAsyncLoad(db, index, buffer->buffers[buffer->front ^ 1]);
+    return buffer->pending != ASYNC_LOAD_INVALID;
+}
+
+/**
+ * Swap the buffers if the load into the back buffer has completed.
+ *
+ * @param buffer Double buffer.
+ * @return Non-zero if the buffers were swapped, in which case the newly loaded file is now in the front buffer.
+ */
+static inline int32_t SwapAsyncBuffers(AsyncDoubleBuffer *buffer) {
+    if (buffer->pending == ASYNC_LOAD_INVALID || !IsAsyncLoadDone(buffer->pending))
+        return 0;
+
+    FinishAsyncLoad(buffer->pending);
+    buffer->pending = ASYNC_LOAD_INVALID;
+    buffer->front ^= 1;
+    return 1;
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,422 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <galerians/types.h>
+
+/**
+ * Collision queries against the room's colliders.
+ *
+ * All math is done in 32-bit integers, apart from one comparison of squared distances that's done in 64 bits to avoid a
+ * square root. Coordinates are first made relative to the start of the query and, if the query spans more than
+ * COLLISION_MAX_COORD units, scaled down until they fit, so none of the products can overflow.
+ * Cross products are calculated with the GTE's NCLIP command. Define GALERIANS_NO_GTE before including this header
+ * to calculate them on the CPU instead (e.g. for testing the code on a PC).
+ */
+
+/**
+ * Largest coordinate magnitude used in calculations. Keeping coordinates below this means differences between them
+ * fit in 15 bits, and the products of two differences fit in 31 bits.
+ */
+#define COLLISION_MAX_COORD 8191
+
+/**
+ * A 2D point on the floor plane.
+ */
+typedef struct _CollisionPoint {
+    int32_t x;
+    int32_t z;
+} CollisionPoint;
+
+/**
+ * Coordinate frame for a collision query.
+ */
+typedef struct _CollisionFrame {
+    int32_t originX;
+    int32_t originZ;
+    uint32_t shift;
+} CollisionFrame;
+
+/**
+ * Calculate the 2D cross product ax * bz - az * bx.
+ *
+ * All inputs must have a magnitude of at most 2 * COLLISION_MAX_COORD.
+ */
+static inline int32_t CollisionCross(int32_t ax, int32_t az, int32_t bx, int32_t bz) {
+#ifdef GALERIANS_NO_GTE
+    return ax * bz - az * bx;
+#else
+    int32_t result;
+
+    // NCLIP calculates the cross product of (SXY1 - SXY0) and (SXY2 - SXY0). with SXY0 at the origin, that's just the
+    // cross product of SXY1 and SXY2.
+    __asm__ volatile (
+        "mtc2 $zero, $12\n"
+        "mtc2 %1, $13\n"
+        "mtc2 %2, $14\n"
+        "nop\n"
+        "nop\n"
+        "cop2 0x1400006\n"
+        "mfc2 %0, $24\n"
+        "nop\n"
+        : "=r"(result)
+        : "r"(((uint32_t)az << 16) | ((uint32_t)ax & 0xffff)), "r"(((uint32_t)bz << 16) | ((uint32_t)bx & 0xffff))
+    );
+
+    return result;
+#endif
+}
+
+/**
+ * Get the orientation of point c relative to the line from a to b.
+ *
+ * @return Positive if c is on one side, negative if it's on the other, or 0 if the points are collinear.
+ */
+static inline int32_t CollisionOrient(const CollisionPoint *a, const CollisionPoint *b, const CollisionPoint *c) {
+    return CollisionCross(b->x - a->x, b->z - a->z, c->x - a->x, c->z - a->z);
+}
+
+static inline int32_t CollisionAbs(int32_t value) {
+    return value < 0 ? -value : value;
+}
+
+/**
+ * Start a collision frame centered on a point.
+ *
+ * @param frame Frame to initialize.
+ * @param x X coordinate of the frame origin.
+ * @param z Z coordinate of the frame origin.
+ */
+static inline void CollisionFrameInit(CollisionFrame *frame, int32_t x, int32_t z) {
+    frame->originX = x;
+    frame->originZ = z;
+    frame->shift = 0;
+}
+
+/**
+ * Scale the frame down if necessary to fit a point that will be used in the query.
+ *
+ * All points must be added to the frame before any are converted with CollisionToFrame.
+ */
+static inline void CollisionFrameFit(CollisionFrame *frame, int32_t x, int32_t z) {
+    int32_t dx = CollisionAbs(x - frame->originX);
+    int32_t dz = CollisionAbs(z - frame->originZ);
+    int32_t extent = dx > dz ? dx : dz;
+
+    while ((extent >> frame->shift) > COLLISION_MAX_COORD)
+        frame->shift++;
+}
+
+/**
+ * Scale the frame down if necessary to fit a distance that will be used in the query.
+ */
+static inline void CollisionFrameFitDistance(CollisionFrame *frame, int32_t distance) {
+    while ((distance >> frame->shift) > COLLISION_MAX_COORD)
+        frame->shift++;
+}
+
+static inline CollisionPoint CollisionToFrame(const CollisionFrame *frame, int32_t x, int32_t z) {
+    CollisionPoint point = { (x - frame->originX) >> frame->shift, (z - frame->originZ) >> frame->shift };
+    return point;
+}
+
+static inline int32_t CollisionDistanceToFrame(const CollisionFrame *frame, int32_t distance) {
+    // round up so scaling never makes a query miss
+    return (distance + (1 << frame->shift) - 1) >> frame->shift;
+}
+
+/**
+ * Check whether point p is on segment ab, given that the three points are collinear.
+ */
+static inline int32_t CollisionOnSegment(const CollisionPoint *a, const CollisionPoint *b, const CollisionPoint *p) {
+    return (p->x >= (a->x < b->x ? a->x : b->x)) && (p->x <= (a->x > b->x ? a->x : b->x))
+        && (p->z >= (a->z < b->z ? a->z : b->z)) && (p->z <= (a->z > b->z ? a->z : b->z));
+}
+
+/**
+ * Check whether segments p1p2 and q1q2 intersect, including touching.
+ */
+static inline int32_t CollisionSegmentsIntersect(const CollisionPoint *p1, const CollisionPoint *p2,
+                                                 const CollisionPoint *q1, const CollisionPoint *q2) {
+    int32_t d1 = CollisionOrient(q1, q2, p1);
+    int32_t d2 = CollisionOrient(q1, q2, p2);
+    int32_t d3 = CollisionOrient(p1, p2, q1);
+    int32_t d4 = CollisionOrient(p1, p2, q2);
+
+    if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0)))
+        return 1;
+
+    return (d1 == 0 && CollisionOnSegment(q1, q2, p1)) || (d2 == 0 && CollisionOnSegment(q1, q2, p2))
+        || (d3 == 0 && CollisionOnSegment(p1, p2, q1)) || (d4 == 0 && CollisionOnSegment(p1, p2, q2));
+}
+
+/**
+ * Check whether point p is within a distance of segment ab.
+ */
+static inline int32_t CollisionPointNearSegment(const CollisionPoint *p, const CollisionPoint *a,
+                                                const CollisionPoint *b, int32_t distance) {
+    int32_t dx = b->x - a->x, dz = b->z - a->z;
+    int32_t fx = p->x - a->x, fz = p->z - a->z;
+    int32_t dot = fx * dx + fz * dz;
+    int32_t length2 = dx * dx + dz * dz;
+    int32_t cross;
+
+    if (dot <= 0)
+        return fx * fx + fz * fz <= distance * distance;
+
+    if (dot >= length2) {
+        int32_t gx = p->x - b->x, gz = p->z - b->z;
+        return gx * gx + gz * gz <= distance * distance;
+    }
+
+    // the distance to the line is |cross| / |d|. compare the squares instead of taking a square root; cross^2 is up to 58
+    // bits and distance^2 * |d|^2 up to 55, so they fit in 64 bits.
+    cross = CollisionCross(dx, dz, fx, fz);
+    return (int64_t)cross * cross <= (int64_t)(distance * distance) * length2;
+}
+
+/**
+ * Check whether a point is inside a convex polygon, including its edges. Vertices may be in either winding order.
+ */
+static inline int32_t CollisionPointInPolygon(const CollisionPoint *p, const CollisionPoint *vertices,
+                                              uint32_t numVertices) {
+    int32_t positive = 0, negative = 0;
+
+    for (uint32_t i = 0; i < numVertices; i++) {
+        int32_t side = CollisionOrient(&vertices[i], &vertices[i + 1 < numVertices ? i + 1 : 0], p);
+        if (side > 0)
+            positive = 1;
+        else if (side < 0)
+            negative = 1;
+    }
+
+    return !(positive && negative);
+}
+
+/**
+ * Check whether a circle moving along a segment touches the edges of a convex polygon.
+ *
+ * A distance of 0 checks whether the segment itself crosses an edge.
+ */
+static inline int32_t CollisionSweepHitsEdges(const CollisionPoint *start, const CollisionPoint *end, int32_t distance,
+                                              const CollisionPoint *vertices, uint32_t numVertices) {
+    for (uint32_t i = 0; i < numVertices; i++) {
+        const CollisionPoint *a = &vertices[i];
+        const CollisionPoint *b = &vertices[i + 1 < numVertices ? i + 1 : 0];
+
+        if (CollisionSegmentsIntersect(start, end, a, b))
+            return 1;
+
+        if (distance > 0 && (CollisionPointNearSegment(start, a, b, distance)
+                             || CollisionPointNearSegment(end, a, b, distance)
+                             || CollisionPointNearSegment(a, start, end, distance)
+                             || CollisionPointNearSegment(b, start, end, distance)))
+            return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Check whether a circle moving along a segment overlaps a convex polygon.
+ *
+ * @param inverted If non-zero, the polygon is a wall that the circle must stay inside of.
+ */
+static inline int32_t CollisionSweepHitsPolygon(const CollisionPoint *start, const CollisionPoint *end,
+                                                int32_t distance, const CollisionPoint *vertices,
+                                                uint32_t numVertices, int32_t inverted) {
+    int32_t startInside = CollisionPointInPolygon(start, vertices, numVertices);
+
+    if (startInside != inverted)
+        return 1;
+
+    if (CollisionSweepHitsEdges(start, end, distance, vertices, numVertices))
+        return 1;
+
+    // if the segment doesn't cross any edges, the end point is on the same side as the start point. for an inverted
+    // polygon, we already know the start point is inside.
+    return 0;
+}
+
+/**
+ * Check whether a circle moving from (x1, z1) to (x2, z2) hits a rectangle collider.
+ *
+ * @param rect Rectangle collider.
+ * @param x1 X coordinate of the start point.
+ * @param z1 Z coordinate of the start point.
+ * @param x2 X coordinate of the end point.
+ * @param z2 Z coordinate of the end point.
+ * @param radius Radius of the moving circle. Use 0 to check the segment itself.
+ * @param isWall If non-zero, the rectangle is a wall collider, which blocks leaving the rectangle rather than entering.
+ * @return Non-zero if the circle hits the rectangle at any point along the segment.
+ */
+static inline int32_t SweptCircleHitsRect(const RectangleCollider *rect, int32_t x1, int32_t z1, int32_t x2, int32_t z2,
+                                          int32_t radius, int32_t isWall) {
+    CollisionFrame frame;
+    CollisionPoint vertices[4];
+    CollisionPoint start, end;
+    int32_t distance;
+
+    CollisionFrameInit(&frame, x1, z1);
+    CollisionFrameFit(&frame, x2, z2);
+    CollisionFrameFit(&frame, rect->xPos, rect->zPos);
+    CollisionFrameFit(&frame, rect->xPos + rect->xSize, rect->zPos + rect->zSize);
+    CollisionFrameFitDistance(&frame, radius);
+
+    start = CollisionToFrame(&frame, x1, z1);
+    end = CollisionToFrame(&frame, x2, z2);
+    vertices[0] = CollisionToFrame(&frame, rect->xPos, rect->zPos);
+    vertices[1] = CollisionToFrame(&frame, rect->xPos + rect->xSize, rect->zPos);
+    vertices[2] = CollisionToFrame(&frame, rect->xPos + rect->xSize, rect->zPos + rect->zSize);
+    vertices[3] = CollisionToFrame(&frame, rect->xPos, rect->zPos + rect->zSize);
+    distance = CollisionDistanceToFrame(&frame, radius);
+
+    return CollisionSweepHitsPolygon(&start, &end, distance, vertices, 4, isWall != 0);
+}
+
+/**
+ * Check whether a circle moving from (x1, z1) to (x2, z2) hits a triangle collider.
+ *
+ * @param tri Triangle collider.
+ * @param x1 X coordinate of the start point.
+ * @param z1 Z coordinate of the start point.
+ * @param x2 X coordinate of the end point.
+ * @param z2 Z coordinate of the end point.
+ * @param radius Radius of the moving circle. Use 0 to check the segment itself.
+ * @return Non-zero if the circle hits the triangle at any point along the segment.
+ */
+static inline int32_t SweptCircleHitsTri(const TriangleCollider *tri, int32_t x1, int32_t z1, int32_t x2, int32_t z2,
+                                         int32_t radius) {
+    CollisionFrame frame;
+    CollisionPoint vertices[3];
+    CollisionPoint start, end;
+    int32_t distance;
+
+    CollisionFrameInit(&frame, x1, z1);
+    CollisionFrameFit(&frame, x2, z2);
+    CollisionFrameFit(&frame, tri->x1, tri->z1);
+    CollisionFrameFit(&frame, tri->x2, tri->z2);
+    CollisionFrameFit(&frame, tri->x3, tri->z3);
+    CollisionFrameFitDistance(&frame, radius);
+
+    start = CollisionToFrame(&frame, x1, z1);
+    end = CollisionToFrame(&frame, x2, z2);
+    vertices[0] = CollisionToFrame(&frame, tri->x1, tri->z1);
+    vertices[1] = CollisionToFrame(&frame, tri->x2, tri->z2);
+    vertices[2] = CollisionToFrame(&frame, tri->x3, tri->z3);
+    distance = CollisionDistanceToFrame(&frame, radius);
+
+    return CollisionSweepHitsPolygon(&start, &end, distance, vertices, 3, 0);
+}
+
+/**
+ * Check whether a circle moving from (x1, z1) to (x2, z2) hits a circle collider.
+ *
+ * @param circle Circle collider.
+ * @param x1 X coordinate of the start point.
+ * @param z1 Z coordinate of the start point.
+ * @param x2 X coordinate of the end point.
+ * @param z2 Z coordinate of the end point.
+ * @param radius Radius of the moving circle. Use 0 to check the segment itself.
+ * @return Non-zero if the circle hits the collider at any point along the segment.
+ */
+static inline int32_t SweptCircleHitsCircle(const CircleCollider *circle, int32_t x1, int32_t z1, int32_t x2,
+                                            int32_t z2, int32_t radius) {
+    CollisionFrame frame;
+    CollisionPoint start, end, center;
+
+    CollisionFrameInit(&frame, x1, z1);
+    CollisionFrameFit(&frame, x2, z2);
+    CollisionFrameFit(&frame, circle->x, circle->z);
+    CollisionFrameFitDistance(&frame, circle->radius + radius);
+
+    start = CollisionToFrame(&frame, x1, z1);
+    end = CollisionToFrame(&frame, x2, z2);
+    center = CollisionToFrame(&frame, circle->x, circle->z);
+
+    return CollisionPointNearSegment(&center, &start, &end, CollisionDistanceToFrame(&frame, circle->radius + radius));
+}
+
+/**
+ * Check whether a circle moving from (x1, z1) to (x2, z2) hits a collider.
+ *
+ * @param collider Collider to check. Its shape pointer must be valid, i.e. it must have been set up by SetRoomLayout
+ *                 or SetupCompactRoom.
+ * @param x1 X coordinate of the start point.
+ * @param z1 Z coordinate of the start point.
+ * @param x2 X coordinate of the end point.
+ * @param z2 Z coordinate of the end point.
+ * @param radius Radius of the moving circle. Use 0 to check the segment itself.
+ * @return Non-zero if the circle hits the collider at any point along the segment.
+ */
+static inline int32_t SweptCircleHitsCollider(const Collider *collider, int32_t x1, int32_t z1, int32_t x2, int32_t z2,
+                                              int32_t radius) {
+    switch (collider->type) {
+        case COLLIDER_WALL:
+            return SweptCircleHitsRect((const RectangleCollider *)collider->shape, x1, z1, x2, z2, radius, 1);
+        case COLLIDER_RECT:
+            return SweptCircleHitsRect((const RectangleCollider *)collider->shape, x1, z1, x2, z2, radius, 0);
+        case COLLIDER_TRI:
+            return SweptCircleHitsTri((const TriangleCollider *)collider->shape, x1, z1, x2, z2, radius);
+        case COLLIDER_CIRCLE:
+            return SweptCircleHitsCircle((const CircleCollider *)collider->shape, x1, z1, x2, z2, radius);
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Check whether a segment from (x1, z1) to (x2, z2) hits a collider.
+ *
+ * @param collider Collider to check.
+ * @param x1 X coordinate of the start point.
+ * @param z1 Z coordinate of the start point.
+ * @param x2 X coordinate of the end point.
+ * @param z2 Z coordinate of the end point.
+ * @return Non-zero if the segment hits the collider.
+ */
+static inline int32_t SegmentHitsCollider(const Collider *collider, int32_t x1, int32_t z1, int32_t x2, int32_t z2) {
+    return SweptCircleHitsCollider(collider, x1, z1, x2, z2, 0);
+}
+
+/**
+ * Check whether a point is blocked by a collider.
+ *
+ * @param collider Collider to check.
+ * @param x X coordinate of the point.
+ * @param z Z coordinate of the point.
+ * @return Non-zero if the point is inside the collider (or outside, for a wall).
+ */
+static inline int32_t PointHitsCollider(const Collider *collider, int32_t x, int32_t z) {
+    return SweptCircleHitsCollider(collider, x, z, x, z, 0);
+}
+
+/**
+ * Find the first collider hit by a circle moving from (x1, z1) to (x2, z2).
+ *
+ * @param colliders Array of colliders to check.
+ * @param numColliders Number of colliders.
+ * @param x1 X coordinate of the start point.
+ * @param z1 Z coordinate of the start point.
+ * @param x2 X coordinate of the end point.
+ * @param z2 Z coordinate of the end point.
+ * @param radius Radius of the moving circle. Use 0 to check the segment itself.
+ * @return Index of the first collider in the array that was hit, or -1 if the path is clear.
+ */
+static inline int32_t FindSweptCircleHit(const Collider *colliders, uint32_t numColliders, int32_t x1, int32_t z1,
+                                         int32_t x2, int32_t z2, int32_t radius) {
+    for (uint32_t i = 0; i < numColliders; i++) {
+        if (SweptCircleHitsCollider(&colliders[i], x1, z1, x2, z2, radius))
+            return (int32_t)i;
+    }
+
+    return -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
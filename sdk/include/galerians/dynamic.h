@@ -0,0 +1,252 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <galerians/types.h>
+#include <galerians/api.h>
+#include <galerians/arena.h>
+
+/**
+ * Colliders that move or switch on and off while the player is in the room.
+ *
+ * Changing the room's collision normally means calling SetupRoom again, which copies the whole RoomLayout. Instead,
+ * InitDynamicColliders makes two copies of the room's collider array in the room arena and gives the colliders chosen
+ * as dynamic their own shapes in each copy. The engine uses one copy while changes are made to the shapes in the other,
+ * and CommitDynamicColliders hands the changed copy to the engine with SetCollision. Call it once per frame from the
+ * room's main loop; since room code only runs between the engine's collision passes, the engine never sees a
+ * half-finished change. Only the collider array and the dynamic shapes are copied, and only on frames with changes.
+ *
+ * Disabled colliders are left out of the array passed to SetCollision, so the engine ignores them completely.
+ */
+
+/**
+ * Maximum number of dynamic colliders in a room.
+ */
+#define DYNAMIC_COLLIDERS_MAX 32
+
+/**
+ * Storage for any collider shape.
+ */
+typedef union _DynamicColliderShape {
+    RectangleCollider rect;
+    TriangleCollider tri;
+    CircleCollider circle;
+} DynamicColliderShape;
+
+/**
+ * A room's colliders with a subset that can be changed.
+ */
+typedef struct _DynamicColliders {
+    const Collider *source;                 // the room's original colliders
+    uint32_t numColliders;
+    Collider *arrays[2];                    // collider arrays given to the engine, alternating
+    DynamicColliderShape *shapes[2];        // dynamic shapes belonging to each array
+    uint16_t indices[DYNAMIC_COLLIDERS_MAX];// index in source of each dynamic collider
+    uint32_t numDynamic;
+    uint32_t enabled;                       // bit mask of enabled dynamic colliders
+    uint32_t front;                         // array the engine is using
+    uint32_t dirty;                         // changes have been made that haven't been committed
+    uint32_t stale;                         // the back shapes are out of date with the front ones
+} DynamicColliders;
+
+static inline void CommitDynamicColliders(DynamicColliders *dyn);
+
+/**
+ * Set up dynamic colliders and give them to the engine.
+ *
+ * Call this after SetupRoom (or SetupCompactRoom), so the shape pointers have been filled in, and instead of calling
+ * SetCollision again. All the dynamic colliders start out enabled.
+ *
+ * @param dyn Dynamic colliders to initialize.
+ * @param colliders The room's colliders, e.g. RoomLayout.colliders. These aren't modified and must remain valid for as
+ *                  long as the player is in the room.
+ * @param numColliders Number of colliders.
+ * @param dynamicIndices Indexes in colliders of the colliders that can change. The position of each in this array is
+ *                       its slot number for the other functions.
+ * @param numDynamic Number of dynamic colliders, up to DYNAMIC_COLLIDERS_MAX.
+ * @return Non-zero on success, or 0 if the arguments are invalid or there isn't enough space in the room arena.
+ */
+static inline int32_t InitDynamicColliders(DynamicColliders *dyn, const Collider *colliders, uint32_t numColliders,
+                                           const uint16_t *dynamicIndices, uint32_t numDynamic) {
+    Arena *arena;
+    uint8_t *mark;
+    uint32_t i, j;
+
+    if (numDynamic > DYNAMIC_COLLIDERS_MAX)
+        return 0;
+    for (i = 0; i < numDynamic; i++) {
+        if (dynamicIndices[i] >= numColliders)
+            return 0;
+    }
+
+    dyn->source = colliders;
+    dyn->numColliders = numColliders;
+    dyn->numDynamic = numDynamic;
+    dyn->enabled = numDynamic == 32 ? 0xFFFFFFFF : ((uint32_t)1 << numDynamic) - 1;
+    dyn->front = 0;
+    dyn->dirty = 0;
+    dyn->stale = 0;
+
+    arena = GetRoomArena();
+    mark = arena->next;
+    for (i = 0; i < 2; i++) {
+        dyn->arrays[i] = (Collider *)ArenaAlloc(arena, numColliders * sizeof(Collider));
+        dyn->shapes[i] = (DynamicColliderShape *)ArenaAlloc(arena, numDynamic * sizeof(DynamicColliderShape));
+        if (dyn->arrays[i] == NULL || (numDynamic > 0 && dyn->shapes[i] == NULL)) {
+            // give back whatever did fit
+            arena->next = mark;
+            return 0;
+        }
+    }
+
+    for (i = 0; i < numDynamic; i++) {
+        const Collider *collider;
+        size_t size;
+
+        dyn->indices[i] = dynamicIndices[i];
+        collider = &colliders[dynamicIndices[i]];
+        size = collider->type == COLLIDER_TRI ? sizeof(TriangleCollider) :
+               collider->type == COLLIDER_CIRCLE ? sizeof(CircleCollider) : sizeof(RectangleCollider);
+        for (j = 0; j < 2; j++)
+            memcpy(&dyn->shapes[j][i], collider->shape, size);
+    }
+
+    // the first commit builds array 0 and gives it to the engine
+    dyn->front = 1;
+    dyn->dirty = 1;
+    CommitDynamicColliders(dyn);
+    return 1;
+}
+
+/**
+ * Get the slot of a collider if it's dynamic.
+ */
+static inline int32_t FindDynamicCollider(const DynamicColliders *dyn, uint32_t index) {
+    uint32_t i;
+
+    for (i = 0; i < dyn->numDynamic; i++) {
+        if (dyn->indices[i] == index)
+            return (int32_t)i;
+    }
+    return -1;
+}
+
+/**
+ * Get the shape of a dynamic collider for changing it. The change takes effect at the next CommitDynamicColliders.
+ *
+ * @param dyn The dynamic colliders.
+ * @param slot Slot of the collider.
+ * @return The shape in the copy that isn't in use. Cast it to the type that matches the collider.
+ */
+static inline DynamicColliderShape *EditDynamicCollider(DynamicColliders *dyn, uint32_t slot) {
+    DynamicColliderShape *back = dyn->shapes[dyn->front ^ 1];
+
+    // after a swap, bring the back copy up to date before changing it
+    if (dyn->stale) {
+        memcpy(back, dyn->shapes[dyn->front], dyn->numDynamic * sizeof(DynamicColliderShape));
+        dyn->stale = 0;
+    }
+    dyn->dirty = 1;
+    return &back[slot];
+}
+
+/**
+ * Move a dynamic collider.
+ *
+ * @param dyn The dynamic colliders.
+ * @param slot Slot of the collider.
+ * @param dx Distance to move in x.
+ * @param dz Distance to move in z.
+ */
+static inline void MoveDynamicCollider(DynamicColliders *dyn, uint32_t slot, int32_t dx, int32_t dz) {
+    DynamicColliderShape *shape = EditDynamicCollider(dyn, slot);
+
+    switch (dyn->source[dyn->indices[slot]].type) {
+        case COLLIDER_TRI:
+            shape->tri.x1 += dx;
+            shape->tri.z1 += dz;
+            shape->tri.x2 += dx;
+            shape->tri.z2 += dz;
+            shape->tri.x3 += dx;
+            shape->tri.z3 += dz;
+            break;
+        case COLLIDER_CIRCLE:
+            shape->circle.x += dx;
+            shape->circle.z += dz;
+            break;
+        default:
+            shape->rect.xPos += dx;
+            shape->rect.zPos += dz;
+            break;
+    }
+}
+
+/**
+ * Turn a dynamic collider on or off. The change takes effect at the next CommitDynamicColliders.
+ *
+ * @param dyn The dynamic colliders.
+ * @param slot Slot of the collider.
+ * @param enabled Non-zero to make it solid.
+ */
+static inline void SetDynamicColliderEnabled(DynamicColliders *dyn, uint32_t slot, int32_t enabled) {
+    uint32_t bit = (uint32_t)1 << slot;
+    uint32_t mask = enabled ? dyn->enabled | bit : dyn->enabled & ~bit;
+
+    if (mask != dyn->enabled) {
+        dyn->enabled = mask;
+        dyn->dirty = 1;
+    }
+}
+
+/**
+ * Give any changes to the engine.
+ *
+ * Rebuilds the collider array that isn't in use with the current shapes and enabled colliders, passes it to
+ * SetCollision, and swaps the two copies. Does nothing if nothing has changed. Call this once per frame from the room's
+ * main loop.
+ *
+ * @param dyn The dynamic colliders.
+ */
+static inline void CommitDynamicColliders(DynamicColliders *dyn) {
+    uint32_t back = dyn->front ^ 1;
+    Collider *out = dyn->arrays[back];
+    uint32_t i, slot = 0, count = 0;
+
+    if (!dyn->dirty)
+        return;
+
+    if (dyn->stale) {
+        memcpy(dyn->shapes[back], dyn->shapes[dyn->front], dyn->numDynamic * sizeof(DynamicColliderShape));
+        dyn->stale = 0;
+    }
+
+    for (i = 0; i < dyn->numColliders; i++) {
+        // dynamic slots are usually in index order, so check the next one first
+        int32_t match = slot < dyn->numDynamic && dyn->indices[slot] == i ? (int32_t)slot :
+                        FindDynamicCollider(dyn, i);
+        if (match >= 0) {
+            slot = (uint32_t)match + 1;
+            if ((dyn->enabled & ((uint32_t)1 << match)) == 0)
+                continue;
+            out[count] = dyn->source[i];
+            out[count].shape = &dyn->shapes[back][match];
+        } else {
+            out[count] = dyn->source[i];
+        }
+        count++;
+    }
+
+    SetCollision(count, out);
+    dyn->front = back;
+    dyn->dirty = 0;
+    dyn->stale = 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,267 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+
+/**
+ * Inline access to stage state flags.
+ *
+ * GetStateFlag and friends in api.h are calls into the game executable. The flags themselves are just bits in
+ * GameState: flags 0-63 of each stage are in stateFlags1[stage], 64-127 in stateFlags2[stage], and 128-191 in
+ * stateFlags3[stage], with flag n at bit n % 64. The functions here read and write those bits directly and mirror
+ * GetStageStateFlag, SetStageStateFlag, and ClearStageStateFlag (0x801284E8, 0x80128220, and 0x80127F20 in the North
+ * American EXE; 0x8012A7B0, 0x8012AA30, and 0x8012AD10 in the Japanese EXE). test/test_flags.py checks the mapping, and
+ * compares it with the North American EXE's SetStageStateFlag in the emulator when given the EXE. GameState's layout
+ * already accounts for the region, so they work for every version of the game.
+ *
+ * For checking several flags at once, build a StateFlagMask with STATE_FLAG_MASK. The mask is a constant expression,
+ * so it can be a static const initializer and costs nothing at run time:
+ *
+ *     static const StateFlagMask puzzleSolved = STATE_FLAG_MASK(12, 13, 70);
+ *     if (AllStateFlags(&Game, &puzzleSolved)) ...
+ *
+ * Flags are accessed as 32-bit halves of the 64-bit words so that variable shifts don't need 64-bit library helpers.
+ */
+
+#define NUM_STAGES              4
+#define STATE_FLAGS_PER_WORD    64
+#define MAX_STATE_FLAGS         192
+#define STATE_FLAG_HALVES       (MAX_STATE_FLAGS / 32)
+
+/**
+ * Maximum number of flags in one STATE_FLAG_MASK.
+ */
+#define STATE_FLAG_MASK_MAX     16
+
+typedef uint32_t __attribute__((may_alias)) StateFlagHalf;
+
+/**
+ * A set of state flags, as the bits of each 32-bit half of the three flag words.
+ */
+typedef struct _StateFlagMask {
+    uint32_t halves[STATE_FLAG_HALVES];
+} StateFlagMask;
+
+#define STATE_FLAG_BIT_(half, flag) \
+    ((flag) >= 0 && (flag) < MAX_STATE_FLAGS && (flag) / 32 == (half) ? (uint32_t)1 << ((flag) % 32) : 0u)
+
+// the 17th argument is always the first -1 of the padding unless too many flags were given, which won't compile
+#define STATE_FLAG_HALF_(half, f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, extra, ...) \
+    (STATE_FLAG_BIT_(half, f0) | STATE_FLAG_BIT_(half, f1) | STATE_FLAG_BIT_(half, f2) | STATE_FLAG_BIT_(half, f3) | \
+     STATE_FLAG_BIT_(half, f4) | STATE_FLAG_BIT_(half, f5) | STATE_FLAG_BIT_(half, f6) | STATE_FLAG_BIT_(half, f7) | \
+     STATE_FLAG_BIT_(half, f8) | STATE_FLAG_BIT_(half, f9) | STATE_FLAG_BIT_(half, f10) | STATE_FLAG_BIT_(half, f11) | \
+     STATE_FLAG_BIT_(half, f12) | STATE_FLAG_BIT_(half, f13) | STATE_FLAG_BIT_(half, f14) | \
+     STATE_FLAG_BIT_(half, f15) | (uint32_t)(sizeof(char[(extra) == -1 ? 1 : -1]) - 1))
+
+#define STATE_FLAG_HALF(half, ...) \
+    STATE_FLAG_HALF_(half, __VA_ARGS__, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)
+
+/**
+ * Initializer for a StateFlagMask containing up to STATE_FLAG_MASK_MAX flags.
+ */
+#define STATE_FLAG_MASK(...) { { \
+    STATE_FLAG_HALF(0, __VA_ARGS__), STATE_FLAG_HALF(1, __VA_ARGS__), STATE_FLAG_HALF(2, __VA_ARGS__), \
+    STATE_FLAG_HALF(3, __VA_ARGS__), STATE_FLAG_HALF(4, __VA_ARGS__), STATE_FLAG_HALF(5, __VA_ARGS__), \
+} }
+
+/**
+ * Get the flag word that holds a flag for a stage.
+ *
+ * @param game Pointer to the game state.
+ * @param flag Index of the flag. Must be less than MAX_STATE_FLAGS.
+ * @param stage Stage the flag is for. Must be less than NUM_STAGES.
+ * @return The 64-bit word, as two halves.
+ */
+static inline StateFlagHalf *GetStateFlagWord(GameState *game, uint32_t flag, uint32_t stage) {
+    uint64_t *words = flag < STATE_FLAGS_PER_WORD ? game->stateFlags1 :
+                      flag < STATE_FLAGS_PER_WORD * 2 ? game->stateFlags2 : game->stateFlags3;
+    return (StateFlagHalf *)&words[stage];
+}
+
+/**
+ * Get the value (0 or 1) of a state flag for the given stage, like GetStageStateFlag.
+ *
+ * @param game Pointer to the game state.
+ * @param flag Index of the flag to get.
+ * @param stage Stage to check the flag for.
+ * @return Value of the flag. Flags or stages that are out of range are always 0.
+ */
+static inline int32_t GetStageStateFlagInline(GameState *game, int16_t flag, int16_t stage) {
+    uint32_t bit = (uint16_t)flag % STATE_FLAGS_PER_WORD;
+
+    if ((uint16_t)flag >= MAX_STATE_FLAGS || (uint16_t)stage >= NUM_STAGES)
+        return 0;
+    return (int32_t)((GetStateFlagWord(game, (uint16_t)flag, (uint16_t)stage)[bit / 32] >> (bit % 32)) & 1);
+}
+
+/**
+ * Set a state flag to true (1) for the given stage, like SetStageStateFlag.
+ *
+ * @param game Pointer to the game state.
+ * @param flag Index of the flag to set.
+ * @param stage Stage to set the flag for.
+ */
+static inline void SetStageStateFlagInline(GameState *game, int16_t flag, int16_t stage) {
+    uint32_t bit = (uint16_t)flag % STATE_FLAGS_PER_WORD;
+
+    if ((uint16_t)flag >= MAX_STATE_FLAGS || (uint16_t)stage >= NUM_STAGES)
+        return;
+    GetStateFlagWord(game, (uint16_t)flag, (uint16_t)stage)[bit / 32] |= (uint32_t)1 << (bit % 32);
+}
+
+/**
+ * Clear (set to false/0) a state flag for the given stage, like ClearStageStateFlag.
+ *
+ * @param game Pointer to the game state.
+ * @param flag Index of the flag to clear.
+ * @param stage Stage to clear the flag for.
+ */
+static inline void ClearStageStateFlagInline(GameState *game, int16_t flag, int16_t stage) {
+    uint32_t bit = (uint16_t)flag % STATE_FLAGS_PER_WORD;
+
+    if ((uint16_t)flag >= MAX_STATE_FLAGS || (uint16_t)stage >= NUM_STAGES)
+        return;
+    GetStateFlagWord(game, (uint16_t)flag, (uint16_t)stage)[bit / 32] &= ~((uint32_t)1 << (bit % 32));
+}
+
+/**
+ * Get the value (0 or 1) of a state flag for the current stage, like GetStateFlag.
+ *
+ * @param game Pointer to the game state.
+ * @param flag Index of the flag to get.
+ * @return Value of the flag.
+ */
+static inline int32_t GetStateFlagInline(GameState *game, int16_t flag) {
+    return GetStageStateFlagInline(game, flag, (int16_t)game->stageId);
+}
+
+/**
+ * Set a state flag to true (1) for the current stage, like SetStateFlag.
+ *
+ * @param game Pointer to the game state.
+ * @param flag Index of the flag to set.
+ */
+static inline void SetStateFlagInline(GameState *game, int16_t flag) {
+    SetStageStateFlagInline(game, flag, (int16_t)game->stageId);
+}
+
+/**
+ * Clear (set to false/0) a state flag for the current stage, like ClearStateFlag.
+ *
+ * @param game Pointer to the game state.
+ * @param flag Index of the flag to clear.
+ */
+static inline void ClearStateFlagInline(GameState *game, int16_t flag) {
+    ClearStageStateFlagInline(game, flag, (int16_t)game->stageId);
+}
+
+/**
+ * Check whether every flag in a mask is set for the given stage.
+ *
+ * @param game Pointer to the game state.
+ * @param stage Stage to check the flags for.
+ * @param mask Flags to check.
+ * @return 1 if all the flags are set (or the mask is empty), otherwise 0.
+ */
+static inline int32_t AllStageStateFlags(GameState *game, int16_t stage, const StateFlagMask *mask) {
+    uint32_t i;
+
+    if ((uint16_t)stage >= NUM_STAGES)
+        return 0;
+    for (i = 0; i < STATE_FLAG_HALVES; i++) {
+        const StateFlagHalf *word = GetStateFlagWord(game, i * 32, (uint16_t)stage);
+        if ((word[i % 2] & mask->halves[i]) != mask->halves[i])
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * Check whether any flag in a mask is set for the given stage.
+ *
+ * @param game Pointer to the game state.
+ * @param stage Stage to check the flags for.
+ * @param mask Flags to check.
+ * @return 1 if at least one of the flags is set, otherwise 0.
+ */
+static inline int32_t AnyStageStateFlags(GameState *game, int16_t stage, const StateFlagMask *mask) {
+    uint32_t i;
+
+    if ((uint16_t)stage >= NUM_STAGES)
+        return 0;
+    for (i = 0; i < STATE_FLAG_HALVES; i++) {
+        const StateFlagHalf *word = GetStateFlagWord(game, i * 32, (uint16_t)stage);
+        if (word[i % 2] & mask->halves[i])
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * Set every flag in a mask for the given stage.
+ *
+ * @param game Pointer to the game state.
+ * @param stage Stage to set the flags for.
+ * @param mask Flags to set.
+ */
+static inline void SetStageStateFlags(GameState *game, int16_t stage, const StateFlagMask *mask) {
+    uint32_t i;
+
+    if ((uint16_t)stage >= NUM_STAGES)
+        return;
+    for (i = 0; i < STATE_FLAG_HALVES; i++)
+        GetStateFlagWord(game, i * 32, (uint16_t)stage)[i % 2] |= mask->halves[i];
+}
+
+/**
+ * Clear every flag in a mask for the given stage.
+ *
+ * @param game Pointer to the game state.
+ * @param stage Stage to clear the flags for.
+ * @param mask Flags to clear.
+ */
+static inline void ClearStageStateFlags(GameState *game, int16_t stage, const StateFlagMask *mask) {
+    uint32_t i;
+
+    if ((uint16_t)stage >= NUM_STAGES)
+        return;
+    for (i = 0; i < STATE_FLAG_HALVES; i++)
+        GetStateFlagWord(game, i * 32, (uint16_t)stage)[i % 2] &= ~mask->halves[i];
+}
+
+/**
+ * Check whether every flag in a mask is set for the current stage.
+ */
+static inline int32_t AllStateFlags(GameState *game, const StateFlagMask *mask) {
+    return AllStageStateFlags(game, (int16_t)game->stageId, mask);
+}
+
+/**
+ * Check whether any flag in a mask is set for the current stage.
+ */
+static inline int32_t AnyStateFlags(GameState *game, const StateFlagMask *mask) {
+    return AnyStageStateFlags(game, (int16_t)game->stageId, mask);
+}
+
+/**
+ * Set every flag in a mask for the current stage.
+ */
+static inline void SetStateFlags(GameState *game, const StateFlagMask *mask) {
+    SetStageStateFlags(game, (int16_t)game->stageId, mask);
+}
+
+/**
+ * Clear every flag in a mask for the current stage.
+ */
+static inline void ClearStateFlags(GameState *game, const StateFlagMask *mask) {
+    ClearStageStateFlags(game, (int16_t)game->stageId, mask);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -18,6 +18,14 @@ extern void *ModuleLoadAddresses[5];
 extern void *ModuleLoadAddresses[4];
 #endif
 
+// defined by the linker script. bounds of the free memory after the end of the current module in the module region.
+extern uint8_t ModuleEnd[];
+extern uint8_t ModuleRegionEnd[];
+// defined by the linker script. bounds of the current module's zero-initialized data. this is only non-empty for
+// layouts that don't store zero-initialized data in the module file, like na_gc.ld.
+extern uint8_t ModuleBssStart[];
+extern uint8_t ModuleBssEnd[];
+
 extern Database BgTimADb;
 extern Database BgTimBDb;
 extern Database BgTimCDb;
@@ -0,0 +1,329 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+#include <galerians/arena.h>
+
+/**
+ * Number of grid cells along each axis.
+ */
+#define ROOM_GRID_SIZE 8
+#define ROOM_GRID_CELLS (ROOM_GRID_SIZE * ROOM_GRID_SIZE)
+
+/**
+ * Maximum number of interactables and cuts that can be indexed.
+ */
+#define ROOM_GRID_MAX_INTERACTABLES 128
+#define ROOM_GRID_MAX_CUTS          16
+
+#define ROOM_GRID_MASK_WORDS (ROOM_GRID_MAX_INTERACTABLES / 32)
+
+/**
+ * A uniform grid over a room's interactables and camera cuts.
+ *
+ * Each cell records which interactables and cuts overlap it, so a point query only has to check the few objects in
+ * that point's cell instead of every object in the room. Cells are a power of 2 in size so locating a cell doesn't
+ * need a division. The grid holds pointers into the room's layout, so it must be rebuilt if the layout changes.
+ */
+typedef struct _RoomGrid {
+    int32_t minX;
+    int32_t minZ;
+    uint32_t cellShift;
+    uint32_t numInteractables;
+    uint32_t numCuts;
+    Interactable *interactables;
+    CameraCut *cuts;
+    uint32_t interactableMasks[ROOM_GRID_CELLS][ROOM_GRID_MASK_WORDS];
+    uint16_t cutMasks[ROOM_GRID_CELLS];
+} RoomGrid;
+
+/**
+ * Get the grid cell coordinate of a position along one axis, clamped to the grid.
+ */
+static inline int32_t RoomGridCoord(const RoomGrid *grid, int32_t pos, int32_t min) {
+    int32_t coord = (pos - min) >> grid->cellShift;
+
+    if (coord < 0)
+        return 0;
+    if (coord >= ROOM_GRID_SIZE)
+        return ROOM_GRID_SIZE - 1;
+    return coord;
+}
+
+/**
+ * Get the index of the cell containing a point, or -1 if the point is outside the grid.
+ *
+ * @param grid Room grid.
+ * @param x X coordinate of the point.
+ * @param z Z coordinate of the point.
+ * @return Index of the cell.
+ */
+static inline int32_t RoomGridCell(const RoomGrid *grid, int32_t x, int32_t z) {
+    int32_t cellX = (x - grid->minX) >> grid->cellShift;
+    int32_t cellZ = (z - grid->minZ) >> grid->cellShift;
+
+    if (x < grid->minX || z < grid->minZ || cellX >= ROOM_GRID_SIZE || cellZ >= ROOM_GRID_SIZE)
+        return -1;
+    return cellZ * ROOM_GRID_SIZE + cellX;
+}
+
+/**
+ * Check whether a point is inside the triangle (x1, z1), (x2, z2), (x3, z3), in either winding order.
+ */
+static inline int32_t PointInCutTriangle(int32_t x, int32_t z, int32_t x1, int32_t z1, int32_t x2, int32_t z2,
+                                         int32_t x3, int32_t z3) {
+    // room coordinates can be far enough apart that the products overflow 32 bits
+    int64_t d1 = (int64_t)(x2 - x1) * (z - z1) - (int64_t)(z2 - z1) * (x - x1);
+    int64_t d2 = (int64_t)(x3 - x2) * (z - z2) - (int64_t)(z3 - z2) * (x - x2);
+    int64_t d3 = (int64_t)(x1 - x3) * (z - z3) - (int64_t)(z1 - z3) * (x - x3);
+
+    return (d1 >= 0 && d2 >= 0 && d3 >= 0) || (d1 <= 0 && d2 <= 0 && d3 <= 0);
+}
+
+/**
+ * Check whether a point is inside a camera cut.
+ *
+ * The game doesn't store cut vertices in a consistent order, so this checks the point against all four triangles that
+ * can be made from the vertices, which together cover the quad no matter which order the vertices are in.
+ *
+ * @param cut Camera cut to check.
+ * @param x X coordinate of the point.
+ * @param z Z coordinate of the point.
+ * @return Non-zero if the point is inside the cut.
+ */
+static inline int32_t PointInCut(const CameraCut *cut, int32_t x, int32_t z) {
+    return PointInCutTriangle(x, z, cut->x1, cut->z1, cut->x2, cut->z2, cut->x3, cut->z3)
+        || PointInCutTriangle(x, z, cut->x1, cut->z1, cut->x2, cut->z2, cut->x4, cut->z4)
+        || PointInCutTriangle(x, z, cut->x1, cut->z1, cut->x3, cut->z3, cut->x4, cut->z4)
+        || PointInCutTriangle(x, z, cut->x2, cut->z2, cut->x3, cut->z3, cut->x4, cut->z4);
+}
+
+/**
+ * Build a grid over a set of interactables and camera cuts.
+ *
+ * @param grid Grid to build.
+ * @param interactables Array of interactables.
+ * @param numInteractables Number of interactables. Only the first ROOM_GRID_MAX_INTERACTABLES are indexed.
+ * @param cuts Array of camera cuts terminated by an entry with a negative marker. May be NULL. Only the first
+ *             ROOM_GRID_MAX_CUTS are indexed.
+ */
+static inline void BuildRoomGrid(RoomGrid *grid, Interactable *interactables, uint32_t numInteractables,
+                                 CameraCut *cuts) {
+    int32_t minX = INT32_MAX, minZ = INT32_MAX, maxX = INT32_MIN, maxZ = INT32_MIN;
+    uint32_t numCuts = 0;
+
+    if (numInteractables > ROOM_GRID_MAX_INTERACTABLES)
+        numInteractables = ROOM_GRID_MAX_INTERACTABLES;
+    if (cuts != NULL) {
+        while (numCuts < ROOM_GRID_MAX_CUTS && cuts[numCuts].marker >= 0)
+            numCuts++;
+    }
+
+    grid->interactables = interactables;
+    grid->numInteractables = numInteractables;
+    grid->cuts = cuts;
+    grid->numCuts = numCuts;
+
+    // find the bounds of everything in the room
+    for (uint32_t i = 0; i < numInteractables; i++) {
+        Interactable *interactable = &interactables[i];
+        if (interactable->xPos < minX) minX = interactable->xPos;
+        if (interactable->zPos < minZ) minZ = interactable->zPos;
+        if (interactable->xPos + interactable->xSize > maxX) maxX = interactable->xPos + interactable->xSize;
+        if (interactable->zPos + interactable->zSize > maxZ) maxZ = interactable->zPos + interactable->zSize;
+    }
+
+    for (uint32_t i = 0; i < numCuts; i++) {
+        CameraCut *cut = &cuts[i];
+        int32_t xs[4] = { cut->x1, cut->x2, cut->x3, cut->x4 };
+        int32_t zs[4] = { cut->z1, cut->z2, cut->z3, cut->z4 };
+        for (uint32_t j = 0; j < 4; j++) {
+            if (xs[j] < minX) minX = xs[j];
+            if (zs[j] < minZ) minZ = zs[j];
+            if (xs[j] > maxX) maxX = xs[j];
+            if (zs[j] > maxZ) maxZ = zs[j];
+        }
+    }
+
+    if (minX > maxX) {
+        // empty room
+        minX = minZ = maxX = maxZ = 0;
+    }
+
+    grid->minX = minX;
+    grid->minZ = minZ;
+    grid->cellShift = 0;
+    while (((maxX - minX) >> grid->cellShift) >= ROOM_GRID_SIZE || ((maxZ - minZ) >> grid->cellShift) >= ROOM_GRID_SIZE)
+        grid->cellShift++;
+
+    for (uint32_t cell = 0; cell < ROOM_GRID_CELLS; cell++) {
+        for (uint32_t word = 0; word < ROOM_GRID_MASK_WORDS; word++)
+            grid->interactableMasks[cell][word] = 0;
+        grid->cutMasks[cell] = 0;
+    }
+
+    // mark each object in every cell its bounding box overlaps
+    for (uint32_t i = 0; i < numInteractables; i++) {
+        Interactable *interactable = &interactables[i];
+        int32_t x1 = RoomGridCoord(grid, interactable->xPos, minX);
+        int32_t z1 = RoomGridCoord(grid, interactable->zPos, minZ);
+        int32_t x2 = RoomGridCoord(grid, interactable->xPos + interactable->xSize, minX);
+        int32_t z2 = RoomGridCoord(grid, interactable->zPos + interactable->zSize, minZ);
+        for (int32_t z = z1; z <= z2; z++) {
+            for (int32_t x = x1; x <= x2; x++)
+                grid->interactableMasks[z * ROOM_GRID_SIZE + x][i >> 5] |= 1u << (i & 31);
+        }
+    }
+
+    for (uint32_t i = 0; i < numCuts; i++) {
+        CameraCut *cut = &cuts[i];
+        int32_t cutMinX = cut->x1, cutMinZ = cut->z1, cutMaxX = cut->x1, cutMaxZ = cut->z1;
+        int32_t xs[3] = { cut->x2, cut->x3, cut->x4 };
+        int32_t zs[3] = { cut->z2, cut->z3, cut->z4 };
+        for (uint32_t j = 0; j < 3; j++) {
+            if (xs[j] < cutMinX) cutMinX = xs[j];
+            if (zs[j] < cutMinZ) cutMinZ = zs[j];
+            if (xs[j] > cutMaxX) cutMaxX = xs[j];
+            if (zs[j] > cutMaxZ) cutMaxZ = zs[j];
+        }
+
+        int32_t x1 = RoomGridCoord(grid, cutMinX, minX);
+        int32_t z1 = RoomGridCoord(grid, cutMinZ, minZ);
+        int32_t x2 = RoomGridCoord(grid, cutMaxX, minX);
+        int32_t z2 = RoomGridCoord(grid, cutMaxZ, minZ);
+        for (int32_t z = z1; z <= z2; z++) {
+            for (int32_t x = x1; x <= x2; x++)
+                grid->cutMasks[z * ROOM_GRID_SIZE + x] |= (uint16_t)(1u << i);
+        }
+    }
+}
+
+/**
+ * Build a grid over the current room's interactables and camera cuts.
+ *
+ * This should be called after the room's layout has been set with SetupRoom or SetupCompactRoom.
+ *
+ * @param grid Grid to build.
+ * @param game Pointer to the game state object.
+ */
+static inline void BuildRoomGridFromGame(RoomGrid *grid, GameState *game) {
+    BuildRoomGrid(grid, game->interactables, game->numTriggers > 0 ? (uint32_t)game->numTriggers : 0, game->cuts);
+}
+
+/**
+ * Allocate a grid from the room arena and build it over the current room's interactables and camera cuts.
+ *
+ * @param game Pointer to the game state object.
+ * @return The new grid, or NULL if there wasn't enough memory.
+ */
+static inline RoomGrid *CreateRoomGrid(GameState *game) {
+    RoomGrid *grid = (RoomGrid *)RoomAlloc(sizeof(RoomGrid));
+
+    if (grid != NULL)
+        BuildRoomGridFromGame(grid, game);
+    return grid;
+}
+
+/**
+ * Find the interactables overlapping a rectangle.
+ *
+ * Interactables are returned in the same order they appear in the room layout.
+ *
+ * @param grid Room grid.
+ * @param x X coordinate of the rectangle.
+ * @param z Z coordinate of the rectangle.
+ * @param xSize Width of the rectangle. Use 0 to check a single point.
+ * @param zSize Depth of the rectangle. Use 0 to check a single point.
+ * @param indexes Receives the indexes of the overlapping interactables.
+ * @param maxIndexes Maximum number of indexes to return.
+ * @return Number of indexes returned.
+ */
+static inline uint32_t FindInteractablesInRect(const RoomGrid *grid, int32_t x, int32_t z, int32_t xSize, int32_t zSize,
+                                               uint16_t *indexes, uint32_t maxIndexes) {
+    uint32_t mask[ROOM_GRID_MASK_WORDS] = { 0 };
+    uint32_t count = 0;
+    int32_t x1, z1, x2, z2;
+
+    if (x + xSize < grid->minX || z + zSize < grid->minZ)
+        return 0;
+    if (((x - grid->minX) >> grid->cellShift) >= ROOM_GRID_SIZE || ((z - grid->minZ) >> grid->cellShift) >= ROOM_GRID_SIZE)
+        return 0;
+
+    x1 = RoomGridCoord(grid, x, grid->minX);
+    z1 = RoomGridCoord(grid, z, grid->minZ);
+    x2 = RoomGridCoord(grid, x + xSize, grid->minX);
+    z2 = RoomGridCoord(grid, z + zSize, grid->minZ);
+    for (int32_t cellZ = z1; cellZ <= z2; cellZ++) {
+        for (int32_t cellX = x1; cellX <= x2; cellX++) {
+            for (uint32_t word = 0; word < ROOM_GRID_MASK_WORDS; word++)
+                mask[word] |= grid->interactableMasks[cellZ * ROOM_GRID_SIZE + cellX][word];
+        }
+    }
+
+    for (uint32_t word = 0; word < ROOM_GRID_MASK_WORDS; word++) {
+        uint32_t bits = mask[word];
+        for (uint32_t i = word << 5; bits != 0 && count < maxIndexes; i++, bits >>= 1) {
+            Interactable *interactable;
+            if ((bits & 1) == 0)
+                continue;
+
+            interactable = &grid->interactables[i];
+            if (x <= interactable->xPos + interactable->xSize && interactable->xPos <= x + xSize &&
+                z <= interactable->zPos + interactable->zSize && interactable->zPos <= z + zSize)
+                indexes[count++] = (uint16_t)i;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Find the interactables containing a point.
+ *
+ * @param grid Room grid.
+ * @param x X coordinate of the point.
+ * @param z Z coordinate of the point.
+ * @param indexes Receives the indexes of the interactables containing the point.
+ * @param maxIndexes Maximum number of indexes to return.
+ * @return Number of indexes returned.
+ */
+static inline uint32_t FindInteractablesAt(const RoomGrid *grid, int32_t x, int32_t z, uint16_t *indexes,
+                                           uint32_t maxIndexes) {
+    return FindInteractablesInRect(grid, x, z, 0, 0, indexes, maxIndexes);
+}
+
+/**
+ * Find the camera cut containing a point.
+ *
+ * If multiple cuts contain the point, the one that comes first in the room layout is returned.
+ *
+ * @param grid Room grid.
+ * @param x X coordinate of the point.
+ * @param z Z coordinate of the point.
+ * @return Index of the cut in the room layout, or -1 if no cut contains the point.
+ */
+static inline int32_t FindCutAt(const RoomGrid *grid, int32_t x, int32_t z) {
+    int32_t cell = RoomGridCell(grid, x, z);
+    uint32_t bits;
+
+    if (cell < 0)
+        return -1;
+
+    bits = grid->cutMasks[cell];
+    for (int32_t i = 0; bits != 0; i++, bits >>= 1) {
+        if ((bits & 1) && PointInCut(&grid->cuts[i], x, z))
+            return i;
+    }
+
+    return -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,211 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+#include <galerians/api.h>
+
+/**
+ * Number of elements in a fixed-size array.
+ */
+#define COUNTOF(a) (sizeof(a) / sizeof((a)[0]))
+
+/**
+ * Terminator entry for a list of camera cuts.
+ *
+ * The game doesn't keep a count of cuts; it walks the list until it finds an entry with a negative marker. Every cut
+ * list passed to a CompactRoomLayout must end with this entry.
+ */
+#define CAMERA_CUT_END { .marker = -1 }
+
+/**
+ * CompactRoomLayout flags.
+ */
+// the colliders' shape pointers have already been filled in, so SetupCompactRoom shouldn't assign them. this allows
+// multiple colliders to share the same shape.
+#define COMPACT_LAYOUT_LINKED 1
+
+/**
+ * A variable-length alternative to RoomLayout.
+ *
+ * RoomLayout always reserves space for 100 of each collider type and 100 interactables, which is about 11.6 KB per room
+ * regardless of how many are actually used. CompactRoomLayout instead points at arrays sized by the module, so only the
+ * entries the room uses take up space in the ROOM region. Use SetupCompactRoom in place of SetupRoom to activate it.
+ *
+ * The shape pointers of the colliders don't need to be filled in; SetupCompactRoom assigns them in order from the
+ * shape arrays the same way SetRoomLayout does, so the first rectangle or wall collider gets rectColliders[0], the first
+ * triangle collider gets triColliders[0], and so on. Arrays for a shape type with no colliders can be left NULL. If the
+ * COMPACT_LAYOUT_LINKED flag is set, the shape pointers are used as-is instead; galsdk.layoutgen generates layouts like
+ * this so that identical shapes are only stored once.
+ *
+ * Note that the editor locates a room's layout through the call to SetRoomLayout, so rooms using a compact layout can't
+ * currently have their layout viewed or edited in the editor.
+ */
+typedef struct _CompactRoomLayout {
+    uint16_t numColliders;
+    uint16_t numCameras;
+    uint16_t numInteractables;
+    uint16_t flags;
+    Collider *colliders;
+    RectangleCollider *rectColliders;
+    TriangleCollider *triColliders;
+    CircleCollider *circleColliders;
+    Camera *cameras;
+    CameraCut *cuts;                // must be terminated with CAMERA_CUT_END
+    Interactable *interactables;
+} CompactRoomLayout;
+
+/**
+ * Define a CompactRoomLayout from statically-sized arrays.
+ *
+ * Counts are taken from the array sizes, so arrays must be declared with their exact length (not accessed through a
+ * pointer). Shape arrays for collider types the room doesn't use may be NULL.
+ *
+ * @param colliders_ Array of Collider.
+ * @param rects_ Array of RectangleCollider (for both rectangle and wall colliders) or NULL.
+ * @param tris_ Array of TriangleCollider or NULL.
+ * @param circles_ Array of CircleCollider or NULL.
+ * @param cameras_ Array of Camera.
+ * @param cuts_ Array of CameraCut ending with CAMERA_CUT_END.
+ * @param interactables_ Array of Interactable.
+ */
+#define COMPACT_ROOM_LAYOUT(colliders_, rects_, tris_, circles_, cameras_, cuts_, interactables_) {    \
+    .numColliders = COUNTOF(colliders_),                                                            \
+    .numCameras = COUNTOF(cameras_),                                                                \
+    .numInteractables = COUNTOF(interactables_),                                                    \
+    .colliders = (colliders_),                                                                      \
+    .rectColliders = (rects_),                                                                      \
+    .triColliders = (tris_),                                                                        \
+    .circleColliders = (circles_),                                                                  \
+    .cameras = (cameras_),                                                                          \
+    .cuts = (cuts_),                                                                                \
+    .interactables = (interactables_),                                                              \
+}
+
+/**
+ * Assign each collider's shape pointer from the layout's shape arrays.
+ *
+ * @param layout Compact room layout whose colliders to link.
+ */
+static inline void LinkCompactColliders(CompactRoomLayout *layout) {
+    uint32_t numRects = 0;
+    uint32_t numTris = 0;
+    uint32_t numCircles = 0;
+
+    for (uint32_t i = 0; i < layout->numColliders; i++) {
+        Collider *collider = &layout->colliders[i];
+        switch (collider->type) {
+            case COLLIDER_TRI:
+                collider->shape = &layout->triColliders[numTris++];
+                break;
+            case COLLIDER_CIRCLE:
+                collider->shape = &layout->circleColliders[numCircles++];
+                break;
+            default:
+                // walls are rectangles too
+                collider->shape = &layout->rectColliders[numRects++];
+                break;
+        }
+    }
+}
+
+/**
+ * Set the layout and collision of the current room from a compact layout.
+ *
+ * This is the CompactRoomLayout equivalent of SetupRoom, but it doesn't call SetRoomLayout (NA 0x8012E980, JP
+ * 0x8012F400), because that function only accepts a full RoomLayout. Instead, it writes these GameState fields directly
+ * and then passes the colliders to SetCollision:
+ *
+ *  - numCameras (0x010) and cameras (0x014), from the layout's cameras
+ *  - cuts (0x01C), from the layout's cuts
+ *  - numTriggers (0x024), from the number of interactables
+ *  - interactables (0x034), from the layout's interactables
+ *
+ * These are the GameState fields that hold the layout's arrays after SetupRoom. The list hasn't been checked against a
+ * disassembly of SetRoomLayout, so if that sets any other state (for instance, from RoomLayout's unknown1CC8 block),
+ * this won't. Use ExpandCompactRoomLayout and SetupRoom instead when a room needs to behave exactly like one set up by
+ * the game. The layout must remain valid for as long as the player is in the room.
+ *
+ * @param layout Compact room layout to use.
+ */
+static inline void SetupCompactRoom(CompactRoomLayout *layout) {
+    if ((layout->flags & COMPACT_LAYOUT_LINKED) == 0)
+        LinkCompactColliders(layout);
+
+    Game.numCameras = (uint8_t)layout->numCameras;
+    Game.cameras = layout->cameras;
+    Game.cuts = layout->cuts;
+    Game.interactables = layout->interactables;
+    Game.numTriggers = (int16_t)layout->numInteractables;
+
+    SetCollision(layout->numColliders, layout->colliders);
+}
+
+/**
+ * Copy a compact layout into a full RoomLayout so it can be set with SetupRoom.
+ *
+ * This gives up the memory savings of the compact layout in exchange for setting the room up through the game's own
+ * SetRoomLayout. The RoomLayout is large (see its definition), so it's best allocated with RoomAlloc, which also keeps
+ * it valid for as long as the player is in the room. Shapes shared between colliders in a COMPACT_LAYOUT_LINKED layout
+ * are copied once for each collider that uses them, since RoomLayout assigns shapes in order.
+ *
+ * @param layout Compact room layout to copy.
+ * @param buffer RoomLayout to fill in.
+ * @return Non-zero on success, or 0 if the compact layout has more entries of some kind than RoomLayout can hold.
+ */
+static inline int32_t ExpandCompactRoomLayout(CompactRoomLayout *layout, RoomLayout *buffer) {
+    uint32_t numRects = 0;
+    uint32_t numTris = 0;
+    uint32_t numCircles = 0;
+    uint32_t numCuts = 0;
+
+    if (layout->numColliders > COUNTOF(buffer->colliders) || layout->numCameras > COUNTOF(buffer->cameras) ||
+        layout->numInteractables > COUNTOF(buffer->interactables))
+        return 0;
+
+    while (layout->cuts[numCuts].marker >= 0) {
+        // the terminator needs a slot too
+        if (++numCuts >= COUNTOF(buffer->cuts))
+            return 0;
+    }
+
+    if ((layout->flags & COMPACT_LAYOUT_LINKED) == 0)
+        LinkCompactColliders(layout);
+
+    memset(buffer, 0, sizeof(*buffer));
+    buffer->numColliders = layout->numColliders;
+    for (uint32_t i = 0; i < layout->numColliders; i++) {
+        const Collider *collider = &layout->colliders[i];
+        buffer->colliders[i] = *collider;
+        // SetRoomLayout links the shapes itself
+        buffer->colliders[i].shape = NULL;
+        switch (collider->type) {
+            case COLLIDER_TRI:
+                buffer->triColliders[numTris++] = *(const TriangleCollider *)collider->shape;
+                break;
+            case COLLIDER_CIRCLE:
+                buffer->circleColliders[numCircles++] = *(const CircleCollider *)collider->shape;
+                break;
+            default:
+                buffer->rectColliders[numRects++] = *(const RectangleCollider *)collider->shape;
+                break;
+        }
+    }
+
+    buffer->numCameras = layout->numCameras;
+    memcpy(buffer->cameras, layout->cameras, layout->numCameras * sizeof(Camera));
+    memcpy(buffer->cuts, layout->cuts, (numCuts + 1) * sizeof(CameraCut));
+    buffer->numInteractables = layout->numInteractables;
+    memcpy(buffer->interactables, layout->interactables, layout->numInteractables * sizeof(Interactable));
+    return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
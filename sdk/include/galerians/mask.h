@@ -0,0 +1,325 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+#include <galerians/arena.h>
+
+/**
+ * Culling and sorting of background masks.
+ *
+ * The engine draws every mask in the current background's mask list every frame. For rooms with a lot of masks (or
+ * several backgrounds sharing one big mask list), this header replaces each background's list with a copy that only
+ * contains the masks in front of the background's camera, sorted by depth. The work is done once per camera, when the
+ * room first cuts to it, and the engine then draws the shorter list with no further changes.
+ *
+ * A mask's x, y, and z are treated as a point in the room, and a mask is kept if that point is inside the camera's view
+ * (widened by BACKGROUND_MASK_CULL_MARGIN, since a mask covers an area around its point). If masks near the edge of the
+ * screen disappear, increase the margin.
+ */
+
+/**
+ * Distance outside the edge of the camera's view a mask's point can be and still be drawn. Define this before
+ * including the header to change it.
+ */
+#ifndef BACKGROUND_MASK_CULL_MARGIN
+#define BACKGROUND_MASK_CULL_MARGIN 512
+#endif
+
+/**
+ * Number of depth buckets masks are sorted into. Masks in the same bucket keep their original order.
+ */
+#define BACKGROUND_MASK_DEPTH_BUCKETS 16
+
+/**
+ * Maximum number of cameras in a room.
+ */
+#define BACKGROUND_MAX_CAMERAS 10
+
+/**
+ * Horizontal field of view divided by the vertical field of view, as tangents. The screen is 4:3.
+ */
+#define BACKGROUND_ASPECT_NUM 4
+#define BACKGROUND_ASPECT_DEN 3
+
+/**
+ * Which cameras in the current room have had their backgrounds' masks culled.
+ *
+ * This is weak so that each source file including this header shares the same state. It's reset automatically when
+ * the player changes rooms. Don't access it directly; use the functions below.
+ */
+typedef struct _BackgroundMaskState {
+    uint32_t stageId;
+    uint16_t mapId;
+    uint16_t roomId;
+    uint16_t preparedCameras;   // bit mask of cameras whose masks have been culled
+    int16_t lastCamera;         // camera most recently checked by UpdateBackgroundMasks
+} BackgroundMaskState;
+
+__attribute__((weak)) BackgroundMaskState BackgroundMasks = { .lastCamera = -1 };
+
+// tan of 0 to 90 degrees in 5 degree steps, with 4096 = 1.0. values that don't fit in 16 bits are clamped.
+static const uint16_t BackgroundMaskTangents[19] = {
+    0, 358, 722, 1098, 1491, 1910, 2365, 2868, 3437, 4096, 4881, 5850, 7094, 8784, 11254, 15286, 23229, 46817, 65535
+};
+
+/**
+ * Get the tangent of an angle given in tenths of a degree, with 4096 = 1.0.
+ */
+static inline int32_t BackgroundMaskTan(int32_t tenths) {
+    uint32_t step, frac;
+
+    if (tenths <= 0)
+        return 0;
+    if (tenths >= 900)
+        return BackgroundMaskTangents[18];
+
+    step = (uint32_t)tenths / 50;
+    frac = (uint32_t)tenths % 50;
+    return BackgroundMaskTangents[step] +
+           (int32_t)(((BackgroundMaskTangents[step + 1] - BackgroundMaskTangents[step]) * frac) / 50);
+}
+
+static inline int32_t BackgroundMaskAbs(int32_t value) {
+    return value < 0 ? -value : value;
+}
+
+/**
+ * A camera's view, for testing which masks are visible.
+ *
+ * Positions are relative to the camera and divided by 4 so that the dot products with the 4096-scaled axes can't
+ * overflow.
+ */
+typedef struct _BackgroundMaskView {
+    int16_t x, y, z;            // camera position
+    int32_t forward[3];         // unit vectors, 4096 = 1.0
+    int32_t right[3];
+    int32_t up[3];
+    int32_t tanHalfWidth;       // tangents of half the field of view, 4096 = 1.0
+    int32_t tanHalfHeight;
+} BackgroundMaskView;
+
+/**
+ * Set up a view for a camera.
+ *
+ * @param view View to initialize.
+ * @param camera The camera.
+ */
+static inline void InitBackgroundMaskView(BackgroundMaskView *view, const Camera *camera) {
+    int32_t fx = camera->targetX - camera->x, fy = camera->targetY - camera->y, fz = camera->targetZ - camera->z;
+    int32_t length, tanHalfHeight;
+
+    view->x = camera->x;
+    view->y = camera->y;
+    view->z = camera->z;
+
+    // differences of int16s can be up to 17 bits. scale them down so the squares fit.
+    while (BackgroundMaskAbs(fx) >= 16384 || BackgroundMaskAbs(fy) >= 16384 || BackgroundMaskAbs(fz) >= 16384) {
+        fx >>= 1;
+        fy >>= 1;
+        fz >>= 1;
+    }
+    length = SquareRoot0(fx * fx + fy * fy + fz * fz);
+    if (length == 0) {
+        // the camera is looking at itself; arbitrarily look down the z axis
+        fx = fy = 0;
+        fz = length = 1;
+    }
+    view->forward[0] = fx * 4096 / length;
+    view->forward[1] = fy * 4096 / length;
+    view->forward[2] = fz * 4096 / length;
+
+    // the right vector is horizontal; the up vector is whatever's perpendicular to both
+    length = SquareRoot0(view->forward[0] * view->forward[0] + view->forward[2] * view->forward[2]);
+    if (length == 0) {
+        view->right[0] = 4096;
+        view->right[2] = 0;
+    } else {
+        view->right[0] = view->forward[2] * 4096 / length;
+        view->right[2] = -view->forward[0] * 4096 / length;
+    }
+    view->right[1] = 0;
+    view->up[0] = (view->forward[1] * view->right[2] - view->forward[2] * view->right[1]) >> 12;
+    view->up[1] = (view->forward[2] * view->right[0] - view->forward[0] * view->right[2]) >> 12;
+    view->up[2] = (view->forward[0] * view->right[1] - view->forward[1] * view->right[0]) >> 12;
+
+    // verticalFov is in tenths of a degree. clamp the tangents so products with depths fit in 32 bits.
+    tanHalfHeight = BackgroundMaskTan(camera->verticalFov / 2);
+    view->tanHalfHeight = tanHalfHeight > 32767 ? 32767 : tanHalfHeight;
+    view->tanHalfWidth = tanHalfHeight * BACKGROUND_ASPECT_NUM / BACKGROUND_ASPECT_DEN;
+    if (view->tanHalfWidth > 32767)
+        view->tanHalfWidth = 32767;
+}
+
+/**
+ * Get the depth of a mask in a view.
+ *
+ * @param view The view.
+ * @param mask The mask.
+ * @return The distance of the mask's point in front of the camera, divided by 4, or -1 if the point is outside the
+ *         view.
+ */
+static inline int32_t GetBackgroundMaskDepth(const BackgroundMaskView *view, const BackgroundMask *mask) {
+    int32_t rx = (mask->x - view->x) >> 2, ry = (mask->y - view->y) >> 2, rz = (mask->z - view->z) >> 2;
+    int32_t depth = (rx * view->forward[0] + ry * view->forward[1] + rz * view->forward[2]) >> 12;
+    int32_t side, up;
+
+    if (depth <= 0)
+        return -1;
+
+    side = (rx * view->right[0] + ry * view->right[1] + rz * view->right[2]) >> 12;
+    if (BackgroundMaskAbs(side) > ((depth * view->tanHalfWidth) >> 12) + BACKGROUND_MASK_CULL_MARGIN / 4)
+        return -1;
+
+    up = (rx * view->up[0] + ry * view->up[1] + rz * view->up[2]) >> 12;
+    if (BackgroundMaskAbs(up) > ((depth * view->tanHalfHeight) >> 12) + BACKGROUND_MASK_CULL_MARGIN / 4)
+        return -1;
+
+    return depth;
+}
+
+/**
+ * Get the depth bucket for a visible mask, with bucket 0 the farthest.
+ */
+static inline int32_t GetBackgroundMaskBucket(int32_t depth, int32_t maxDepth) {
+    return BACKGROUND_MASK_DEPTH_BUCKETS - 1 - depth * BACKGROUND_MASK_DEPTH_BUCKETS / (maxDepth + 1);
+}
+
+/**
+ * Cull and sort a list of masks for a camera.
+ *
+ * The first mask is the background image itself rather than a real mask, so it's always kept first and unchanged. Of
+ * the rest, masks outside the view are dropped, and the others are sorted from farthest to nearest into
+ * BACKGROUND_MASK_DEPTH_BUCKETS buckets with a counting sort. Masks in the same bucket keep their original order.
+ *
+ * @param camera The camera.
+ * @param masks Masks to sort.
+ * @param numMasks Number of masks.
+ * @param out Array to receive the visible masks. Must have room for numMasks masks and may not overlap masks.
+ * @param depths Scratch space for numMasks depths.
+ * @return The number of visible masks, including the first.
+ */
+static inline uint32_t CullBackgroundMasks(const Camera *camera, const BackgroundMask *masks, uint32_t numMasks,
+                                           BackgroundMask *out, int16_t *depths) {
+    BackgroundMaskView view;
+    uint16_t next[BACKGROUND_MASK_DEPTH_BUCKETS], start = 1;
+    int32_t maxDepth = 0;
+    uint32_t i, numVisible = 1;
+
+    if (numMasks == 0)
+        return 0;
+
+    out[0] = masks[0];
+    InitBackgroundMaskView(&view, camera);
+
+    for (i = 0; i < BACKGROUND_MASK_DEPTH_BUCKETS; i++)
+        next[i] = 0;
+
+    for (i = 1; i < numMasks; i++) {
+        int32_t depth = GetBackgroundMaskDepth(&view, &masks[i]);
+        depths[i] = (int16_t)depth;
+        if (depth > maxDepth)
+            maxDepth = depth;
+    }
+
+    // count the masks in each bucket, then turn the counts into each bucket's starting position
+    for (i = 1; i < numMasks; i++) {
+        if (depths[i] >= 0) {
+            next[GetBackgroundMaskBucket(depths[i], maxDepth)]++;
+            numVisible++;
+        }
+    }
+
+    for (i = 0; i < BACKGROUND_MASK_DEPTH_BUCKETS; i++) {
+        uint16_t count = next[i];
+        next[i] = start;
+        start += count;
+    }
+
+    for (i = 1; i < numMasks; i++) {
+        if (depths[i] >= 0)
+            out[next[GetBackgroundMaskBucket(depths[i], maxDepth)]++] = masks[i];
+    }
+
+    return numVisible;
+}
+
+/**
+ * Replace the mask list of a camera's background with only its visible masks, sorted by depth.
+ *
+ * This only does anything the first time it's called for each camera in a room. The new list is allocated from the room
+ * arena, along with scratch space for the masks' depths which is given back once they're sorted. If there isn't enough
+ * space, the background is left alone and nothing stays allocated.
+ *
+ * @param cameraIndex Index of the camera in the current room.
+ */
+static inline void PrepareBackgroundMasks(int32_t cameraIndex) {
+    BackgroundMaskState *state = &BackgroundMasks;
+    Background *background;
+    BackgroundMask *masks;
+    int16_t *depths;
+    Arena *arena;
+    uint8_t *mark;
+    uint8_t *scratch;
+
+    if (state->stageId != Game.stageId || state->mapId != Game.mapId || state->roomId != Game.roomId) {
+        state->stageId = Game.stageId;
+        state->mapId = Game.mapId;
+        state->roomId = Game.roomId;
+        state->preparedCameras = 0;
+        state->lastCamera = -1;
+    }
+
+    if (cameraIndex < 0 || cameraIndex >= BACKGROUND_MAX_CAMERAS || cameraIndex >= Game.numCameras ||
+        (state->preparedCameras & (1 << cameraIndex)))
+        return;
+    state->preparedCameras |= (uint16_t)(1 << cameraIndex);
+
+    background = &Game.backgrounds[cameraIndex];
+    // the first mask is the background image, so there's nothing to cull unless there are others
+    if (background->numMasks <= 1 || background->masks == NULL)
+        return;
+
+    arena = GetRoomArena();
+    mark = arena->next;
+    masks = (BackgroundMask *)ArenaAlloc(arena, background->numMasks * sizeof(BackgroundMask));
+    if (masks == NULL)
+        return;
+    // the depths are only needed while sorting, so they go after the list and are freed again straight away
+    scratch = arena->next;
+    depths = (int16_t *)ArenaAlloc(arena, background->numMasks * sizeof(int16_t));
+    if (depths == NULL) {
+        arena->next = mark;
+        return;
+    }
+
+    background->numMasks = (uint16_t)CullBackgroundMasks(&Game.cameras[cameraIndex], background->masks,
+                                                         background->numMasks, masks, depths);
+    background->masks = masks;
+    arena->next = scratch;
+}
+
+/**
+ * Cull the masks for the camera the room is cutting to, if they haven't been already.
+ *
+ * Call this every frame from the room's main loop. It only does any real work when the camera changes.
+ */
+static inline void UpdateBackgroundMasks(void) {
+    int32_t camera = Game.newCameraIndex >= 0 ? Game.newCameraIndex : Game.currentCameraId;
+
+    if (camera == BackgroundMasks.lastCamera && BackgroundMasks.roomId == Game.roomId &&
+        BackgroundMasks.mapId == Game.mapId && BackgroundMasks.stageId == Game.stageId)
+        return;
+
+    PrepareBackgroundMasks(camera);
+    BackgroundMasks.lastCamera = (int16_t)camera;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,231 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+#include <galerians/relation.h>
+
+/**
+ * Transforming points on an actor's model segments.
+ *
+ * When the engine poses an actor's model, it stores each segment's accumulated transform in the segment's rotMatrix
+ * (rotation) and fullTfmModelOffsets (translation). Applying that transform to a point in the segment's own
+ * coordinates gives its position in the same space as fullTfmModelOffsets, which is what hitbox and attachment code
+ * needs. The transform is done with the GTE: a segment's matrix is loaded once and then any number of points are run
+ * through it with MVMVA, which is much cheaper than calling SetRotMatrix, SetTransMatrix, and RotTrans for every point.
+ * Define GALERIANS_NO_GTE before including this header to do the math on the CPU instead (e.g. for testing the code on
+ * a PC).
+ *
+ * The segment transforms are whatever the engine calculated the last time it posed the actor, so depending on when AI
+ * code runs, they may be from the previous frame.
+ */
+
+/**
+ * Number of segments in Actor.segments.
+ */
+#define ACTOR_MAX_SEGMENTS 20
+
+/**
+ * Index used for Actor.unknownSegment in the segment position cache.
+ */
+#define ACTOR_EXTRA_SEGMENT ACTOR_MAX_SEGMENTS
+
+/**
+ * Number of segment positions cached for each actor: the segments in Actor.segments plus Actor.unknownSegment.
+ */
+#define ACTOR_NUM_SEGMENT_POSITIONS (ACTOR_MAX_SEGMENTS + 1)
+
+#ifndef GALERIANS_NO_GTE
+/**
+ * Load a segment's transform into the GTE rotation and translation registers.
+ *
+ * Normally you should use TransformSegmentPoints instead.
+ */
+static inline void LoadSegmentTransform(const ModelSegment *segment) {
+    const MATRIX *m = &segment->rotMatrix;
+
+    __asm__ volatile (
+        "ctc2 %0, $0\n"
+        "ctc2 %1, $1\n"
+        "ctc2 %2, $2\n"
+        "ctc2 %3, $3\n"
+        "ctc2 %4, $4\n"
+        "ctc2 %5, $5\n"
+        "ctc2 %6, $6\n"
+        "ctc2 %7, $7\n"
+        :
+        : "r"(((uint32_t)(uint16_t)m->m[0][1] << 16) | (uint16_t)m->m[0][0]),
+          "r"(((uint32_t)(uint16_t)m->m[1][0] << 16) | (uint16_t)m->m[0][2]),
+          "r"(((uint32_t)(uint16_t)m->m[1][2] << 16) | (uint16_t)m->m[1][1]),
+          "r"(((uint32_t)(uint16_t)m->m[2][1] << 16) | (uint16_t)m->m[2][0]),
+          "r"((uint32_t)(uint16_t)m->m[2][2]),
+          "r"(segment->fullTfmModelOffsets.vx), "r"(segment->fullTfmModelOffsets.vy),
+          "r"(segment->fullTfmModelOffsets.vz)
+    );
+}
+
+/**
+ * Transform a point with the transform currently loaded in the GTE.
+ *
+ * Normally you should use TransformSegmentPoints instead.
+ */
+static inline void TransformLoadedPoint(const SVECTOR *point, VECTOR *out) {
+    int32_t x, y, z;
+
+    // MVMVA with sf=1, mx=rotation, v=V0, cv=translation: MAC = TR + (RT * V0 >> 12)
+    __asm__ volatile (
+        "mtc2 %3, $0\n"
+        "mtc2 %4, $1\n"
+        "nop\n"
+        "nop\n"
+        "cop2 0x0480012\n"
+        "mfc2 %0, $25\n"
+        "mfc2 %1, $26\n"
+        "mfc2 %2, $27\n"
+        "nop\n"
+        : "=r"(x), "=r"(y), "=r"(z)
+        : "r"(((uint32_t)(uint16_t)point->vy << 16) | (uint16_t)point->vx), "r"((int32_t)point->vz)
+    );
+
+    out->vx = x;
+    out->vy = y;
+    out->vz = z;
+}
+#endif
+
+/**
+ * Transform points from a segment's coordinates with the segment's current transform.
+ *
+ * @param segment Segment the points are relative to.
+ * @param points Points to transform, in the segment's coordinates.
+ * @param out Array to receive the transformed points. May not overlap points.
+ * @param count Number of points.
+ */
+static inline void TransformSegmentPoints(const ModelSegment *segment, const SVECTOR *points, VECTOR *out,
+                                          int32_t count) {
+#ifdef GALERIANS_NO_GTE
+    const MATRIX *m = &segment->rotMatrix;
+
+    for (int32_t i = 0; i < count; i++) {
+        int32_t x = points[i].vx, y = points[i].vy, z = points[i].vz;
+        out[i].vx = segment->fullTfmModelOffsets.vx + ((m->m[0][0] * x + m->m[0][1] * y + m->m[0][2] * z) >> 12);
+        out[i].vy = segment->fullTfmModelOffsets.vy + ((m->m[1][0] * x + m->m[1][1] * y + m->m[1][2] * z) >> 12);
+        out[i].vz = segment->fullTfmModelOffsets.vz + ((m->m[2][0] * x + m->m[2][1] * y + m->m[2][2] * z) >> 12);
+    }
+#else
+    LoadSegmentTransform(segment);
+    for (int32_t i = 0; i < count; i++)
+        TransformLoadedPoint(&points[i], &out[i]);
+#endif
+}
+
+/**
+ * Get a model segment of an actor by its index in the segment position cache.
+ *
+ * @param actor The actor.
+ * @param segment Index of the segment in Actor.segments, or ACTOR_EXTRA_SEGMENT for Actor.unknownSegment.
+ * @return The segment.
+ */
+static inline const ModelSegment *GetActorSegment(const Actor *actor, int32_t segment) {
+    return segment == ACTOR_EXTRA_SEGMENT ? &actor->unknownSegment : &actor->segments[segment];
+}
+
+/**
+ * Positions of a point on each segment of each actor.
+ *
+ * By default, the point on each segment is the segment's origin. Use SetSegmentProbe to track a different point, for
+ * example the tip of a weapon for a hitbox.
+ */
+typedef struct _SegmentPositions {
+    uint16_t frame;                                                 // FrameCount when the positions were calculated
+    uint16_t isValid;                                               // whether the positions are up to date
+    SVECTOR probes[NUM_ACTORS][ACTOR_NUM_SEGMENT_POSITIONS];        // point to track on each segment
+    VECTOR positions[NUM_ACTORS][ACTOR_NUM_SEGMENT_POSITIONS];      // transformed probe points
+} SegmentPositions;
+
+/**
+ * The shared segment position cache. This is weak so that each source file including this header shares the same
+ * cache.
+ */
+__attribute__((weak)) SegmentPositions SegmentPositionCache = { .isValid = 0 };
+
+/**
+ * Recalculate the segment positions of every actor in the room.
+ *
+ * Normally you should call GetSegmentPosition or GetActorSegmentPositions instead, which only do this once per frame.
+ *
+ * @param cache Cache to fill in.
+ */
+static inline void CalculateSegmentPositions(SegmentPositions *cache) {
+    for (int32_t i = 0; i < NUM_ACTORS; i++) {
+        const Actor *actor = &Actors[i];
+        int32_t numSegments = actor->numSegments;
+
+        if (!IsActorPresent(actor))
+            continue;
+
+        if (numSegments > ACTOR_MAX_SEGMENTS)
+            numSegments = ACTOR_MAX_SEGMENTS;
+        for (int32_t j = 0; j < numSegments; j++)
+            TransformSegmentPoints(&actor->segments[j], &cache->probes[i][j], &cache->positions[i][j], 1);
+        TransformSegmentPoints(&actor->unknownSegment, &cache->probes[i][ACTOR_EXTRA_SEGMENT],
+                               &cache->positions[i][ACTOR_EXTRA_SEGMENT], 1);
+    }
+
+    cache->frame = FrameCount;
+    cache->isValid = 1;
+}
+
+/**
+ * Get the segment positions of an actor for the current frame, calculating them if this is the first request this
+ * frame.
+ *
+ * @param actorIndex Index of the actor.
+ * @return The positions of the actor's segment probes, indexed by segment. Entries for segments the actor doesn't have
+ *         are not meaningful.
+ */
+static inline const VECTOR *GetActorSegmentPositions(int32_t actorIndex) {
+    if (!SegmentPositionCache.isValid || SegmentPositionCache.frame != FrameCount)
+        CalculateSegmentPositions(&SegmentPositionCache);
+
+    return SegmentPositionCache.positions[actorIndex];
+}
+
+/**
+ * Get the position of one of an actor's segment probes for the current frame.
+ *
+ * @param actorIndex Index of the actor.
+ * @param segment Index of the segment in Actor.segments, or ACTOR_EXTRA_SEGMENT for Actor.unknownSegment.
+ * @return The position of the segment's probe point.
+ */
+static inline const VECTOR *GetSegmentPosition(int32_t actorIndex, int32_t segment) {
+    return &GetActorSegmentPositions(actorIndex)[segment];
+}
+
+/**
+ * Set the point to track on one of an actor's segments.
+ *
+ * The probe applies to whichever actor is in the slot, so set it again if the actor in the slot changes.
+ *
+ * @param actorIndex Index of the actor.
+ * @param segment Index of the segment in Actor.segments, or ACTOR_EXTRA_SEGMENT for Actor.unknownSegment.
+ * @param x X coordinate of the point in the segment's coordinates.
+ * @param y Y coordinate of the point in the segment's coordinates.
+ * @param z Z coordinate of the point in the segment's coordinates.
+ */
+static inline void SetSegmentProbe(int32_t actorIndex, int32_t segment, int16_t x, int16_t y, int16_t z) {
+    SVECTOR *probe = &SegmentPositionCache.probes[actorIndex][segment];
+
+    probe->vx = x;
+    probe->vy = y;
+    probe->vz = z;
+    SegmentPositionCache.isValid = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
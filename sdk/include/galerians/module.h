@@ -0,0 +1,59 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+#include <galerians/api.h>
+
+/**
+ * Support for modules that don't store their zero-initialized data in the module file.
+ *
+ * When a module is linked with one of the *_gc.ld linker scripts, the module file ends at the last initialized byte.
+ * Big zero-filled tables (a RoomLayout is mostly zeros; an unused ActorLayout or BackgroundMask array is entirely zeros)
+ * then don't have to be read from the CD every time the room loads. The game doesn't know about any of this, though, so
+ * the module has to clear that memory itself before using it. MODULE_ENTRY generates an entry point which does that.
+ */
+
+#define MODULE_HEADER_MAGIC     0x444F4D47  // "GMOD"
+#define MODULE_HEADER_VERSION   1
+
+/**
+ * Header written by the *_gc.ld linker scripts directly after the module ID.
+ *
+ * This is only informational for tools like the editor, which need to know that addresses past the end of the file are
+ * still part of the module. The layout must be kept in sync with the linker scripts and galsdk/module.py.
+ */
+typedef struct _ModuleHeader {
+    uint32_t magic;     // 00
+    uint16_t version;   // 04
+    uint16_t size;      // 06 size of this header
+    uint32_t fileSize;  // 08 size of the module file, including the module ID and this header
+    uint32_t bssSize;   // 0C size of the zero-initialized data following the file
+} ModuleHeader;
+_Static_assert(sizeof(ModuleHeader) == 0x10, "sizeof(ModuleHeader) not correct");
+
+/**
+ * Define a module entry point which clears the module's zero-initialized data and then calls the given function.
+ *
+ * Use the name of the entry point as the linker entry (e.g. -e room), and put the room's setup code in the wrapped
+ * function instead. With the default linker scripts, there's nothing to clear, so this just calls the function.
+ *
+ * The wrapped function is called normally rather than being the game task's entry point, so its argument is saved in
+ * the entry point's stack frame and isn't affected by the task stack bug described in the example room.
+ *
+ * @param name Name of the entry point function to define.
+ * @param func Function to call once the data has been cleared, with the same signature as a room function.
+ */
+#define MODULE_ENTRY(name, func)        \
+    void name(GameState *game) {        \
+        ClearModuleBss();               \
+        func(game);                     \
+    }
+
+#ifdef __cplusplus
+}
+#endif
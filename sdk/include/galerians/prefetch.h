@@ -0,0 +1,216 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+#include <galerians/api.h>
+#include <galerians/arena.h>
+#include <galerians/async.h>
+
+// depends on async.h, which isn't available for the Japanese version yet
+#ifndef GALERIANS_REGION_JAPAN
+
+/**
+ * Maximum number of files that can be prefetched at once.
+ */
+#define PREFETCH_CACHE_SIZE 4
+
+/**
+ * A file that has been or is being loaded ahead of time.
+ */
+typedef struct _PrefetchEntry {
+    Database *db;           // NULL if the entry is free
+    uint32_t index;
+    void *buffer;
+    uint32_t size;          // size reserved for the file until it's loaded, then the size of the file
+    AsyncLoadHandle handle; // ASYNC_LOAD_INVALID once the load has completed
+} PrefetchEntry;
+
+/**
+ * Files prefetched in the current room.
+ *
+ * Buffers are allocated from the room arena, so the cache is only valid for as long as the player is in the room and
+ * is emptied when the room changes or the arena is reset. This means it can't hold the next room's module or
+ * backgrounds; those are loaded by the game over the module region after GoToRoom. This is weak so that each source
+ * file including this header shares the same cache.
+ */
+typedef struct _PrefetchCache {
+    PrefetchEntry entries[PREFETCH_CACHE_SIZE];
+    uint32_t stageId;
+    uint16_t mapId;
+    uint16_t roomId;
+} PrefetchCache;
+
+__attribute__((weak)) PrefetchCache Prefetches = { .entries = { { .db = NULL } } };
+
+/**
+ * Forget all prefetched files and cancel any prefetches still in progress.
+ *
+ * This is registered as a room arena reset hook by PrefetchFile, so it normally doesn't need to be called directly. If
+ * a prefetch is being read from the CD, this waits for the read to finish so it can't overwrite memory the arena hands
+ * out next.
+ */
+static inline void ResetPrefetchCache(void) {
+    int32_t isReading = 0;
+
+    for (uint32_t i = 0; i < PREFETCH_CACHE_SIZE; i++) {
+        PrefetchEntry *entry = &Prefetches.entries[i];
+        if (entry->db != NULL && entry->handle != ASYNC_LOAD_INVALID && !CancelAsyncLoad(entry->handle))
+            isReading = 1;
+        entry->db = NULL;
+    }
+
+    if (isReading) {
+        while (IsAsyncLoading())
+            ;
+        PumpAsyncLoads();
+    }
+}
+
+/**
+ * Empty the cache if the player has changed rooms since it was last used.
+ */
+static inline void CheckPrefetchRoom(void) {
+    if (Prefetches.stageId != Game.stageId || Prefetches.mapId != Game.mapId || Prefetches.roomId != Game.roomId) {
+        ResetPrefetchCache();
+        Prefetches.stageId = Game.stageId;
+        Prefetches.mapId = Game.mapId;
+        Prefetches.roomId = Game.roomId;
+    }
+}
+
+/**
+ * Find a prefetched file in the cache.
+ *
+ * @param db The database the file was prefetched from.
+ * @param index The index of the file in the database.
+ * @return The cache entry, or NULL if the file hasn't been prefetched.
+ */
+static inline PrefetchEntry *FindPrefetch(Database *db, uint32_t index) {
+    CheckPrefetchRoom();
+    for (uint32_t i = 0; i < PREFETCH_CACHE_SIZE; i++) {
+        PrefetchEntry *entry = &Prefetches.entries[i];
+        if (entry->db == db && entry->index == index)
+            return entry;
+    }
+
+    return NULL;
+}
+
+/**
+ * Start loading a file in the background so a later load of the same file doesn't have to wait for the CD.
+ *
+ * Prefetches are queued behind any other asynchronous loads. Call PumpAsyncLoads each frame (for example, in the room
+ * function's Yield loop) so they keep progressing during idle frames.
+ *
+ * @param db The database to load from.
+ * @param index The index of the file in the database to load.
+ * @param size Maximum size of the file in bytes. This much memory is reserved in the room arena.
+ * @return Non-zero if the file has been or is being prefetched. Fails if the cache or load queue is full, there isn't
+ *         enough free memory left in the room arena, or all of the arena's reset hooks are taken.
+ */
+static inline int32_t PrefetchFile(Database *db, uint32_t index, uint32_t size) {
+    PrefetchEntry *entry = NULL;
+    Arena *arena;
+    uint8_t *mark;
+
+    if (FindPrefetch(db, index) != NULL)
+        return 1;
+
+    for (uint32_t i = 0; i < PREFETCH_CACHE_SIZE; i++) {
+        if (Prefetches.entries[i].db == NULL) {
+            entry = &Prefetches.entries[i];
+            break;
+        }
+    }
+
+    if (entry == NULL || !AddRoomArenaResetHook(ResetPrefetchCache))
+        return 0;
+
+    arena = GetRoomArena();
+    mark = arena->next;
+    entry->buffer = ArenaAlloc(arena, size);
+    if (entry->buffer == NULL)
+        return 0;
+
+    entry->handle = QueueAsyncLoad(db, index, entry->buffer);
+    if (entry->handle == ASYNC_LOAD_INVALID) {
+        // nothing else has been allocated since, so the reservation can be given back
+        arena->next = mark;
+        return 0;
+    }
+
+    entry->db = db;
+    entry->index = index;
+    entry->size = size;
+    return 1;
+}
+
+/**
+ * Get a prefetched file if it has finished loading.
+ *
+ * @param db The database the file was prefetched from.
+ * @param index The index of the file in the database.
+ * @return Pointer to the prefetched file data, or NULL if the file wasn't prefetched or is still loading.
+ */
+static inline void *GetPrefetchedFile(Database *db, uint32_t index) {
+    PrefetchEntry *entry = FindPrefetch(db, index);
+
+    if (entry == NULL)
+        return NULL;
+
+    if (entry->handle != ASYNC_LOAD_INVALID) {
+        if (!IsAsyncLoadDone(entry->handle))
+            return NULL;
+
+        if (GetAsyncLoadSize(entry->handle) < entry->size)
+            entry->size = GetAsyncLoadSize(entry->handle);
+        FinishAsyncLoad(entry->handle);
+        entry->handle = ASYNC_LOAD_INVALID;
+    }
+
+    return entry->buffer;
+}
+
+/**
+ * Load a file from a database, using the prefetched copy if there is one.
+ *
+ * If the file is still being prefetched, this yields until it's ready, so it must only be called from a game task when
+ * the file might have been prefetched. Otherwise, it falls back to LoadFileFromDb.
+ *
+ * @param db The database to load from.
+ * @param index The index of the file in the database to load.
+ * @param buffer Pointer to the buffer to load the file to. If NULL and the file was prefetched, the prefetched data is
+ *               returned in place. If NULL and the file wasn't prefetched, the buffer will be allocated dynamically.
+ *               Otherwise, it must be at least as large as the size the file was prefetched with.
+ * @return Pointer to the buffer where the file data was loaded.
+ */
+static inline void *LoadFileFromDbPrefetched(Database *db, uint32_t index, void *buffer) {
+    PrefetchEntry *entry = FindPrefetch(db, index);
+    void *data;
+
+    if (entry == NULL)
+        return LoadFileFromDb(db, index, buffer);
+
+    while ((data = GetPrefetchedFile(db, index)) == NULL)
+        Yield();
+
+    if (buffer == NULL)
+        return data;
+
+    // once the load is done, size is the file's size rather than the space reserved for it
+    memcpy(buffer, data, entry->size);
+    return buffer;
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,170 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+
+/**
+ * Instrumentation for measuring how long code takes to run.
+ *
+ * Profiling is disabled unless GALERIANS_PROFILE is defined before including this header. When it's disabled, all the
+ * macros and functions here compile to nothing, so instrumentation can be left in place in release builds.
+ *
+ * Each measurement is recorded as a sample in a ring buffer along with the name of the zone being measured and the
+ * frame it was taken on. The ring buffer starts with a signature so it can be found in a RAM dump or save state, and
+ * `python -m galsdk.profiler` will summarize the samples it contains.
+ *
+ * Times are measured with root counter 2, which ProfileInit sets to count every 8 CPU cycles. The counter is 16 bits,
+ * so a single measurement can be at most about 524,000 cycles (a little under one frame) before it wraps around. Note
+ * that if a measured zone yields, the time spent in other tasks will be counted too.
+ */
+
+#define PROFILE_MAGIC       0x46525047  // "GPRF"
+#define PROFILE_VERSION     1
+#define PROFILE_CYCLES_PER_TICK 8
+
+#ifndef PROFILE_CAPACITY
+#define PROFILE_CAPACITY    256
+#endif
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// root counter 2 hardware registers
+#define PROFILE_COUNTER_VALUE   (*(volatile uint32_t *)0x1F801120)
+#define PROFILE_COUNTER_MODE    (*(volatile uint32_t *)0x1F801124)
+// free-running, clock source = system clock / 8
+#define PROFILE_COUNTER_SYSCLOCK_8  0x0200
+
+/**
+ * A single timing measurement.
+ */
+typedef struct _ProfileSample {
+    const char *zone;   // 00
+    uint16_t frame;     // 04
+    uint16_t ticks;     // 06
+} ProfileSample;
+_Static_assert(sizeof(ProfileSample) == 8, "sizeof(ProfileSample) not correct");
+
+/**
+ * Ring buffer of timing measurements.
+ *
+ * This layout is parsed by galsdk/profiler.py, so the two must be kept in sync.
+ */
+typedef struct _ProfileBuffer {
+    uint32_t magic;                             // 00
+    uint16_t version;                           // 04
+    uint16_t capacity;                          // 06
+    uint16_t next;                              // 08
+    uint16_t pad0A;                             // 0A
+    uint32_t count;                             // 0C
+    ProfileSample samples[PROFILE_CAPACITY];    // 10
+} ProfileBuffer;
+
+/**
+ * An in-progress measurement.
+ */
+typedef struct _ProfileScope {
+    const char *zone;
+    uint16_t start;
+} ProfileScope;
+
+#ifdef GALERIANS_PROFILE
+
+/**
+ * The sample buffer. This is weak so that each source file including this header shares the same buffer.
+ */
+__attribute__((weak)) ProfileBuffer Profile = {
+    .magic = PROFILE_MAGIC,
+    .version = PROFILE_VERSION,
+    .capacity = PROFILE_CAPACITY,
+};
+
+/**
+ * Configure root counter 2 for profiling.
+ *
+ * Call this once when the module starts, before taking any measurements. Don't use profiling if something else in the
+ * game depends on root counter 2.
+ */
+static inline void ProfileInit(void) {
+    PROFILE_COUNTER_MODE = PROFILE_COUNTER_SYSCLOCK_8;
+}
+
+/**
+ * Read the current value of the profiling counter.
+ */
+static inline uint16_t ProfileTicks(void) {
+    return (uint16_t)PROFILE_COUNTER_VALUE;
+}
+
+/**
+ * Record a completed measurement.
+ *
+ * @param zone Name of the zone that was measured. This must be a string literal or otherwise remain valid for as long
+ *             as the module is loaded, because only the pointer is stored.
+ * @param ticks Number of counter ticks the zone took.
+ */
+static inline void ProfileRecord(const char *zone, uint16_t ticks) {
+    ProfileSample *sample = &Profile.samples[Profile.next];
+
+    sample->zone = zone;
+    sample->frame = FrameCount;
+    sample->ticks = ticks;
+
+    if (++Profile.next >= PROFILE_CAPACITY)
+        Profile.next = 0;
+    Profile.count++;
+}
+
+/**
+ * Start measuring a zone.
+ *
+ * @param zone Name of the zone to measure.
+ * @return The in-progress measurement, to be passed to ProfileEnd.
+ */
+static inline ProfileScope ProfileBegin(const char *zone) {
+    ProfileScope scope = { zone, ProfileTicks() };
+    return scope;
+}
+
+/**
+ * Finish measuring a zone and record the sample.
+ *
+ * @param scope The in-progress measurement returned by ProfileBegin.
+ */
+static inline void ProfileEnd(ProfileScope *scope) {
+    ProfileRecord(scope->zone, (uint16_t)(ProfileTicks() - scope->start));
+}
+
+/**
+ * Measure the time from this point to the end of the enclosing block.
+ *
+ * @param zone Name of the zone to measure.
+ */
+#define PROFILE_SCOPE(zone) \
+    ProfileScope PROFILE_CONCAT(profileScope, __LINE__) __attribute__((cleanup(ProfileEnd))) = ProfileBegin(zone)
+
+#else
+
+static inline void ProfileInit(void) {}
+
+static inline void ProfileRecord(const char *zone __attribute__((unused)), uint16_t ticks __attribute__((unused))) {}
+
+static inline ProfileScope ProfileBegin(const char *zone) {
+    ProfileScope scope = { zone, 0 };
+    return scope;
+}
+
+static inline void ProfileEnd(ProfileScope *scope __attribute__((unused))) {}
+
+#define PROFILE_SCOPE(zone)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
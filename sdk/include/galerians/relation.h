@@ -0,0 +1,151 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+
+/**
+ * Number of actor slots in a room.
+ */
+#define NUM_ACTORS 4
+
+/**
+ * Distance reported for actor slots that aren't in use.
+ */
+#define ACTOR_DISTANCE_NONE INT32_MAX
+
+/**
+ * Pairwise distances and angles between the actors in the room.
+ *
+ * Actor already has actorPositions and actorIndexesByDistance, but it's not known when the engine updates them during
+ * the frame, so AI code can't rely on them being current. This table is calculated on demand at most once per frame.
+ */
+typedef struct _ActorRelations {
+    uint16_t frame;                                 // FrameCount when the table was calculated
+    uint16_t isValid;                               // whether the table has been calculated at all
+    int32_t distanceSquared[NUM_ACTORS][NUM_ACTORS];// from actor i to actor j
+    int16_t angle[NUM_ACTORS][NUM_ACTORS];          // direction from actor i to actor j, 4096 = 360 degrees
+    int16_t indexesByDistance[NUM_ACTORS][NUM_ACTORS - 1];  // other actors ordered from nearest to farthest
+} ActorRelations;
+
+/**
+ * The shared relation table. This is weak so that each source file including this header shares the same table. Note
+ * that each module gets its own copy, so AI routines in different modules will each calculate it once per frame.
+ */
+__attribute__((weak)) ActorRelations ActorRelationCache = { .isValid = 0 };
+
+/**
+ * Check whether an actor slot is in use.
+ */
+static inline int32_t IsActorPresent(const Actor *actor) {
+    return actor->actorType != ACTOR_NONE;
+}
+
+/**
+ * Recalculate the relation table from the actors' current positions.
+ *
+ * Normally you should call GetActorRelations instead, which only does this once per frame.
+ *
+ * @param relations Table to fill in.
+ */
+static inline void CalculateActorRelations(ActorRelations *relations) {
+    for (int32_t i = 0; i < NUM_ACTORS; i++) {
+        relations->distanceSquared[i][i] = 0;
+        relations->angle[i][i] = 0;
+
+        for (int32_t j = i + 1; j < NUM_ACTORS; j++) {
+            int32_t dx = Actors[j].x - Actors[i].x;
+            int32_t dz = Actors[j].z - Actors[i].z;
+            int32_t distance = ACTOR_DISTANCE_NONE;
+            int16_t angle = 0, reverseAngle = 0;
+
+            // sqrt(INT32_MAX / 2) = 32767.99, so anything larger would overflow
+            if (IsActorPresent(&Actors[i]) && IsActorPresent(&Actors[j])
+                && dx > -32768 && dx < 32768 && dz > -32768 && dz < 32768) {
+                distance = dx * dx + dz * dz;
+                angle = (int16_t)(ratan2(dx, dz) & 0xfff);
+                reverseAngle = (int16_t)((angle + 2048) & 0xfff);
+            }
+
+            relations->distanceSquared[i][j] = relations->distanceSquared[j][i] = distance;
+            relations->angle[i][j] = angle;
+            relations->angle[j][i] = reverseAngle;
+        }
+    }
+
+    // insertion sort of the other three actors by distance
+    for (int32_t i = 0; i < NUM_ACTORS; i++) {
+        int16_t *indexes = relations->indexesByDistance[i];
+        int32_t count = 0;
+
+        for (int32_t j = 0; j < NUM_ACTORS; j++) {
+            int32_t k;
+
+            if (j == i)
+                continue;
+
+            for (k = count; k > 0 && relations->distanceSquared[i][indexes[k - 1]] > relations->distanceSquared[i][j]; k--)
+                indexes[k] = indexes[k - 1];
+            indexes[k] = (int16_t)j;
+            count++;
+        }
+    }
+
+    relations->frame = FrameCount;
+    relations->isValid = 1;
+}
+
+/**
+ * Get the relation table for the current frame, calculating it if this is the first request this frame.
+ *
+ * @return The relation table.
+ */
+static inline const ActorRelations *GetActorRelations(void) {
+    if (!ActorRelationCache.isValid || ActorRelationCache.frame != FrameCount)
+        CalculateActorRelations(&ActorRelationCache);
+
+    return &ActorRelationCache;
+}
+
+/**
+ * Get the squared distance between two actors in the current frame.
+ *
+ * @param from Index of the first actor.
+ * @param to Index of the second actor.
+ * @return Squared distance on the floor plane, or ACTOR_DISTANCE_NONE if either actor slot is unused.
+ */
+static inline int32_t GetActorDistanceSquared(int32_t from, int32_t to) {
+    return GetActorRelations()->distanceSquared[from][to];
+}
+
+/**
+ * Get the direction from one actor to another in the current frame.
+ *
+ * @param from Index of the actor to measure from.
+ * @param to Index of the actor to measure to.
+ * @return Angle from 0 to 4095, where 4096 is a full turn.
+ */
+static inline int16_t GetActorAngle(int32_t from, int32_t to) {
+    return GetActorRelations()->angle[from][to];
+}
+
+/**
+ * Get the index of the nearest other actor in the current frame.
+ *
+ * @param from Index of the actor to measure from.
+ * @return Index of the nearest actor, or -1 if there are no other actors in the room.
+ */
+static inline int32_t GetNearestActor(int32_t from) {
+    const ActorRelations *relations = GetActorRelations();
+    int32_t nearest = relations->indexesByDistance[from][0];
+
+    return relations->distanceSquared[from][nearest] == ACTOR_DISTANCE_NONE ? -1 : nearest;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,383 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+#include <galerians/arena.h>
+
+#ifdef GALERIANS_USE_PSYQ
+#include <LIBGPU.H>
+#else
+#include <psxgpu.h>
+#endif
+
+/**
+ * Drawing custom primitives from a module.
+ *
+ * Primitives are allocated from a per-frame packet pool and linked into an ordering table owned by the module, so
+ * drawing doesn't allocate anything from the game and can't run the engine's own packet buffer out of space. The pool
+ * and ordering table are double-buffered, with one buffer being filled while the GPU may still be drawing the other,
+ * and both buffers are allocated from the room arena the first time they're used in a room.
+ *
+ * Each frame, call BeginRenderFrame, add primitives with the NewRender functions (or AllocRenderPacket and
+ * AddRenderPrim for other primitive types), and call EndRenderFrame. By default EndRenderFrame draws the module's
+ * ordering table with DrawOTag, on top of whatever is already in the draw buffer. If the address of an entry in the
+ * engine's ordering table is known (PickUpFile, for instance, is given an index into the engine's table), pass it to
+ * SetRenderTarget to splice the module's table into the engine's at that depth instead. The splice has to happen after
+ * the engine clears its table for the frame and before it's drawn.
+ *
+ * As with ClearOTagR, depth 0 is in front and higher depths are drawn first.
+ */
+
+/**
+ * Number of depths in the module's ordering table. Define this before including the header to change it.
+ */
+#ifndef RENDER_OT_LENGTH
+#define RENDER_OT_LENGTH        16
+#endif
+
+/**
+ * Size in bytes of each of the two packet pools, used if BeginRenderFrame has to set up rendering itself. Define this
+ * before including the header to change it, or call InitRender with a different size.
+ */
+#ifndef RENDER_PACKET_POOL_SIZE
+#define RENDER_PACKET_POOL_SIZE 4096
+#endif
+
+#define RENDER_OT_TERMINATOR    0x00FFFFFF
+#define RENDER_ADDRESS_MASK     0x00FFFFFF
+
+/**
+ * One of the two sets of rendering buffers.
+ */
+typedef struct _RenderBuffer {
+    uint32_t *ot;
+    uint8_t *start;
+    uint8_t *next;
+    uint8_t *end;
+} RenderBuffer;
+
+/**
+ * State of module rendering.
+ *
+ * This is weak so that each source file including this header shares the same state. It's reset automatically when
+ * the player changes rooms, since the buffers are in the room arena. Don't access it directly; use the functions below.
+ */
+typedef struct _RenderState {
+    uint32_t stageId;
+    uint16_t mapId;
+    uint16_t roomId;
+    RenderBuffer buffers[2];
+    uint32_t *target;           // engine ordering table entry to splice into, or NULL to use DrawOTag
+    uint32_t droppedPrims;      // primitives that didn't fit in the pool
+    uint16_t frame;             // frame the current buffer was started on
+    uint8_t current;            // index of the buffer being filled
+    uint8_t initialized;
+} RenderState;
+
+__attribute__((weak)) RenderState Render;
+
+/**
+ * Check whether the rendering buffers are set up for the current room.
+ */
+static inline int32_t IsRenderInitialized(void) {
+    return Render.initialized && Render.stageId == Game.stageId && Render.mapId == Game.mapId &&
+           Render.roomId == Game.roomId;
+}
+
+/**
+ * Allocate the rendering buffers from the room arena.
+ *
+ * This is called automatically by BeginRenderFrame with RENDER_PACKET_POOL_SIZE if it hasn't been called in the current
+ * room. Call it first to use a different size.
+ *
+ * @param poolSize Size in bytes of each of the two packet pools.
+ * @return Non-zero if the buffers were allocated, or 0 if there isn't enough space in the room arena. Nothing is
+ *         allocated if it fails.
+ */
+static inline int32_t InitRender(size_t poolSize) {
+    uint32_t i;
+
+    // check the space for everything up front, so a failure doesn't leave the first buffer allocated. BeginRenderFrame
+    // calls this again every frame until it succeeds, which would otherwise use up the arena.
+    poolSize = (poolSize + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    Render.initialized = 0;
+    if (ArenaRemaining(GetRoomArena()) < 2 * (RENDER_OT_LENGTH * sizeof(uint32_t) + poolSize) + ARENA_ALIGNMENT - 1)
+        return 0;
+
+    Render.stageId = Game.stageId;
+    Render.mapId = Game.mapId;
+    Render.roomId = Game.roomId;
+    Render.target = NULL;
+    Render.droppedPrims = 0;
+    Render.current = 0;
+    Render.frame = (uint16_t)(FrameCount - 1);
+
+    for (i = 0; i < 2; i++) {
+        RenderBuffer *buffer = &Render.buffers[i];
+        buffer->ot = (uint32_t *)RoomAlloc(RENDER_OT_LENGTH * sizeof(uint32_t));
+        buffer->start = (uint8_t *)RoomAlloc(poolSize);
+        if (buffer->ot == NULL || buffer->start == NULL)
+            return 0;
+        buffer->next = buffer->start;
+        buffer->end = buffer->start + poolSize;
+    }
+
+    Render.initialized = 1;
+    return 1;
+}
+
+/**
+ * Splice the module's ordering table into one of the engine's ordering table entries, or go back to drawing it with
+ * DrawOTag.
+ *
+ * @param otEntry Entry in the engine's ordering table, or NULL.
+ */
+static inline void SetRenderTarget(uint32_t *otEntry) {
+    Render.target = otEntry;
+}
+
+/**
+ * Get the buffer being filled this frame.
+ */
+static inline RenderBuffer *GetRenderBuffer(void) {
+    return &Render.buffers[Render.current];
+}
+
+/**
+ * Start adding primitives for a new frame.
+ *
+ * Switches to the other buffer and clears it. Calling this again on the same frame does nothing, so primitives from
+ * several places can go in the same frame.
+ *
+ * @return Non-zero if primitives can be added, or 0 if the buffers couldn't be allocated.
+ */
+static inline int32_t BeginRenderFrame(void) {
+    RenderBuffer *buffer;
+    uint32_t i;
+
+    if (!IsRenderInitialized() && !InitRender(RENDER_PACKET_POOL_SIZE))
+        return 0;
+    if (Render.frame == FrameCount)
+        return 1;
+
+    Render.frame = FrameCount;
+    Render.current ^= 1;
+    buffer = GetRenderBuffer();
+    buffer->next = buffer->start;
+
+    // same layout as ClearOTagR: each entry links to the one before it, and entry 0 ends the list
+    buffer->ot[0] = RENDER_OT_TERMINATOR;
+    for (i = 1; i < RENDER_OT_LENGTH; i++)
+        buffer->ot[i] = (uint32_t)(uintptr_t)&buffer->ot[i - 1] & RENDER_ADDRESS_MASK;
+    return 1;
+}
+
+/**
+ * Allocate space for a primitive from this frame's packet pool.
+ *
+ * @param size Size of the primitive in bytes.
+ * @return Pointer to the space, or NULL if the pool is full or BeginRenderFrame hasn't been called.
+ */
+static inline void *AllocRenderPacket(size_t size) {
+    RenderBuffer *buffer = GetRenderBuffer();
+    uint8_t *packet = buffer->next;
+
+    size = (size + 3) & ~(size_t)3;
+    if (!IsRenderInitialized() || packet == NULL || size > (size_t)(buffer->end - packet)) {
+        Render.droppedPrims++;
+        return NULL;
+    }
+
+    buffer->next = packet + size;
+    return packet;
+}
+
+/**
+ * Link an initialized primitive into this frame's ordering table, like addPrim.
+ *
+ * @param depth Depth to draw the primitive at. Depths past the end of the table are clamped to the back.
+ * @param prim The primitive. Its length must already be set (e.g. with setPolyFT4).
+ */
+static inline void AddRenderPrim(uint32_t depth, void *prim) {
+    uint32_t *ot = GetRenderBuffer()->ot;
+    uint32_t *tag = (uint32_t *)prim;
+
+    if (depth >= RENDER_OT_LENGTH)
+        depth = RENDER_OT_LENGTH - 1;
+    *tag = (*tag & ~(uint32_t)RENDER_ADDRESS_MASK) | (ot[depth] & RENDER_ADDRESS_MASK);
+    ot[depth] = (ot[depth] & ~(uint32_t)RENDER_ADDRESS_MASK) | ((uint32_t)(uintptr_t)prim & RENDER_ADDRESS_MASK);
+}
+
+/**
+ * Allocate and link a flat-shaded line.
+ *
+ * @return The line, or NULL if the pool is full.
+ */
+static inline LINE_F2 *NewRenderLineF2(uint32_t depth, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t r,
+                                       uint8_t g, uint8_t b) {
+    LINE_F2 *line = (LINE_F2 *)AllocRenderPacket(sizeof(LINE_F2));
+
+    if (line == NULL)
+        return NULL;
+    setLineF2(line);
+    line->r0 = r;
+    line->g0 = g;
+    line->b0 = b;
+    line->x0 = x0;
+    line->y0 = y0;
+    line->x1 = x1;
+    line->y1 = y1;
+    AddRenderPrim(depth, line);
+    return line;
+}
+
+/**
+ * Allocate and link a flat-shaded rectangle.
+ *
+ * @return The rectangle, or NULL if the pool is full.
+ */
+static inline TILE *NewRenderTile(uint32_t depth, int16_t x, int16_t y, int16_t w, int16_t h, uint8_t r, uint8_t g,
+                                  uint8_t b) {
+    TILE *tile = (TILE *)AllocRenderPacket(sizeof(TILE));
+
+    if (tile == NULL)
+        return NULL;
+    setTile(tile);
+    tile->r0 = r;
+    tile->g0 = g;
+    tile->b0 = b;
+    tile->x0 = x;
+    tile->y0 = y;
+    tile->w = w;
+    tile->h = h;
+    AddRenderPrim(depth, tile);
+    return tile;
+}
+
+/**
+ * Allocate and link a flat-shaded quad. The caller fills in the color and vertices.
+ *
+ * @return The quad, or NULL if the pool is full.
+ */
+static inline POLY_F4 *NewRenderPolyF4(uint32_t depth) {
+    POLY_F4 *poly = (POLY_F4 *)AllocRenderPacket(sizeof(POLY_F4));
+
+    if (poly == NULL)
+        return NULL;
+    setPolyF4(poly);
+    AddRenderPrim(depth, poly);
+    return poly;
+}
+
+/**
+ * Allocate and link a flat-shaded textured quad. The caller fills in the color, vertices, texture coordinates, CLUT,
+ * and texture page.
+ *
+ * @return The quad, or NULL if the pool is full.
+ */
+static inline POLY_FT4 *NewRenderPolyFT4(uint32_t depth) {
+    POLY_FT4 *poly = (POLY_FT4 *)AllocRenderPacket(sizeof(POLY_FT4));
+
+    if (poly == NULL)
+        return NULL;
+    setPolyFT4(poly);
+    AddRenderPrim(depth, poly);
+    return poly;
+}
+
+/**
+ * Finish the frame's primitives and send them to be drawn.
+ *
+ * Either splices the module's ordering table into the engine's (see SetRenderTarget) or draws it with DrawOTag.
+ */
+static inline void EndRenderFrame(void) {
+    RenderBuffer *buffer;
+    uint32_t *head;
+
+    if (!IsRenderInitialized() || Render.frame != FrameCount)
+        return;
+
+    buffer = GetRenderBuffer();
+    head = &buffer->ot[RENDER_OT_LENGTH - 1];
+    if (Render.target != NULL) {
+        buffer->ot[0] = (buffer->ot[0] & ~(uint32_t)RENDER_ADDRESS_MASK) | (*Render.target & RENDER_ADDRESS_MASK);
+        *Render.target = (*Render.target & ~(uint32_t)RENDER_ADDRESS_MASK) |
+                         ((uint32_t)(uintptr_t)head & RENDER_ADDRESS_MASK);
+    } else {
+#ifdef GALERIANS_USE_PSYQ
+        DrawOTag((u_long *)head);
+#else
+        DrawOTag(head);
+#endif
+    }
+}
+
+/**
+ * Draw a top-down map of colliders as outlines, for debugging.
+ *
+ * Walls and rectangles are drawn in red, triangles in green, and circles as their bounding squares in blue. Room x
+ * goes to the right and room z goes up the screen.
+ *
+ * @param depth Depth to draw the map at.
+ * @param colliders Colliders to draw, e.g. from a RoomLayout.
+ * @param numColliders Number of colliders.
+ * @param originX Screen x position of room x = 0.
+ * @param originY Screen y position of room z = 0.
+ * @param shift Room coordinates are divided by 2^shift to get screen coordinates.
+ */
+static inline void DrawColliderMap(uint32_t depth, const Collider *colliders, uint32_t numColliders, int16_t originX,
+                                   int16_t originY, uint32_t shift) {
+    uint32_t i;
+
+#define RENDER_MAP_X(x) ((int16_t)(originX + ((x) >> shift)))
+#define RENDER_MAP_Y(z) ((int16_t)(originY - ((z) >> shift)))
+    for (i = 0; i < numColliders; i++) {
+        const Collider *collider = &colliders[i];
+        switch (collider->type) {
+            case COLLIDER_WALL:
+            case COLLIDER_RECT: {
+                const RectangleCollider *rect = (const RectangleCollider *)collider->shape;
+                int16_t x0 = RENDER_MAP_X(rect->xPos), x1 = RENDER_MAP_X(rect->xPos + rect->xSize);
+                int16_t y0 = RENDER_MAP_Y(rect->zPos), y1 = RENDER_MAP_Y(rect->zPos + rect->zSize);
+                NewRenderLineF2(depth, x0, y0, x1, y0, 255, 0, 0);
+                NewRenderLineF2(depth, x1, y0, x1, y1, 255, 0, 0);
+                NewRenderLineF2(depth, x1, y1, x0, y1, 255, 0, 0);
+                NewRenderLineF2(depth, x0, y1, x0, y0, 255, 0, 0);
+                break;
+            }
+            case COLLIDER_TRI: {
+                const TriangleCollider *tri = (const TriangleCollider *)collider->shape;
+                int16_t x1 = RENDER_MAP_X(tri->x1), x2 = RENDER_MAP_X(tri->x2), x3 = RENDER_MAP_X(tri->x3);
+                int16_t y1 = RENDER_MAP_Y(tri->z1), y2 = RENDER_MAP_Y(tri->z2), y3 = RENDER_MAP_Y(tri->z3);
+                NewRenderLineF2(depth, x1, y1, x2, y2, 0, 255, 0);
+                NewRenderLineF2(depth, x2, y2, x3, y3, 0, 255, 0);
+                NewRenderLineF2(depth, x3, y3, x1, y1, 0, 255, 0);
+                break;
+            }
+            case COLLIDER_CIRCLE: {
+                const CircleCollider *circle = (const CircleCollider *)collider->shape;
+                int16_t x0 = RENDER_MAP_X(circle->x - circle->radius), x1 = RENDER_MAP_X(circle->x + circle->radius);
+                int16_t y0 = RENDER_MAP_Y(circle->z - circle->radius), y1 = RENDER_MAP_Y(circle->z + circle->radius);
+                NewRenderLineF2(depth, x0, y0, x1, y0, 0, 0, 255);
+                NewRenderLineF2(depth, x1, y0, x1, y1, 0, 0, 255);
+                NewRenderLineF2(depth, x1, y1, x0, y1, 0, 0, 255);
+                NewRenderLineF2(depth, x0, y1, x0, y0, 0, 0, 255);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+#undef RENDER_MAP_X
+#undef RENDER_MAP_Y
+}
+
+#ifdef __cplusplus
+}
+#endif
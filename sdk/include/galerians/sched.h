@@ -0,0 +1,336 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+#include <galerians/api.h>
+
+/**
+ * A cooperative scheduler that runs multiple lightweight coroutines inside a single game task.
+ *
+ * The game only has a few task slots, and each waiting task still gets resumed every frame just to check whether it
+ * can continue. Coroutines instead tell the scheduler what they're waiting for (a number of frames or a combination of
+ * flags), and the scheduler checks the condition itself without resuming the coroutine. Ready coroutines run in order
+ * of priority, and then the scheduler Yields once for the whole frame.
+ *
+ * Coroutines are stackless: a coroutine is a normal function which uses the COROUTINE_* macros to suspend and resume.
+ * Local variables are NOT preserved across a suspension; anything that needs to survive must be stored in the
+ * coroutine's data. A side benefit is that coroutines aren't affected by the task stack bug described in the examples,
+ * because they never Yield themselves. Don't call functions that Yield (like WaitForMessage) from inside a coroutine,
+ * as that would block every other coroutine too; use the COROUTINE_* equivalents instead. The task function that runs
+ * the scheduler DOES Yield, so it should reference globals rather than its own argument after starting the scheduler.
+ *
+ * Example:
+ *
+ *     void blinkLights(Coroutine *co) {
+ *         COROUTINE_BEGIN(co);
+ *         for (;;) {
+ *             ToggleLights();
+ *             COROUTINE_SLEEP_FRAMES(co, 30);
+ *         }
+ *         COROUTINE_END(co);
+ *     }
+ */
+
+#define SCHEDULER_MAX_COROUTINES 8
+
+#define COROUTINE_INVALID -1
+
+typedef enum _CoroutineState {
+    COROUTINE_FREE,
+    COROUTINE_READY,
+    COROUTINE_SLEEPING,
+    COROUTINE_WAITING,
+    COROUTINE_STARTING,                 // started during the current frame; will run next frame
+} CoroutineState;
+
+typedef struct _Coroutine Coroutine;
+
+/**
+ * Coroutine body. The function is called each time the coroutine is resumed.
+ */
+typedef void (*CoroutineFunc)(Coroutine *co);
+
+struct _Coroutine {
+    CoroutineFunc func;
+    void *data;                         // user data for the coroutine's state
+    int16_t priority;                   // higher priority coroutines run first
+    int16_t state;                      // CoroutineState
+    int32_t resume;                     // where to resume the coroutine from; 0 = beginning
+    uint16_t wakeFrame;                 // FrameCount to wake on when sleeping
+    uint16_t sequence;                  // order the coroutine was started in, for equal priorities
+    const volatile uint32_t *waitFlags; // flags to check when waiting
+    uint32_t waitMask;
+    uint32_t waitValue;
+};
+
+typedef struct _Scheduler {
+    Coroutine coroutines[SCHEDULER_MAX_COROUTINES];
+    uint16_t nextSequence;
+} Scheduler;
+
+/**
+ * Begin the body of a coroutine. Must be the first statement in the coroutine function.
+ */
+#define COROUTINE_BEGIN(co) switch ((co)->resume) { case 0:
+
+/**
+ * End the body of a coroutine. Must be the last statement in the coroutine function. When the coroutine reaches this
+ * point, it's removed from the scheduler.
+ */
+#define COROUTINE_END(co) } (co)->state = COROUTINE_FREE; return
+
+/**
+ * Suspend the coroutine until the next frame.
+ */
+#define COROUTINE_YIELD(co) COROUTINE_YIELD_AT(co, __COUNTER__ + 1)
+
+// each suspension point needs a unique resume value. this uses __COUNTER__ rather than __LINE__ so that macros which
+// suspend more than once (like COROUTINE_WAIT_FOR_MESSAGE) work. 0 is reserved for the beginning of the coroutine.
+#define COROUTINE_YIELD_AT(co, n) do { (co)->resume = (n); return; case (n):; } while (0)
+
+/**
+ * Suspend the coroutine for the given number of frames.
+ *
+ * @param co The coroutine.
+ * @param n Number of frames to sleep, from 1 to 32767.
+ */
+#define COROUTINE_SLEEP_FRAMES(co, n) do { \
+    (co)->wakeFrame = (uint16_t)(FrameCount + (n)); \
+    (co)->state = COROUTINE_SLEEPING; \
+    COROUTINE_YIELD(co); \
+} while (0)
+
+/**
+ * Suspend the coroutine until (*ptr & mask) == value.
+ *
+ * If the condition is already true, the coroutine continues immediately.
+ *
+ * @param co The coroutine.
+ * @param ptr Pointer to the flags to check, e.g. &Game.flags03C.
+ * @param mask Flag bits to check.
+ * @param value Value the masked flags must have.
+ */
+#define COROUTINE_WAIT_FOR_FLAGS(co, ptr, mask, value) do { \
+    if ((*(ptr) & (mask)) != (value)) { \
+        (co)->waitFlags = (ptr); \
+        (co)->waitMask = (mask); \
+        (co)->waitValue = (value); \
+        (co)->state = COROUTINE_WAITING; \
+        COROUTINE_YIELD(co); \
+    } \
+} while (0)
+
+/**
+ * Show a message and suspend the coroutine until it completes. This is the coroutine equivalent of WaitForMessage.
+ * Afterwards, PlayerSelectedYes can be used to check the player's response.
+ *
+ * @param co The coroutine.
+ * @param messageId ID of the message to show.
+ */
+#define COROUTINE_WAIT_FOR_MESSAGE(co, messageId) do { \
+    ShowMessage(messageId); \
+    COROUTINE_WAIT_FOR_FLAGS(co, &Game.flags03C, STATE_DISPLAYING_MESSAGE, STATE_DISPLAYING_MESSAGE); \
+    COROUTINE_WAIT_FOR_FLAGS(co, &Game.flags03C, STATE_DISPLAYING_MESSAGE, 0); \
+} while (0)
+
+/**
+ * Initialize a scheduler with no coroutines.
+ *
+ * @param sched The scheduler.
+ */
+static inline void InitScheduler(Scheduler *sched) {
+    for (int32_t i = 0; i < SCHEDULER_MAX_COROUTINES; i++)
+        sched->coroutines[i].state = COROUTINE_FREE;
+    sched->nextSequence = 0;
+}
+
+/**
+ * Add a coroutine to the scheduler.
+ *
+ * The coroutine will first run on the scheduler's next frame.
+ *
+ * @param sched The scheduler.
+ * @param func Coroutine function.
+ * @param data User data for the coroutine, available as co->data.
+ * @param priority Coroutines with higher priorities run first each frame. Coroutines with the same priority run in the
+ *                 order they were started.
+ * @return Handle to the coroutine, or COROUTINE_INVALID if the scheduler is full.
+ */
+static inline int32_t StartCoroutine(Scheduler *sched, CoroutineFunc func, void *data, int16_t priority) {
+    for (int32_t i = 0; i < SCHEDULER_MAX_COROUTINES; i++) {
+        Coroutine *co = &sched->coroutines[i];
+        if (co->state != COROUTINE_FREE)
+            continue;
+
+        co->func = func;
+        co->data = data;
+        co->priority = priority;
+        co->state = COROUTINE_STARTING;
+        co->resume = 0;
+        co->sequence = sched->nextSequence++;
+        return i;
+    }
+
+    return COROUTINE_INVALID;
+}
+
+/**
+ * Check whether a coroutine is still running (including sleeping or waiting).
+ *
+ * @param sched The scheduler.
+ * @param handle Coroutine handle returned by StartCoroutine.
+ */
+static inline int32_t IsCoroutineRunning(const Scheduler *sched, int32_t handle) {
+    return handle != COROUTINE_INVALID && sched->coroutines[handle].state != COROUTINE_FREE;
+}
+
+/**
+ * Stop a coroutine. It won't be resumed again, and its slot can be reused by StartCoroutine.
+ *
+ * @param sched The scheduler.
+ * @param handle Coroutine handle returned by StartCoroutine.
+ */
+static inline void StopCoroutine(Scheduler *sched, int32_t handle) {
+    if (handle != COROUTINE_INVALID)
+        sched->coroutines[handle].state = COROUTINE_FREE;
+}
+
+/**
+ * Check whether a suspended coroutine can be resumed.
+ */
+static inline int32_t IsCoroutineReady(Coroutine *co) {
+    switch (co->state) {
+        case COROUTINE_SLEEPING:
+            // signed difference so this works across FrameCount wrapping around
+            if ((int16_t)(FrameCount - co->wakeFrame) < 0)
+                return 0;
+            break;
+        case COROUTINE_WAITING:
+            if ((*co->waitFlags & co->waitMask) != co->waitValue)
+                return 0;
+            break;
+        case COROUTINE_READY:
+            return 1;
+        default:
+            // free or started this frame
+            return 0;
+    }
+
+    co->state = COROUTINE_READY;
+    return 1;
+}
+
+/**
+ * Check whether coroutine a should run before coroutine b.
+ */
+static inline int32_t CoroutineRunsBefore(const Coroutine *a, const Coroutine *b) {
+    if (a->priority != b->priority)
+        return a->priority > b->priority;
+    // signed difference so this works across the sequence number wrapping around
+    return (int16_t)(a->sequence - b->sequence) < 0;
+}
+
+/**
+ * Run one frame of the scheduler without yielding.
+ *
+ * Every coroutine whose wait condition is satisfied is resumed once, in priority order. Coroutines started during the
+ * frame first run on the next frame.
+ *
+ * @param sched The scheduler.
+ * @return The number of coroutines still running.
+ */
+static inline int32_t RunSchedulerFrame(Scheduler *sched) {
+    int8_t order[SCHEDULER_MAX_COROUTINES];
+    int32_t i, numToRun = 0, numLive = 0;
+
+    // insertion sort of the live coroutines by priority
+    for (i = 0; i < SCHEDULER_MAX_COROUTINES; i++) {
+        Coroutine *co = &sched->coroutines[i];
+        int32_t pos;
+
+        if (co->state == COROUTINE_FREE)
+            continue;
+        if (co->state == COROUTINE_STARTING)
+            co->state = COROUTINE_READY;
+
+        for (pos = numToRun; pos > 0 && CoroutineRunsBefore(co, &sched->coroutines[order[pos - 1]]); pos--)
+            order[pos] = order[pos - 1];
+        order[pos] = (int8_t)i;
+        numToRun++;
+    }
+
+    for (i = 0; i < numToRun; i++) {
+        Coroutine *co = &sched->coroutines[order[i]];
+        if (IsCoroutineReady(co))
+            co->func(co);
+    }
+
+    for (i = 0; i < SCHEDULER_MAX_COROUTINES; i++) {
+        if (sched->coroutines[i].state != COROUTINE_FREE)
+            numLive++;
+    }
+
+    return numLive;
+}
+
+/**
+ * Run the scheduler until (*ptr & mask) == value, yielding once per frame.
+ *
+ * The condition is checked before each frame, so this returns without running the scheduler or yielding if it already
+ * holds. If all coroutines finish first, the scheduler keeps yielding until the condition is met. Note that all the
+ * masked bits have to match value; to wait until any one of several bits is set, as the loop at the end of a room
+ * function does, check them separately. This must be called from a game task.
+ *
+ * @param sched The scheduler.
+ * @param ptr Pointer to the flags to check.
+ * @param mask Flag bits to check.
+ * @param value Value the masked flags must have.
+ */
+static inline void RunSchedulerUntilFlags(Scheduler *sched, const volatile uint32_t *ptr, uint32_t mask,
+                                          uint32_t value) {
+    while ((*ptr & mask) != value) {
+        RunSchedulerFrame(sched);
+        Yield();
+    }
+}
+
+/**
+ * Run the scheduler until all coroutines have finished, yielding once per frame. This must be called from a game task.
+ *
+ * @param sched The scheduler.
+ */
+static inline void RunScheduler(Scheduler *sched) {
+    while (RunSchedulerFrame(sched) > 0)
+        Yield();
+}
+
+/**
+ * Yield for the given number of frames. This must be called from a game task, not a coroutine.
+ *
+ * @param n Number of frames to wait.
+ */
+static inline void SleepFrames(int32_t n) {
+    while (n-- > 0)
+        Yield();
+}
+
+/**
+ * Yield until (*ptr & mask) == value. This must be called from a game task, not a coroutine.
+ *
+ * @param ptr Pointer to the flags to check.
+ * @param mask Flag bits to check.
+ * @param value Value the masked flags must have.
+ */
+static inline void WaitForFlags(const volatile uint32_t *ptr, uint32_t mask, uint32_t value) {
+    while ((*ptr & mask) != value)
+        Yield();
+}
+
+#ifdef __cplusplus
+}
+#endif
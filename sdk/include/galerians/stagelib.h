@@ -0,0 +1,143 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <galerians/types.h>
+#include <galerians/globals.h>
+#include <galerians/api.h>
+
+/**
+ * Code shared by the room modules of a stage.
+ *
+ * Every room module normally links its own copy of any helper it uses, so the same code is stored many times in
+ * MODULE.BIN and read from the CD again on every room change. A stage library is a separate module, linked with
+ * *_stage.ld, that lives at the top of the room module region. Room modules linked against it call its functions
+ * through a jump table at a fixed address, and load it with LoadStageLibrary, which only reads it from the CD if it
+ * isn't already in memory. Since room modules are loaded below the library, it stays resident as the player moves
+ * between rooms that use it, and is typically only loaded once after each ChangeStage.
+ *
+ * To build a library, mark the functions rooms can call with STAGE_EXPORT and link with *_stage.ld. Then run
+ * `python -m galsdk.stagelib -i <index in MODULE.BIN> -o <symbol file> <library>` (the Makefile's link_stage_library
+ * does this), which writes a linker script with the address of each export. Link room modules with that file after the
+ * usual linker script, declare the exported functions as normal, and call LoadStageLibrary before using any of them.
+ * The symbol file also moves ModuleRegionEnd down to the start of the library, so RoomAlloc can't overwrite it.
+ *
+ * Rooms must be relinked whenever the library changes. LoadStageLibrary checks the library's checksum against the one
+ * the room was linked with and fails rather than calling into a mismatched library.
+ *
+ * The library is loaded by room modules rather than the game, so it doesn't have a module ID. It can't use the room
+ * arena (there's no ModuleEnd in a library link), and its globals keep their values across rooms until it's reloaded.
+ */
+
+#define STAGE_LIBRARY_MAGIC     0x47545347  // "GSTG"
+#define STAGE_LIBRARY_VERSION   1
+
+/**
+ * Size of the memory reserved for a stage library at the top of the room module region. This must match the STAGE
+ * region in the *_stage.ld linker scripts.
+ */
+#define STAGE_LIBRARY_SIZE      8192
+
+/**
+ * Header at the start of a stage library, written by the *_stage.ld linker scripts.
+ *
+ * The layout must be kept in sync with the linker scripts and galsdk/stagelib.py.
+ */
+typedef struct _StageLibraryHeader {
+    uint32_t magic;         // 00
+    uint16_t version;       // 04
+    uint16_t numExports;    // 06
+    uint32_t codeSize;      // 08 size of the jump table, code, and read-only data following the header
+    uint32_t checksum;      // 0C checksum of those codeSize bytes, filled in by galsdk.stagelib
+    uint32_t fileSize;      // 10 size of the library file, including this header
+} StageLibraryHeader;
+_Static_assert(sizeof(StageLibraryHeader) == 0x14, "sizeof(StageLibraryHeader) not correct");
+
+/**
+ * Add a function to the library's jump table so room modules can call it.
+ *
+ * Use this at file scope in the library's source, after the function's declaration. Each export is a jump to the
+ * function plus its delay slot, so calls from rooms cost two extra instructions. galsdk.stagelib's symbol file defines
+ * a symbol with the function's name at the address of its jump, so room modules can declare and call it like any other
+ * function.
+ *
+ * @param func Name of the function to export. It must not be static.
+ */
+#define STAGE_EXPORT(func)                              \
+    __asm__(                                            \
+        ".pushsection STAGE_EXPORTS,\"ax\",@progbits\n" \
+        ".globl StageExport_" #func "\n"                \
+        "StageExport_" #func ":\n"                      \
+        ".set push\n"                                   \
+        ".set noreorder\n"                              \
+        "j " #func "\n"                                 \
+        "nop\n"                                         \
+        ".set pop\n"                                    \
+        ".popsection\n"                                 \
+    )
+
+// defined by the library's symbol file. the addresses of StageLibraryIndex and StageLibraryChecksum are their values.
+// without a symbol file, the room linker scripts put StageLibraryStart at the end of the region.
+extern uint8_t StageLibraryStart[];
+extern uint8_t StageLibraryIndex[];
+extern uint8_t StageLibraryChecksum[];
+
+/**
+ * Calculate the checksum of a loaded stage library, the same way galsdk.stagelib does.
+ *
+ * @param header The library.
+ * @return Checksum of the code following the header.
+ */
+static inline uint32_t ComputeStageLibraryChecksum(const StageLibraryHeader *header) {
+    const uint32_t *words = (const uint32_t *)(header + 1);
+    uint32_t count = header->codeSize / 4;
+    uint32_t checksum = 0;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+        checksum = ((checksum << 1) | (checksum >> 31)) + words[i];
+    return checksum;
+}
+
+/**
+ * Check whether the library this room was linked against is in memory and intact.
+ *
+ * Rooms that don't use the library are free to use its memory, so this checks the whole code checksum rather than just
+ * the header.
+ *
+ * @return Non-zero if the library is loaded.
+ */
+static inline int32_t IsStageLibraryLoaded(void) {
+    const StageLibraryHeader *header = (const StageLibraryHeader *)StageLibraryStart;
+
+    return header->magic == STAGE_LIBRARY_MAGIC && header->version == STAGE_LIBRARY_VERSION &&
+           header->checksum == (uint32_t)(uintptr_t)StageLibraryChecksum &&
+           header->fileSize >= sizeof(StageLibraryHeader) && header->fileSize <= STAGE_LIBRARY_SIZE &&
+           header->codeSize <= header->fileSize - sizeof(StageLibraryHeader) &&
+           ComputeStageLibraryChecksum(header) == header->checksum;
+}
+
+/**
+ * Load the library this room was linked against if it isn't already in memory.
+ *
+ * Call this at the start of the room function, before calling any of the library's functions. The load blocks until it
+ * completes.
+ *
+ * @return Non-zero if the library is ready to use, or 0 if the library in MODULE.BIN doesn't match the one the room was
+ *         linked against.
+ */
+static inline int32_t LoadStageLibrary(void) {
+    if (IsStageLibraryLoaded())
+        return 1;
+    LoadFileFromDb(&ModuleDb, (uint32_t)(uintptr_t)StageLibraryIndex, StageLibraryStart);
+    // the instruction cache may still hold code from the library (or room) that was previously at this address
+    FlushCache();
+    return IsStageLibraryLoaded();
+}
+
+#ifdef __cplusplus
+}
+#endif
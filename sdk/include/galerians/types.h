@@ -6,6 +6,11 @@ extern "C" {
 
 #include <stdint.h>
 
+// C++ spells this static_assert
+#if defined(__cplusplus) && !defined(_Static_assert)
+#define _Static_assert static_assert
+#endif
+
 // we need some types from the PSX SDK. I'm going to use PSn00bSDK, but we'll have an option for PSYQ as well.
 #ifdef GALERIANS_USE_PSYQ
 #include <LIBGTE.H>
@@ -0,0 +1,375 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <galerians/types.h>
+
+#ifdef GALERIANS_USE_PSYQ
+#include <LIBGPU.H>
+#else
+#include <psxgpu.h>
+#endif
+
+/**
+ * Streaming TIM images to VRAM through a small ring buffer.
+ *
+ * Normally an image is loaded into a buffer big enough for the whole file before it's copied to VRAM. A TimStream
+ * instead takes the file a few sectors at a time: the producer writes data into free space in the ring buffer
+ * (TimStreamReserve/TimStreamCommit, so a reader can fill the ring directly without an extra copy, or TimStreamWrite
+ * to copy from somewhere else), and PumpTimStream parses the TIM and starts a DMA of each piece of the CLUT or image to
+ * its VRAM rectangle as soon as it's in the buffer. Space in the ring is released once its DMA completes, so the peak
+ * RAM use is the size of the ring rather than the size of the image, and uploading overlaps reading.
+ *
+ * The game's loader only reads whole files, so the producer has to be something that can deliver the file in pieces,
+ * such as a decompressor or a sector-level reader.
+ *
+ * Uploads go through the EXE's LoadImage, so they're queued in libgpu's command queue along with the engine's own
+ * drawing (DrawOTag, including EndRenderFrame in render.h) instead of competing with it for the GPU. A new upload is
+ * only queued once the queue is empty, and ring space is released once it's empty again.
+ */
+
+#define TIM_MAGIC           0x10
+#define TIM_FLAG_HAS_CLUT   0x08
+#define TIM_HEADER_SIZE     8
+#define TIM_BLOCK_HEADER_SIZE 12
+
+/**
+ * A rectangle in VRAM, in 16-bit units.
+ */
+typedef struct _VramRect {
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+} VramRect;
+
+/**
+ * Check whether the GPU still has queued work, which includes any upload to VRAM that hasn't finished.
+ */
+static inline int32_t IsVramUploadBusy(void) {
+    return DrawSync(1) != 0;
+}
+
+/**
+ * Wait for any upload to VRAM (and anything else queued for the GPU) to finish.
+ */
+static inline void WaitVramUpload(void) {
+    DrawSync(0);
+}
+
+/**
+ * Start copying data from RAM to a rectangle in VRAM.
+ *
+ * The copy is queued with LoadImage and continues in the background; use IsVramUploadBusy to check when the data can
+ * be reused.
+ *
+ * @param rect Rectangle to copy to. w * h must be at least 1.
+ * @param data Pixel data, w * h 16-bit values. Must be word-aligned.
+ * @return Non-zero if the upload was started, or 0 if the GPU is busy and nothing was done.
+ */
+static inline int32_t StartVramUpload(const VramRect *rect, const void *data) {
+    RECT area;
+
+    if (IsVramUploadBusy())
+        return 0;
+
+    area.x = rect->x;
+    area.y = rect->y;
+    area.w = rect->w;
+    area.h = rect->h;
+#ifdef GALERIANS_USE_PSYQ
+    LoadImage(&area, (u_long *)data);
+#else
+    LoadImage(&area, (const uint32_t *)data);
+#endif
+    return 1;
+}
+
+/**
+ * States of a TimStream.
+ */
+#define TIM_STREAM_HEADER       0   // waiting for the TIM header
+#define TIM_STREAM_BLOCK_HEADER 1   // waiting for the header of the CLUT or image block
+#define TIM_STREAM_BLOCK_DATA   2   // uploading the block's data
+#define TIM_STREAM_BLOCK_SKIP   3   // skipping padding after the block's data
+#define TIM_STREAM_DONE         4
+#define TIM_STREAM_ERROR        5
+
+/**
+ * A TIM image being streamed to VRAM.
+ *
+ * Byte positions are running totals of bytes that have passed through the ring, so that they can be compared without
+ * worrying about wrapping.
+ */
+typedef struct _TimStream {
+    uint8_t *ring;
+    uint32_t size;          // ring size in bytes, a multiple of 4
+    uint32_t written;       // bytes committed by the producer
+    uint32_t consumed;      // bytes parsed or handed to an upload
+    uint32_t released;      // bytes whose uploads have finished, so the space can be reused
+    uint32_t inFlight;      // consumed position to release when the current DMA finishes
+    uint32_t state;
+    uint32_t blocksLeft;    // blocks (CLUT and/or image) still to come
+    uint32_t skip;          // padding bytes left to skip
+    VramRect rect;          // current block
+    uint16_t row;           // position of the next pixel to upload in the current block
+    uint16_t column;
+    VramRect clut;          // where the CLUT and image went, for setting up primitives once the stream is done
+    VramRect image;
+    uint32_t flags;         // TIM flags
+    uint32_t scratch;       // word-aligned copy of a pixel that's out of alignment in the ring
+} TimStream;
+
+/**
+ * Start streaming a TIM.
+ *
+ * @param stream Stream to initialize.
+ * @param ring Buffer to use for the ring. Must be word-aligned and must not be used for anything else until the stream
+ *             is done. A few sectors is plenty.
+ * @param size Size of the ring in bytes. Must be a multiple of 4.
+ */
+static inline void InitTimStream(TimStream *stream, void *ring, uint32_t size) {
+    stream->ring = (uint8_t *)ring;
+    stream->size = size & ~3u;
+    stream->written = stream->consumed = stream->released = stream->inFlight = 0;
+    stream->state = TIM_STREAM_HEADER;
+    stream->blocksLeft = 0;
+    stream->skip = 0;
+    stream->row = stream->column = 0;
+    stream->rect.x = stream->rect.y = stream->rect.w = stream->rect.h = 0;
+    stream->clut = stream->image = stream->rect;
+    stream->flags = 0;
+    stream->scratch = 0;
+}
+
+/**
+ * Release ring space whose upload has finished.
+ */
+static inline void ReleaseTimStream(TimStream *stream) {
+    if (stream->released != stream->inFlight && !IsVramUploadBusy())
+        stream->released = stream->inFlight;
+}
+
+/**
+ * Get contiguous free space in the ring for the producer to write to.
+ *
+ * @param stream The stream.
+ * @param size Receives the number of bytes that can be written at the returned pointer. May be 0 if the ring is full.
+ * @return Pointer to the free space.
+ */
+static inline void *TimStreamReserve(TimStream *stream, uint32_t *size) {
+    uint32_t offset = stream->written % stream->size;
+    uint32_t free, toEnd;
+
+    ReleaseTimStream(stream);
+    free = stream->size - (stream->written - stream->released);
+    toEnd = stream->size - offset;
+    *size = free < toEnd ? free : toEnd;
+    return stream->ring + offset;
+}
+
+/**
+ * Mark bytes written to space returned by TimStreamReserve as ready to be uploaded.
+ *
+ * @param stream The stream.
+ * @param size Number of bytes written. Must be no more than the size TimStreamReserve returned.
+ */
+static inline void TimStreamCommit(TimStream *stream, uint32_t size) {
+    stream->written += size;
+}
+
+/**
+ * Copy data into the stream's ring, as much as there's room for.
+ *
+ * @param stream The stream.
+ * @param data Data to copy.
+ * @param size Number of bytes.
+ * @return Number of bytes copied.
+ */
+static inline uint32_t TimStreamWrite(TimStream *stream, const void *data, uint32_t size) {
+    const uint8_t *src = (const uint8_t *)data;
+    uint32_t total = 0;
+
+    while (total < size) {
+        uint32_t space, i;
+        uint8_t *dst = (uint8_t *)TimStreamReserve(stream, &space);
+        if (space == 0)
+            break;
+        if (space > size - total)
+            space = size - total;
+        for (i = 0; i < space; i++)
+            dst[i] = src[total + i];
+        TimStreamCommit(stream, space);
+        total += space;
+    }
+
+    return total;
+}
+
+/**
+ * Read a little-endian value from the ring at the consumed position, which may wrap around the end.
+ */
+static inline uint32_t TimStreamPeek(const TimStream *stream, uint32_t offset, uint32_t numBytes) {
+    uint32_t value = 0, i;
+
+    for (i = 0; i < numBytes; i++)
+        value |= (uint32_t)stream->ring[(stream->consumed + offset + i) % stream->size] << (i * 8);
+    return value;
+}
+
+/**
+ * Upload as much of the current block as is in the ring, one piece at a time.
+ *
+ * LoadImage needs word-aligned data, so pieces are kept to an even number of pixels where possible. If the stream does
+ * get out of alignment (after a single row of an odd width, say), the next pixel is uploaded on its own from a scratch
+ * word to get back into alignment.
+ *
+ * @return Non-zero if progress was made.
+ */
+static inline int32_t PumpTimStreamData(TimStream *stream) {
+    uint32_t offset = stream->consumed % stream->size;
+    uint32_t available = stream->written - stream->consumed;
+    uint32_t toEnd = stream->size - offset;
+    uint32_t halfwords = (available < toEnd ? available : toEnd) / 2;
+    uint32_t width = (uint16_t)stream->rect.w;
+    const void *data = stream->ring + offset;
+    VramRect piece;
+
+    if (halfwords == 0 || IsVramUploadBusy())
+        return 0;
+
+    piece.x = (int16_t)(stream->rect.x + stream->column);
+    piece.y = (int16_t)(stream->rect.y + stream->row);
+    if (offset & 2) {
+        stream->scratch = *(const uint16_t *)data;
+        data = &stream->scratch;
+        piece.w = piece.h = 1;
+        if (++stream->column >= width) {
+            stream->column = 0;
+            stream->row++;
+        }
+    } else if (stream->column == 0 && halfwords >= width) {
+        // whole rows
+        uint32_t rows = halfwords / width;
+        if (rows > (uint32_t)(stream->rect.h - stream->row))
+            rows = (uint32_t)(stream->rect.h - stream->row);
+        else if ((width & 1) && (rows & 1) && rows > 1)
+            rows--;
+        piece.w = (int16_t)width;
+        piece.h = (int16_t)rows;
+        stream->row += (uint16_t)rows;
+    } else {
+        // the rest of a row, or as much of it as there is
+        uint32_t columns = width - stream->column;
+        if (columns > halfwords)
+            columns = halfwords & ~1u ? halfwords & ~1u : halfwords;
+        piece.w = (int16_t)columns;
+        piece.h = 1;
+        stream->column += (uint16_t)columns;
+        if (stream->column >= width) {
+            stream->column = 0;
+            stream->row++;
+        }
+    }
+
+    StartVramUpload(&piece, data);
+    stream->consumed += (uint32_t)piece.w * (uint32_t)piece.h * 2;
+    stream->inFlight = stream->consumed;
+    return 1;
+}
+
+/**
+ * Make as much progress on the stream as possible without waiting.
+ *
+ * Call this after committing data and regularly (e.g. once per frame) while the stream is in progress so finished
+ * uploads release their ring space.
+ *
+ * @param stream The stream.
+ * @return The stream's state. TIM_STREAM_DONE once the whole image has been uploaded (the last DMA may still be
+ *         finishing; use WaitVramUpload before drawing with it if necessary), or TIM_STREAM_ERROR if the data isn't a
+ *         TIM.
+ */
+static inline uint32_t PumpTimStream(TimStream *stream) {
+    int32_t progress = 1;
+
+    while (progress) {
+        uint32_t available = stream->written - stream->consumed;
+        progress = 0;
+
+        switch (stream->state) {
+            case TIM_STREAM_HEADER:
+                if (available < TIM_HEADER_SIZE)
+                    break;
+                if (TimStreamPeek(stream, 0, 4) != TIM_MAGIC) {
+                    stream->state = TIM_STREAM_ERROR;
+                    break;
+                }
+                stream->flags = TimStreamPeek(stream, 4, 4);
+                stream->blocksLeft = (stream->flags & TIM_FLAG_HAS_CLUT) ? 2 : 1;
+                stream->consumed += TIM_HEADER_SIZE;
+                stream->state = TIM_STREAM_BLOCK_HEADER;
+                progress = 1;
+                break;
+            case TIM_STREAM_BLOCK_HEADER: {
+                uint32_t length, dataSize;
+                if (available < TIM_BLOCK_HEADER_SIZE)
+                    break;
+                length = TimStreamPeek(stream, 0, 4);
+                stream->rect.x = (int16_t)TimStreamPeek(stream, 4, 2);
+                stream->rect.y = (int16_t)TimStreamPeek(stream, 6, 2);
+                stream->rect.w = (int16_t)TimStreamPeek(stream, 8, 2);
+                stream->rect.h = (int16_t)TimStreamPeek(stream, 10, 2);
+                dataSize = (uint32_t)(uint16_t)stream->rect.w * (uint16_t)stream->rect.h * 2;
+                if (length < TIM_BLOCK_HEADER_SIZE + dataSize) {
+                    stream->state = TIM_STREAM_ERROR;
+                    break;
+                }
+                stream->skip = length - TIM_BLOCK_HEADER_SIZE - dataSize;
+                if (stream->blocksLeft == 2)
+                    stream->clut = stream->rect;
+                else
+                    stream->image = stream->rect;
+                stream->row = stream->column = 0;
+                stream->consumed += TIM_BLOCK_HEADER_SIZE;
+                stream->state = dataSize > 0 ? TIM_STREAM_BLOCK_DATA : TIM_STREAM_BLOCK_SKIP;
+                progress = 1;
+                break;
+            }
+            case TIM_STREAM_BLOCK_DATA:
+                ReleaseTimStream(stream);
+                progress = PumpTimStreamData(stream);
+                if (stream->row >= (uint16_t)stream->rect.h) {
+                    stream->state = TIM_STREAM_BLOCK_SKIP;
+                    progress = 1;
+                }
+                break;
+            case TIM_STREAM_BLOCK_SKIP: {
+                uint32_t skip = stream->skip < available ? stream->skip : available;
+                stream->consumed += skip;
+                stream->skip -= skip;
+                if (stream->skip > 0)
+                    break;
+                stream->state = --stream->blocksLeft > 0 ? TIM_STREAM_BLOCK_HEADER : TIM_STREAM_DONE;
+                progress = 1;
+                break;
+            }
+            default:
+                ReleaseTimStream(stream);
+                break;
+        }
+    }
+
+    // space that was only parsed, not uploaded, can be reused right away once nothing before it is in flight
+    ReleaseTimStream(stream);
+    if (stream->released == stream->inFlight)
+        stream->released = stream->inFlight = stream->consumed;
+    return stream->state;
+}
+
+#ifdef __cplusplus
+}
+#endif
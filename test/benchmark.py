@@ -0,0 +1,406 @@
+"""
+Benchmarks for the disc, archive, compression, and module parsing code
+
+The tests only check correctness, so this measures the throughput of the hot paths at realistic sizes and compares it
+against a JSON file of baselines, failing if anything has slowed down by more than a threshold. Run it from the repo's
+root directory:
+
+    python -m test.benchmark            # compare against the baselines for this machine
+    python -m test.benchmark --save     # record new baselines for this machine
+
+Throughput depends on the machine, so baselines are stored per machine and Python version, and are only compared with
+runs on the same machine at the same scale. Room module parsing needs real game data, so it only runs when given a
+MODULE.BIN with --module-db.
+
+The machine is named by its host name unless --machine or the GALSDK_BENCHMARK_MACHINE environment variable gives
+another name, which lets CI runners share the baselines committed under a reference name:
+
+    python -m test.benchmark --machine reference --require-baseline
+
+With --require-baseline, a benchmark with no baseline to compare against is a failure rather than being skipped.
+"""
+from __future__ import annotations
+
+import io
+import json
+import os
+import platform
+import random
+import sys
+import time
+from abc import ABC, abstractmethod
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Iterable
+
+from galsdk.compress.dictionary import compress, decompress
+from galsdk.db import Database
+from psx.cd import Patch, PsxCd
+from psx.cd.disc import Disc, Sector, SubMode
+from psx.cd.psxcd import DEFAULT_SECTOR_SIZE
+
+
+DEFAULT_BASELINE_PATH = Path(__file__).with_name('benchmark_baselines.json')
+DEFAULT_THRESHOLD = 0.25
+DEFAULT_REPEAT = 5
+SAMPLE_CD_PATH = Path(__file__).with_name('test.bin')
+MACHINE_ENV_VAR = 'GALSDK_BENCHMARK_MACHINE'
+
+
+def new_sector(lba: int, form: int) -> Sector:
+    """Create a mode 2 sector with the header for its position. Sector 0 is two seconds in, after the pregap."""
+    minute, frame = divmod(lba + 150, 60 * 75)
+    second, frame = divmod(frame, 75)
+    return Sector(minute=minute, second=second, sector=frame, mode=2, form=form)
+
+
+def make_sectors(num_sectors: int, rng: random.Random) -> list[Sector]:
+    sectors = []
+    for i in range(num_sectors):
+        # mostly form 1 data, with some form 2 XA audio like the game's movie and voice files
+        audio = i % 8 == 7
+        sector = new_sector(i, 2 if audio else 1)
+        with sector:
+            sector.sub_mode = (SubMode.AUDIO | SubMode.FORM2 | SubMode.REAL_TIME) if audio else SubMode.DATA
+            sector.data[:] = rng.randbytes(sector.data_size)
+        sectors.append(sector)
+    return sectors
+
+
+def make_compressible(size: int, rng: random.Random) -> bytes:
+    # image-like data: runs of a few values with some noise
+    data = bytearray()
+    while len(data) < size:
+        value = rng.randrange(16) * 0x11
+        data += bytes([value]) * rng.randrange(1, 40)
+        data += rng.randbytes(rng.randrange(4))
+    return bytes(data[:size])
+
+
+class Benchmark(ABC):
+    """A hot path to be timed"""
+
+    name: str
+    description: str
+
+    def __init__(self, scale: float):
+        """
+        :param scale: Multiplier for the amount of work per run. 1 is a realistic size.
+        """
+        self.scale = scale
+        self.rng = random.Random(self.name)
+
+    @property
+    def is_available(self) -> bool:
+        return True
+
+    @property
+    @abstractmethod
+    def num_bytes(self) -> int:
+        """Number of bytes processed by each run"""
+
+    def prepare(self):
+        """Set up for a run. This isn't timed."""
+
+    @abstractmethod
+    def run(self):
+        """Do the work being measured"""
+
+
+class SectorEdc(Benchmark):
+    name = 'sector_edc'
+    description = 'Sector.calculate_edc over a mix of form 1 and form 2 sectors'
+
+    def __init__(self, scale: float):
+        super().__init__(scale)
+        self.sectors = make_sectors(max(int(500 * scale), 1), self.rng)
+
+    @property
+    def num_bytes(self) -> int:
+        return len(self.sectors) * Sector.SIZE
+
+    def run(self):
+        for sector in self.sectors:
+            sector.calculate_edc()
+
+
+class DiscRead(Benchmark):
+    name = 'disc_read'
+    description = 'Disc.read_sector over a disc image'
+
+    def __init__(self, scale: float):
+        super().__init__(scale)
+        # generating sectors is much slower than reading them, so the image repeats a smaller set of sectors
+        sectors = make_sectors(max(int(20000 * scale) // 16, 1), self.rng)
+        self.image = b''.join(sector.raw for sector in sectors) * 16
+        self.stream = io.BytesIO(self.image)
+
+    @property
+    def num_bytes(self) -> int:
+        return len(self.image)
+
+    def prepare(self):
+        self.stream.seek(0)
+
+    def run(self):
+        disc = Disc(self.stream)
+        while disc.read_sector() is not None:
+            pass
+
+
+class CdPatch(Benchmark):
+    name = 'cd_patch'
+    description = 'PsxCd.patch and write with a file that grows'
+
+    def __init__(self, scale: float):
+        super().__init__(scale)
+        self.data = self.rng.randbytes(max(int(0x100000 * scale), 1))
+        # the sample CD is full, so add free sectors at the end for the file to grow into
+        image = SAMPLE_CD_PATH.read_bytes()
+        first_free = len(image) // Sector.SIZE
+        num_free = -(-len(self.data) // DEFAULT_SECTOR_SIZE)
+        self.image = image + b''.join(new_sector(i, 1).raw for i in range(first_free, first_free + num_free))
+        self.cd = None
+
+    @property
+    def num_bytes(self) -> int:
+        return len(self.data)
+
+    def prepare(self):
+        self.cd = PsxCd(io.BytesIO(self.image))
+
+    def run(self):
+        self.cd.patch([Patch(r'cdrom:\TEST.TXT', self.data)])
+        self.cd.write(io.BytesIO())
+
+
+class DbPack(Benchmark):
+    name = 'db_pack'
+    description = 'Database.write of a CDB with MODEL.CDB-sized entries'
+
+    def __init__(self, scale: float):
+        super().__init__(scale)
+        self.db = Database()
+        for _ in range(max(int(200 * scale), 1)):
+            self.db.append(self.rng.randbytes(self.rng.randrange(0x1000, 0x10000)))
+
+    @property
+    def num_bytes(self) -> int:
+        return sum(len(entry) for entry in self.db)
+
+    def run(self):
+        self.db.write(io.BytesIO())
+
+
+class DbUnpack(DbPack):
+    name = 'db_unpack'
+    description = 'Database.read of a CDB with MODEL.CDB-sized entries'
+
+    def __init__(self, scale: float):
+        super().__init__(scale)
+        f = io.BytesIO()
+        self.db.write(f)
+        self.packed = f.getvalue()
+
+    def run(self):
+        for _ in Database.read(io.BytesIO(self.packed)):
+            pass
+
+
+class CompressRoundTrip(Benchmark):
+    name = 'compress_round_trip'
+    description = 'Dictionary compression and decompression of image data'
+
+    def __init__(self, scale: float):
+        super().__init__(scale)
+        self.data = make_compressible(max(int(0x8000 * scale), 1), self.rng)
+
+    @property
+    def num_bytes(self) -> int:
+        return len(self.data)
+
+    def run(self):
+        if b''.join(chunk for _, chunk in decompress(compress(self.data))) != self.data:
+            raise AssertionError('Compression round trip produced different data')
+
+
+class ModuleParse(Benchmark):
+    name = 'module_parse'
+    description = 'RoomModule.sniff over the entries of MODULE.BIN'
+    module_db: Path | None = None
+
+    def __init__(self, scale: float):
+        super().__init__(scale)
+        self.modules = []
+        if self.module_db is not None:
+            with self.module_db.open('rb') as f:
+                self.modules = [bytes(entry) for entry in Database.read(f)]
+            self.modules = self.modules[:max(int(len(self.modules) * min(scale, 1.)), 1)]
+
+    @property
+    def is_available(self) -> bool:
+        return bool(self.modules)
+
+    @property
+    def num_bytes(self) -> int:
+        return sum(len(module) for module in self.modules)
+
+    def run(self):
+        from galsdk.module import RoomModule
+
+        for module in self.modules:
+            RoomModule.sniff(io.BytesIO(module))
+
+
+BENCHMARKS: list[type[Benchmark]] = [SectorEdc, DiscRead, CdPatch, DbPack, DbUnpack, CompressRoundTrip, ModuleParse]
+
+
+@dataclass
+class Result:
+    name: str
+    seconds: float
+    num_bytes: int
+    scale: float
+
+    @property
+    def throughput(self) -> float:
+        """Throughput in MB/s"""
+        return self.num_bytes / self.seconds / 1e6 if self.seconds > 0 else float('inf')
+
+
+@dataclass
+class Comparison:
+    result: Result
+    baseline: float | None
+    threshold: float
+
+    @property
+    def change(self) -> float | None:
+        if self.baseline is None:
+            return None
+        return self.result.throughput / self.baseline - 1
+
+    @property
+    def is_regression(self) -> bool:
+        return self.baseline is not None and self.result.throughput < self.baseline * (1 - self.threshold)
+
+
+def measure(benchmark: Benchmark, repeat: int) -> Result:
+    """Time a benchmark, keeping the best of several runs to reduce noise"""
+    best = float('inf')
+    for _ in range(repeat):
+        benchmark.prepare()
+        start = time.perf_counter()
+        benchmark.run()
+        best = min(best, time.perf_counter() - start)
+    return Result(benchmark.name, best, benchmark.num_bytes, benchmark.scale)
+
+
+def machine_key(machine: str = None) -> str:
+    """
+    Get the key that a machine's baselines are stored under
+
+    :param machine: Name of the machine. Defaults to the host name.
+    :return: The machine name with the Python implementation and minor version
+    """
+    major, minor, _ = platform.python_version_tuple()
+    return f'{machine or platform.node()}/{platform.python_implementation()}-{major}.{minor}'
+
+
+def load_baselines(path: Path) -> dict[str, dict[str, dict[str, float]]]:
+    if not path.exists():
+        return {}
+    with path.open() as f:
+        return json.load(f)
+
+
+def save_baselines(path: Path, baselines: dict[str, dict[str, dict[str, float]]], key: str, results: list[Result]):
+    machine = baselines.setdefault(key, {})
+    for result in results:
+        machine[result.name] = {'throughput': result.throughput, 'scale': result.scale}
+    with path.open('w') as f:
+        json.dump(baselines, f, indent=4, sort_keys=True)
+        f.write('\n')
+
+
+def compare(results: Iterable[Result], baselines: dict[str, dict[str, float]], threshold: float) -> list[Comparison]:
+    """
+    Compare results with a machine's baselines
+
+    :param results: Benchmark results
+    :param baselines: Baseline throughput and scale of each benchmark for the machine the results came from
+    :param threshold: Fraction by which throughput can drop below the baseline before it counts as a regression
+    :return: Comparison for each result. Results with no baseline at the same scale have a baseline of None.
+    """
+    comparisons = []
+    for result in results:
+        baseline = baselines.get(result.name)
+        throughput = baseline['throughput'] if baseline and baseline['scale'] == result.scale else None
+        comparisons.append(Comparison(result, throughput, threshold))
+    return comparisons
+
+
+def main(baseline_path: Path, save: bool, threshold: float, scale: float, repeat: int, names: list[str] | None,
+         module_db: Path | None, machine: str = None, require_baseline: bool = False) -> int:
+    ModuleParse.module_db = module_db
+    benchmark_types = [b for b in BENCHMARKS if not names or b.name in names]
+    if names and (unknown := set(names) - {b.name for b in benchmark_types}):
+        print(f'Unknown benchmarks: {", ".join(sorted(unknown))}', file=sys.stderr)
+        return 2
+
+    results = []
+    for benchmark_type in benchmark_types:
+        benchmark = benchmark_type(scale)
+        if not benchmark.is_available:
+            print(f'{benchmark.name:<20} skipped')
+            continue
+        results.append(measure(benchmark, repeat))
+
+    key = machine_key(machine)
+    baselines = load_baselines(baseline_path)
+    comparisons = compare(results, baselines.get(key, {}), threshold)
+    print(f'{"benchmark":<20} {"MB/s":>9} {"baseline":>9} {"change":>8}')
+    for comparison in comparisons:
+        baseline = '-' if comparison.baseline is None else f'{comparison.baseline:.2f}'
+        change = '-' if comparison.change is None else f'{comparison.change:+.1%}'
+        flag = ' REGRESSION' if comparison.is_regression else ''
+        print(f'{comparison.result.name:<20} {comparison.result.throughput:>9.2f} {baseline:>9} {change:>8}{flag}')
+
+    if save:
+        save_baselines(baseline_path, baselines, key, results)
+        print(f'Saved baselines for {key} to {baseline_path}')
+        return 0
+    if missing := [comparison.result.name for comparison in comparisons if comparison.baseline is None]:
+        print(f'No baselines for {", ".join(missing)} on {key} at this scale; run with --save to record them')
+        if require_baseline:
+            return 1
+    return 1 if any(comparison.is_regression for comparison in comparisons) else 0
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(description='Benchmark the disc, archive, compression, and module parsing code '
+                                     'and compare with recorded baselines')
+    parser.add_argument('-b', '--baseline', type=Path, default=DEFAULT_BASELINE_PATH,
+                        help='Path to the JSON file of baselines')
+    parser.add_argument('-s', '--save', action='store_true',
+                        help="Record this run's results as the baselines for this machine")
+    parser.add_argument('-t', '--threshold', type=float, default=DEFAULT_THRESHOLD,
+                        help='Fraction by which throughput can drop below the baseline before failing. Defaults to '
+                        f'{DEFAULT_THRESHOLD}.')
+    parser.add_argument('--scale', type=float, default=1.,
+                        help='Multiplier for the amount of work each benchmark does. Defaults to 1.')
+    parser.add_argument('-r', '--repeat', type=int, default=DEFAULT_REPEAT,
+                        help=f'Number of times to run each benchmark, keeping the best. Defaults to {DEFAULT_REPEAT}.')
+    parser.add_argument('-m', '--module-db', type=Path, help='Path to MODULE.BIN, for the module parsing benchmark')
+    parser.add_argument('--machine', default=os.environ.get(MACHINE_ENV_VAR),
+                        help=f'Name to store and look up baselines under instead of the host name. Defaults to the '
+                        f'{MACHINE_ENV_VAR} environment variable if set.')
+    parser.add_argument('--require-baseline', action='store_true',
+                        help='Fail if any benchmark that ran has no baseline to compare against')
+    parser.add_argument('names', nargs='*', help='Benchmarks to run. Defaults to all of them.')
+
+    args = parser.parse_args()
+    sys.exit(main(args.baseline, args.save, args.threshold, args.scale, args.repeat, args.names, args.module_db,
+                  args.machine, args.require_baseline))
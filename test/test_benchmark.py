@@ -0,0 +1,68 @@
+import pytest
+
+from test.benchmark import (BENCHMARKS, Result, compare, load_baselines, machine_key, main, measure, new_sector,
+                            save_baselines)
+
+
+def test_compare_regression():
+    results = [Result('fast', 1., 2_000_000, 1.), Result('slow', 1., 500_000, 1.)]
+    baselines = {'fast': {'throughput': 2., 'scale': 1.}, 'slow': {'throughput': 1., 'scale': 1.}}
+    fast, slow = compare(results, baselines, 0.25)
+    assert fast.change == pytest.approx(0.)
+    assert not fast.is_regression
+    assert slow.change == pytest.approx(-0.5)
+    assert slow.is_regression
+
+
+def test_compare_within_threshold():
+    (comparison,) = compare([Result('a', 1., 800_000, 1.)], {'a': {'throughput': 1., 'scale': 1.}}, 0.25)
+    assert not comparison.is_regression
+
+
+def test_compare_different_scale():
+    (comparison,) = compare([Result('a', 1., 1, 0.5)], {'a': {'throughput': 1., 'scale': 1.}}, 0.25)
+    assert comparison.baseline is None
+    assert comparison.change is None
+    assert not comparison.is_regression
+
+
+def test_save_baselines(tmp_path):
+    path = tmp_path / 'baselines.json'
+    save_baselines(path, {'other': {'a': {'throughput': 5., 'scale': 1.}}}, 'this', [Result('a', 1., 3_000_000, 1.)])
+    assert load_baselines(path) == {
+        'other': {'a': {'throughput': 5., 'scale': 1.}},
+        'this': {'a': {'throughput': 3., 'scale': 1.}},
+    }
+
+
+def test_machine_key():
+    assert machine_key('reference').startswith('reference/')
+    assert machine_key().split('/')[0] != 'reference'
+
+
+def test_new_sector_position():
+    sector = new_sector(0, 1)
+    assert (sector.minute, sector.second, sector.sector) == (0, 2, 0)
+    # 60 seconds in, counting the two second pregap, carries into the minutes
+    sector = new_sector(58 * 75 - 1, 1)
+    assert (sector.minute, sector.second, sector.sector) == (0, 59, 74)
+    sector = new_sector(58 * 75, 1)
+    assert (sector.minute, sector.second, sector.sector) == (1, 0, 0)
+
+
+def test_require_baseline(tmp_path):
+    path = tmp_path / 'baselines.json'
+    assert main(path, False, 0.25, 0.01, 1, ['db_pack'], None, 'ci') == 0
+    assert main(path, False, 0.25, 0.01, 1, ['db_pack'], None, 'ci', require_baseline=True) == 1
+    assert main(path, True, 0.25, 0.01, 1, ['db_pack'], None, 'ci') == 0
+    assert main(path, False, 10., 0.01, 1, ['db_pack'], None, 'ci', require_baseline=True) == 0
+
+
+@pytest.mark.parametrize('benchmark_type', BENCHMARKS, ids=lambda b: b.name)
+def test_benchmarks_run(benchmark_type):
+    benchmark = benchmark_type(0.01)
+    if not benchmark.is_available:
+        pytest.skip(f'{benchmark.name} needs game data')
+    result = measure(benchmark, 1)
+    assert result.num_bytes > 0
+    assert result.throughput > 0
@@ -0,0 +1,84 @@
+import os
+
+from galsdk.cache import AssetCache
+
+
+def test_get_converts_once(tmp_path):
+    source = tmp_path / 'source.bin'
+    source.write_bytes(b'source data')
+    calls = []
+
+    def convert() -> bytes:
+        calls.append(1)
+        return b'converted ' + source.read_bytes()
+
+    cache = AssetCache(tmp_path / 'cache')
+    assert bytes(cache.get([source], 'test', 1, convert)) == b'converted source data'
+    assert bytes(cache.get([source], 'test', 1, convert)) == b'converted source data'
+    # a new instance picks up the entry and the index from disk
+    other_cache = AssetCache(tmp_path / 'cache')
+    assert bytes(other_cache.get([source], 'test', 1, convert)) == b'converted source data'
+    assert len(calls) == 1
+
+
+def test_get_keyed_by_version_and_params(tmp_path):
+    source = tmp_path / 'source.bin'
+    source.write_bytes(b'source data')
+    cache = AssetCache(tmp_path / 'cache')
+
+    assert bytes(cache.get([source], 'test', 1, lambda: b'v1')) == b'v1'
+    assert bytes(cache.get([source], 'test', 2, lambda: b'v2')) == b'v2'
+    assert bytes(cache.get([source], 'test', 1, lambda: b'p', 'actor:1')) == b'p'
+    assert bytes(cache.get([source], 'test', 1, lambda: b'unused')) == b'v1'
+
+
+def test_changed_source_is_rehashed(tmp_path):
+    source = tmp_path / 'source.bin'
+    source.write_bytes(b'old data')
+    cache = AssetCache(tmp_path / 'cache')
+    assert bytes(cache.get([source], 'test', 1, lambda: b'old')) == b'old'
+
+    # same size, so only the mtime shows it changed
+    source.write_bytes(b'new data')
+    stat = source.stat()
+    os.utime(source, (stat.st_atime, stat.st_mtime + 10))
+    assert bytes(cache.get([source], 'test', 1, lambda: b'new')) == b'new'
+
+    # content-addressed, so going back to the old contents finds the old entry
+    source.write_bytes(b'old data')
+    os.utime(source, (stat.st_atime, stat.st_mtime + 20))
+    assert bytes(cache.get([source], 'test', 1, lambda: b'unused')) == b'old'
+
+
+def test_clear(tmp_path):
+    source = tmp_path / 'source.bin'
+    source.write_bytes(b'source data')
+    cache = AssetCache(tmp_path / 'cache')
+    cache.get([source], 'test', 1, lambda: b'')
+    cache.clear()
+    assert not (tmp_path / 'cache').exists()
+    assert bytes(cache.get([source], 'test', 1, lambda: b'again')) == b'again'
+
+
+def test_prune_least_recently_used(tmp_path):
+    sources = []
+    for i in range(3):
+        source = tmp_path / f'source{i}.bin'
+        source.write_bytes(bytes([i]))
+        sources.append(source)
+    cache = AssetCache(tmp_path / 'cache', max_size=25)
+    paths = [cache.entry_path([source], 'test', 1) for source in sources]
+
+    cache.get([sources[0]], 'test', 1, lambda: bytes(10))
+    cache.get([sources[1]], 'test', 1, lambda: bytes(10))
+    # make entry 0 the most recently used
+    os.utime(paths[1], (0, 1))
+    cache.get([sources[0]], 'test', 1, lambda: b'unused')
+    # adding a third entry goes over the limit, so the least recently used one is dropped
+    cache.get([sources[2]], 'test', 1, lambda: bytes(10))
+    assert paths[0].exists()
+    assert not paths[1].exists()
+    assert paths[2].exists()
+
+    cache.prune(0)
+    assert not any(path.exists() for path in paths)
@@ -1,3 +1,5 @@
+import io
+
 from galsdk.db import Database
 
 
@@ -33,3 +35,59 @@ def test_extended_db(tmp_path):
     assert len(new_db) == 2
     assert new_db[0] == first_file
     assert new_db[1] == second_file
+
+
+def test_lazy_db(tmp_path):
+    first_file = b'this is the first file'
+    second_file = b'this is the second file' * 100
+    cdb_path = tmp_path / 'test.cdb'
+    db = Database(True)
+    db.append(first_file)
+    db.append(second_file)
+    with cdb_path.open('wb') as f:
+        db.write(f)
+
+    with cdb_path.open('rb') as f:
+        new_db = Database.read(f, lazy=True)
+    with new_db:
+        assert new_db.is_lazy
+        assert len(new_db) == 2
+        assert isinstance(new_db[0], memoryview)
+        assert new_db[0] == first_file
+        assert new_db[1] == second_file
+        new_db[0] = b'replaced'
+        new_db.materialize()
+        assert not new_db.is_lazy
+        assert new_db[0] == b'replaced'
+        assert new_db[1] == second_file
+
+
+def test_lazy_db_write_in_place(tmp_path):
+    cdb_path = tmp_path / 'test.cdb'
+    db = Database(True)
+    db.append(b'first')
+    db.append(b'second')
+    with cdb_path.open('wb') as f:
+        db.write(f)
+
+    with cdb_path.open('rb') as f:
+        lazy_db = Database.read(f, lazy=True)
+    lazy_db.insert(0, b'new first')
+    with cdb_path.open('r+b') as f:
+        lazy_db.write(f)
+    assert not lazy_db.is_lazy
+
+    with cdb_path.open('rb') as f:
+        new_db = Database.read(f)
+    assert list(new_db) == [b'new first', b'first', b'second']
+
+
+def test_lazy_db_fallback():
+    db = Database(True)
+    db.append(b'in memory')
+    with io.BytesIO() as f:
+        db.write(f)
+        f.seek(0)
+        new_db = Database.read(f, lazy=True)
+    assert not new_db.is_lazy
+    assert new_db[0] == b'in memory'
@@ -0,0 +1,46 @@
+from galsdk.compress import dictionary
+from galsdk.compress.dictionary import CHUNK_SIZE, compress, compress_many, decompress
+
+
+def make_data(size: int) -> bytes:
+    # long runs of the same byte are the worst case for building the byte map
+    data = bytearray(size)
+    for i in range(0, size, 700):
+        data[i:i + 9] = b'\x11\x22\x33\x44\x55\x11\x22\x33\x44'
+    for i in range(350, size, 1300):
+        data[i:i + 20] = bytes(range(0x60, 0x74))
+    return bytes(data)
+
+
+def decompress_all(data: bytes) -> bytes:
+    return b''.join(chunk for _, chunk in decompress(data))
+
+
+def test_round_trip():
+    data = make_data(CHUNK_SIZE + 1234)
+    compressed = compress(data)
+    assert len(compressed) < len(data)
+    assert len(compressed) % 4 == 0
+    assert decompress_all(compressed) == data
+
+
+def test_empty():
+    assert decompress_all(compress(b'')) == b''
+
+
+def test_compress_many(monkeypatch):
+    # use the process pool even though there are only a few chunks
+    monkeypatch.setattr(dictionary, 'MIN_PARALLEL_CHUNKS', 2)
+    items = [make_data(3000), b'just some text that repeats, just some text that repeats', make_data(CHUNK_SIZE * 2)]
+    results = compress_many(items, 2)
+    assert results == [compress(item) for item in items]
+    assert [decompress_all(result) for result in results] == items
+
+
+def test_compress_many_small_is_serial(monkeypatch):
+    def no_pool(*args, **kwargs):
+        raise AssertionError('A process pool was started for a small batch')
+
+    monkeypatch.setattr(dictionary, 'ProcessPoolExecutor', no_pool)
+    items = [make_data(3000), make_data(CHUNK_SIZE + 100)]
+    assert compress_many(items) == [compress(item) for item in items]
@@ -0,0 +1,226 @@
+import struct
+
+import pytest
+
+from galsdk.emulator import Cpu, EmulationError
+from galsdk.roombench import RoomBenchmark
+
+ZERO, V0, A0, T0, T1, T2, RA = 0, 2, 4, 8, 9, 10, 31
+CODE = 0x80100000
+
+
+def r_type(funct: int, rd: int = 0, rs: int = 0, rt: int = 0, shamt: int = 0) -> int:
+    return (rs << 21) | (rt << 16) | (rd << 11) | (shamt << 6) | funct
+
+
+def i_type(op: int, rt: int, rs: int, imm: int) -> int:
+    return (op << 26) | (rs << 21) | (rt << 16) | (imm & 0xFFFF)
+
+
+def addiu(rt: int, rs: int, imm: int) -> int:
+    return i_type(9, rt, rs, imm)
+
+
+def lui(rt: int, imm: int) -> int:
+    return i_type(15, rt, 0, imm)
+
+
+def ori(rt: int, rs: int, imm: int) -> int:
+    return i_type(13, rt, rs, imm)
+
+
+def sw(rt: int, offset: int, base: int) -> int:
+    return i_type(43, rt, base, offset)
+
+
+def sh(rt: int, offset: int, base: int) -> int:
+    return i_type(41, rt, base, offset)
+
+
+def bne(rs: int, rt: int, offset: int) -> int:
+    return i_type(5, rt, rs, offset)
+
+
+def beq(rs: int, rt: int, offset: int) -> int:
+    return i_type(4, rt, rs, offset)
+
+
+def jal(address: int) -> int:
+    return (3 << 26) | ((address >> 2) & 0x3FFFFFF)
+
+
+def jr(rs: int) -> int:
+    return r_type(8, rs=rs)
+
+
+NOP = 0
+
+
+def assemble(words: list[int]) -> bytes:
+    return struct.pack(f'<{len(words)}I', *words)
+
+
+def run_code(words: list[int], cpu: Cpu = None) -> Cpu:
+    cpu = cpu or Cpu()
+    code = assemble(words)
+    cpu.memory.write(CODE, code)
+    cpu.executable = range(CODE, CODE + len(code) + 4)
+    cpu.jump(CODE)
+    cpu.run(CODE + len(code), 10000)
+    return cpu
+
+
+def test_arithmetic():
+    cpu = run_code([
+        addiu(T0, ZERO, -5),
+        addiu(T1, ZERO, 3),
+        r_type(0x21, rd=T2, rs=T0, rt=T1),  # addu
+        r_type(0x18, rs=T0, rt=T1),         # mult
+        r_type(0x12, rd=V0),                # mflo
+        r_type(0x1A, rs=T0, rt=T1),         # div
+        r_type(0x12, rd=A0),                # mflo
+        r_type(0x10, rd=A0 + 1),            # mfhi
+        r_type(0x2A, rd=A0 + 2, rs=T0, rt=T1),  # slt
+        r_type(0x2B, rd=A0 + 3, rs=T0, rt=T1),  # sltu
+        r_type(0x03, rd=T0, rt=T0, shamt=1),    # sra
+    ])
+    assert cpu.regs[T2] == 0xFFFFFFFE
+    assert cpu.regs[V0] == (-15) & 0xFFFFFFFF
+    assert cpu.regs[A0] == (-1) & 0xFFFFFFFF
+    assert cpu.regs[A0 + 1] == (-2) & 0xFFFFFFFF
+    assert cpu.regs[A0 + 2] == 1
+    assert cpu.regs[A0 + 3] == 0
+    assert cpu.regs[T0] == (-3) & 0xFFFFFFFF
+    assert cpu.instructions == 11
+    # mult with a small operand takes 6 cycles and div takes 36
+    assert cpu.cycles == 9 + 6 + 36
+
+
+def test_branch_delay_slot():
+    cpu = run_code([
+        addiu(T0, ZERO, 3),
+        addiu(T1, ZERO, 0),
+        # loop:
+        addiu(T0, T0, -1),
+        bne(T0, ZERO, -2),
+        addiu(T1, T1, 1),  # delay slot, executed on every iteration
+        beq(ZERO, ZERO, 2),
+        NOP,
+        addiu(T1, T1, 100),  # skipped
+    ])
+    assert cpu.regs[T1] == 3
+
+
+def test_unaligned_access():
+    cpu = Cpu()
+    cpu.memory.write(0x80000200, bytes(range(1, 9)))
+    cpu.regs[A0] = 0x80000200
+    run_code([
+        i_type(34, T0, A0, 4),  # lwl t0, 4(a0)
+        i_type(38, T0, A0, 1),  # lwr t0, 1(a0)
+        i_type(42, T0, A0, 0x14),  # swl t0, 0x14(a0)
+        i_type(46, T0, A0, 0x11),  # swr t0, 0x11(a0)
+    ], cpu)
+    assert cpu.regs[T0] == 0x05040302
+    assert cpu.memory.read(0x80000210, 6) == bytes([0, 2, 3, 4, 5, 0])
+
+
+def test_overflow():
+    with pytest.raises(EmulationError):
+        run_code([lui(T0, 0x7FFF), ori(T0, T0, 0xFFFF), i_type(8, T0, T0, 1)])
+
+
+def test_room_benchmark():
+    origin = RoomBenchmark.ROOM_ORIGIN
+    game = 0x801AF308
+    yield_address = 0x8018539C
+    room = origin + 4
+    enabled = room + 4 * 10
+    triggers = enabled + 4 * 7
+    module = assemble([
+        0x8b,  # module ID
+        # room:
+        lui(T0, triggers >> 16),
+        ori(T0, T0, triggers & 0xFFFF),
+        sw(T0, 0x30, A0),
+        addiu(T1, ZERO, 1),
+        sh(T1, 0x24, A0),
+        # loop:
+        jal(yield_address),
+        NOP,
+        beq(ZERO, ZERO, -3),
+        NOP,
+        NOP,
+        # enabled: count down from 4 and return 0
+        addiu(T0, ZERO, 4),
+        addiu(T0, T0, -1),
+        bne(T0, ZERO, -2),
+        NOP,
+        jr(RA),
+        addiu(V0, ZERO, 0),
+        NOP,
+        # triggers:
+        enabled, 0, 0, 0,
+    ])
+    symbols = {'Game': game, 'Actors': 0x801C1778, 'FrameCount': 0x801E2282, 'Yield': yield_address}
+    bench = RoomBenchmark(module, symbols, {'room': room, 'checkEnabled': enabled})
+    bench.run(bench.resolve('room'), 3)
+
+    assert bench.stats['room'].runs == 4
+    # the first run sets up the triggers and yields; after that, each frame returns from Yield and yields again
+    assert bench.stats['room'].max_instructions == 7
+    assert bench.stats['room'].instructions == 7 + 3 * 4
+    assert bench.stats['checkEnabled'].runs == 3
+    assert bench.stats['checkEnabled'].max_instructions == 1 + 4 * 3 + 2
+    assert bench.stub_calls == {'Yield': 4}
+    assert bench.memory.read16(symbols['FrameCount']) == 2
+
+
+def test_room_benchmark_shared_callback():
+    origin = RoomBenchmark.ROOM_ORIGIN
+    game = 0x801AF308
+    yield_address = 0x8018539C
+    room = origin + 4
+    enabled = room + 4 * 10
+    triggers = enabled + 4 * 6
+    module = assemble([
+        0x8b,  # module ID
+        # room:
+        lui(T0, triggers >> 16),
+        ori(T0, T0, triggers & 0xFFFF),
+        sw(T0, 0x30, A0),
+        addiu(T1, ZERO, 2),
+        sh(T1, 0x24, A0),
+        # loop:
+        jal(yield_address),
+        NOP,
+        beq(ZERO, ZERO, -3),
+        NOP,
+        NOP,
+        # enabled: yield once and return 0
+        r_type(0x21, T2, RA, ZERO),  # addu t2, ra, zero
+        jal(yield_address),
+        NOP,
+        jr(T2),
+        addiu(V0, ZERO, 0),
+        NOP,
+        # triggers: both share the same enabled callback
+        enabled, 0, 0, 0,
+        enabled, 0, 0, 0,
+    ])
+    symbols = {'Game': game, 'Actors': 0x801C1778, 'FrameCount': 0x801E2282, 'Yield': yield_address}
+    bench = RoomBenchmark(module, symbols, {'room': room, 'checkEnabled': enabled})
+    bench.run(bench.resolve_entry(), 2)
+
+    # the second trigger's callback still starts while the first trigger's is waiting, and each resumes on the next
+    # frame before starting again
+    assert bench.stats['checkEnabled'].runs == 2 + 2 * 2
+    assert len(bench.tasks) == 3
+
+
+def test_room_benchmark_metadata_entry_point():
+    bench = RoomBenchmark(assemble([0x8b, jr(RA), NOP]), {'Game': 0x801AF308, 'Actors': 0x801C1778},
+                          entry_point=RoomBenchmark.ROOM_ORIGIN + 4)
+    assert bench.resolve_entry() == RoomBenchmark.ROOM_ORIGIN + 4
+    with pytest.raises(KeyError):
+        RoomBenchmark(assemble([0x8b]), {'Game': 0x801AF308, 'Actors': 0x801C1778}).resolve_entry()
@@ -0,0 +1,118 @@
+import os
+import shutil
+import subprocess
+from pathlib import Path
+
+import pytest
+
+from galsdk.emulator import Cpu
+from psx.exe import Exe
+
+SDK_INCLUDE = Path(__file__).parent.parent / 'sdk' / 'include'
+# path to the North American EXE (SLUS_009.86) to check the header against the game's own flag functions
+EXE_ENV_VAR = 'GALSDK_TEST_NA_EXE'
+
+# just enough of PSn00bSDK to build the header for the host
+PSXGTE_STUB = '''
+#pragma once
+#include <stdint.h>
+typedef struct { int16_t m[3][3]; int32_t t[3]; } MATRIX;
+typedef struct { int32_t vx, vy, vz; } VECTOR;
+typedef struct { int16_t vx, vy, vz, pad; } SVECTOR;
+typedef struct { uint8_t r, g, b, cd; } CVECTOR;
+'''
+
+# (flag, stage) pairs covering both halves of each of the three flag words
+CASES = [(0, 0), (31, 1), (32, 2), (63, 3), (64, 0), (100, 1), (127, 2), (128, 3), (160, 0), (191, 1)]
+
+FLAGS_TEST = r'''
+#include <stdio.h>
+#include <string.h>
+#include <galerians/flags.h>
+
+static const int16_t cases[][2] = { %s };
+
+int main(void) {
+    static GameState game;
+    uint32_t i, j;
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        memset(&game, 0, sizeof(game));
+        SetStageStateFlagInline(&game, cases[i][0], cases[i][1]);
+        printf("%%d", GetStageStateFlagInline(&game, cases[i][0], cases[i][1]));
+        for (j = 0; j < NUM_STAGES; j++)
+            printf(" %%016llx", (unsigned long long)game.stateFlags1[j]);
+        for (j = 0; j < NUM_STAGES; j++)
+            printf(" %%016llx", (unsigned long long)game.stateFlags2[j]);
+        for (j = 0; j < NUM_STAGES; j++)
+            printf(" %%016llx", (unsigned long long)game.stateFlags3[j]);
+        ClearStageStateFlagInline(&game, cases[i][0], cases[i][1]);
+        printf(" %%d\n", GetStageStateFlagInline(&game, cases[i][0], cases[i][1]));
+    }
+    return 0;
+}
+'''
+
+# NA addresses, from ldscripts/na_symbols.ld
+GAME = 0x801AF308
+STATE_FLAGS_OFFSET = 0x698
+SET_STAGE_STATE_FLAG = 0x80128220
+GET_STAGE_STATE_FLAG = 0x801284E8
+RETURN_ADDRESS = 0x80000100
+
+
+def find_compiler() -> str:
+    for name in ['cc', 'gcc', 'clang']:
+        if (path := shutil.which(name)) is not None:
+            return path
+    pytest.skip('No host C compiler')
+
+
+def run_header(tmp_path: Path) -> list[list[int]]:
+    compiler = find_compiler()
+    (tmp_path / 'psxgte.h').write_text(PSXGTE_STUB)
+    source_path = tmp_path / 'test.c'
+    source_path.write_text(FLAGS_TEST % ', '.join(f'{{ {flag}, {stage} }}' for flag, stage in CASES))
+    exe_path = tmp_path / 'test'
+    # the layout asserts assume the PlayStation's 32-bit pointers
+    subprocess.run([compiler, '-std=gnu11', '-D_Static_assert(c, m)=', f'-I{tmp_path}', f'-I{SDK_INCLUDE}',
+                    str(source_path), '-o', str(exe_path)], check=True)
+    output = subprocess.run([str(exe_path)], check=True, capture_output=True, text=True).stdout
+    return [[int(field, 16) for field in line.split()] for line in output.splitlines()]
+
+
+def call(cpu: Cpu, address: int, *args: int) -> int:
+    for i, arg in enumerate(args):
+        cpu.regs[Cpu.A0 + i] = arg
+    cpu.regs[Cpu.RA] = RETURN_ADDRESS
+    cpu.regs[Cpu.SP] = 0x801FFF00
+    cpu.jump(address)
+    assert cpu.run(RETURN_ADDRESS, 100_000)
+    return cpu.regs[Cpu.V0]
+
+
+def test_flag_words(tmp_path):
+    for (flag, stage), (is_set, *words, is_still_set) in zip(CASES, run_header(tmp_path), strict=True):
+        expected = [0] * 12
+        expected[flag // 64 * 4 + stage] = 1 << (flag % 64)
+        assert words == expected, (flag, stage)
+        assert is_set == 1
+        assert is_still_set == 0
+
+
+def test_flag_words_match_exe(tmp_path):
+    if (exe_path := os.environ.get(EXE_ENV_VAR)) is None:
+        pytest.skip(f'Set {EXE_ENV_VAR} to the path of the North American EXE to compare with the game')
+    with open(exe_path, 'rb') as f:
+        exe = Exe.read(f)
+
+    results = run_header(tmp_path)
+    cpu = Cpu()
+    cpu.executable = range(exe.load_address, exe.load_address + len(exe.data))
+    cpu.memory.write(exe.load_address, exe.data)
+    for (flag, stage), (_, *words, _) in zip(CASES, results, strict=True):
+        cpu.memory.write(GAME + STATE_FLAGS_OFFSET, bytes(12 * 8))
+        call(cpu, SET_STAGE_STATE_FLAG, GAME, flag, stage)
+        flag_data = cpu.memory.read(GAME + STATE_FLAGS_OFFSET, 12 * 8)
+        exe_words = [int.from_bytes(flag_data[i:i + 8], 'little') for i in range(0, len(flag_data), 8)]
+        assert exe_words == words, (flag, stage)
+        assert call(cpu, GET_STAGE_STATE_FLAG, GAME, flag, stage) != 0
@@ -0,0 +1,43 @@
+from galsdk.layoutgen import LayoutGenerator
+from galsdk.module import (ActorInstance, ActorLayout, ActorLayoutSet, Camera, CameraCut, CircleCollider, Collider,
+                           ColliderType, RectangleCollider, RoomLayout, RoomModule, TriggerSet)
+
+
+def make_module(layout: RoomLayout) -> RoomModule:
+    actors = ActorLayoutSet(0, [ActorLayout('A0101', b'\0' * 30, [ActorInstance(1, 0, 100, 0, 200)] +
+                                            [ActorInstance() for _ in range(3)])])
+    return RoomModule(0, layout, [], [actors], TriggerSet(), [], 0x801ec628, b'', {}, 0)
+
+
+def test_dedupe_shapes():
+    layout = RoomLayout(
+        colliders=[Collider(ColliderType.WALL, 0, 0), Collider(ColliderType.RECTANGLE, 0, 0),
+                   Collider(ColliderType.RECTANGLE, 0, 0), Collider(ColliderType.CIRCLE, 0, 0)],
+        rectangle_colliders=[RectangleCollider(0, 0, 1000, 1000), RectangleCollider(10, 10, 20, 20),
+                             RectangleCollider(10, 10, 20, 20)],
+        circle_colliders=[CircleCollider(5, 5, 5)],
+        cameras=[Camera(0, 600, 10, 1, 2, 3, 4, 5, 6, 0)],
+        cuts=[CameraCut(0, 0, 0, 100, 0, 0, 100, 100, 100)],
+    )
+    text = LayoutGenerator('test').generate(make_module(layout))
+    assert '.shape = &testRects[0]' in text
+    assert text.count('.shape = &testRects[1]') == 2
+    assert 'testRects[2]' not in text
+    assert text.count('.xSize = 20') == 1
+    assert '.triColliders = NULL' in text
+    assert '.numColliders = 4' in text
+    assert '.numInteractables = 0' in text
+    assert '.interactables = NULL' in text
+    assert 'CAMERA_CUT_END' in text
+    assert ".name = {'A', '0', '1', '0', '1', 0}" in text
+
+
+def test_no_dedupe():
+    layout = RoomLayout(
+        colliders=[Collider(ColliderType.RECTANGLE, 0, 0), Collider(ColliderType.RECTANGLE, 0, 0)],
+        rectangle_colliders=[RectangleCollider(10, 10, 20, 20), RectangleCollider(10, 10, 20, 20)],
+    )
+    text = LayoutGenerator('test', dedupe=False).generate(make_module(layout))
+    assert '.shape = &testRects[1]' in text
+    assert text.count('.xSize = 20') == 2
+    assert '.cameras = NULL' in text
@@ -0,0 +1,73 @@
+import shutil
+import subprocess
+from pathlib import Path
+
+import pytest
+
+SDK_INCLUDE = Path(__file__).parent.parent / 'sdk' / 'include'
+
+# just enough of PSn00bSDK to build the header for the host
+PSXGTE_STUB = '''
+#pragma once
+#include <stdint.h>
+typedef struct { int16_t m[3][3]; int32_t t[3]; } MATRIX;
+typedef struct { int32_t vx, vy, vz; } VECTOR;
+typedef struct { int16_t vx, vy, vz, pad; } SVECTOR;
+typedef struct { uint8_t r, g, b, cd; } CVECTOR;
+int32_t SquareRoot0(int32_t a);
+'''
+
+CULL_TEST = r'''
+#include <stdio.h>
+#include <galerians/mask.h>
+
+int32_t SquareRoot0(int32_t a) {
+    int32_t root = 0;
+    while ((root + 1) * (root + 1) <= a)
+        root++;
+    return root;
+}
+
+int main(void) {
+    Camera camera = { .verticalFov = 600, .targetZ = 1000 };
+    BackgroundMask masks[4] = {
+        { 0 },                          // the background image itself
+        { .index = 1, .z = 500 },       // near
+        { .index = 2, .z = -1000 },     // behind the camera
+        { .index = 3, .z = 3000 },      // far
+    };
+    BackgroundMask out[4];
+    int16_t depths[4];
+    uint32_t i, count = CullBackgroundMasks(&camera, masks, 4, out, depths);
+
+    printf("%u", count);
+    for (i = 0; i < count; i++)
+        printf(" %u:%d", out[i].index, out[i].z);
+    printf("\n");
+    return 0;
+}
+'''
+
+
+def find_compiler() -> str:
+    for name in ['cc', 'gcc', 'clang']:
+        if (path := shutil.which(name)) is not None:
+            return path
+    pytest.skip('No host C compiler')
+
+
+def run_c(tmp_path: Path, source: str) -> str:
+    compiler = find_compiler()
+    (tmp_path / 'psxgte.h').write_text(PSXGTE_STUB)
+    source_path = tmp_path / 'test.c'
+    source_path.write_text(source)
+    exe_path = tmp_path / 'test'
+    # the layout asserts assume the PlayStation's 32-bit pointers
+    subprocess.run([compiler, '-std=gnu11', '-D_Static_assert(c, m)=', f'-I{tmp_path}', f'-I{SDK_INCLUDE}',
+                    str(source_path), '-o', str(exe_path)], check=True)
+    return subprocess.run([str(exe_path)], check=True, capture_output=True, text=True).stdout.strip()
+
+
+def test_cull_keeps_background_first(tmp_path):
+    # the background stays first even though its point is at the camera, then the visible masks from far to near
+    assert run_c(tmp_path, CULL_TEST) == '3 0:0 3:3000 1:500'
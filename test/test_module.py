@@ -0,0 +1,66 @@
+import io
+import struct
+
+import pytest
+
+from galsdk.module import ActorInstance, ActorLayout, ActorLayoutSet, ModuleHeader, RoomLayout, RoomModule, TriggerSet
+
+
+def make_data(bss_size: int, body: bytes = b'\x01\x02\x03\x04') -> bytes:
+    file_size = 4 + ModuleHeader.SIZE + len(body)
+    return struct.pack('<I', 0x8b) + ModuleHeader(file_size, bss_size).encode() + body
+
+
+def test_parse_header():
+    data = make_data(0x100)
+    header = ModuleHeader.parse(data)
+    assert header.file_size == len(data)
+    assert header.bss_size == 0x100
+    # also accepted once the zero-initialized data has been appended
+    assert ModuleHeader.parse(data + bytes(0x100)) == header
+
+
+def test_no_header():
+    data = struct.pack('<I', 0x8b) + b'\0' * 0x20
+    assert ModuleHeader.parse(data) is None
+    assert ModuleHeader.expand(data) == data
+
+
+def test_expand():
+    data = make_data(0x100)
+    expanded = ModuleHeader.expand(data)
+    assert len(expanded) == len(data) + 0x100
+    assert expanded[:len(data)] == data
+    assert not any(expanded[len(data):])
+    assert ModuleHeader.expand(expanded) == expanded
+
+
+def test_expand_unaligned():
+    # the header's file size is aligned to the start of .bss, which can be past the end of the file's data
+    data = make_data(0x100)[:-2]
+    assert ModuleHeader.parse(data).file_size == len(data) + 2
+    expanded = ModuleHeader.expand(data)
+    assert len(expanded) == len(data) + 2 + 0x100
+    assert expanded[:len(data)] == data
+    assert not any(expanded[len(data):])
+    assert ModuleHeader.parse(make_data(0x100)[:-4]) is None
+
+
+def make_module(data: bytes, actor_layouts: list[ActorLayoutSet] = None) -> RoomModule:
+    return RoomModule(0x8b, RoomLayout(), [], actor_layouts or [], TriggerSet(), [], 0x801ec628,
+                      ModuleHeader.expand(data), {}, 0)
+
+
+def test_write_omits_bss():
+    data = make_data(0x100)
+    f = io.BytesIO()
+    make_module(data).write(f)
+    assert f.getvalue() == data
+
+
+def test_write_bss_changed():
+    data = make_data(0x100)
+    layout = ActorLayout('A0101', b'\0' * 30, [ActorInstance() for _ in range(4)])
+    module = make_module(data, [ActorLayoutSet(len(data), [layout])])
+    with pytest.raises(ValueError):
+        module.write(io.BytesIO())
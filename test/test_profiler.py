@@ -0,0 +1,98 @@
+import struct
+
+from galsdk.profiler import AiBudgetTable, ProfileBuffer
+
+BASE = 0x80000000
+BUFFER_OFFSET = 0x100
+STRINGS_OFFSET = 0x40
+
+
+def make_ram(capacity: int, next_index: int, count: int, samples: list[tuple[int, int, int]]) -> bytes:
+    ram = bytearray(0x400)
+    ram[STRINGS_OFFSET:STRINGS_OFFSET + 10] = b'ai\0render\0'
+    struct.pack_into('<4s3H2xI', ram, BUFFER_OFFSET, b'GPRF', 1, capacity, next_index, count)
+    for i, sample in enumerate(samples):
+        struct.pack_into('<I2H', ram, BUFFER_OFFSET + 0x10 + i * 8, *sample)
+    return bytes(ram)
+
+
+AI = BASE + STRINGS_OFFSET
+RENDER = BASE + STRINGS_OFFSET + 3
+
+
+def test_find_buffer():
+    ram = make_ram(4, 2, 2, [(AI, 1, 100), (RENDER, 1, 200)])
+    buffers = list(ProfileBuffer.find_all(ram, BASE))
+    assert len(buffers) == 1
+    buffer = buffers[0]
+    assert buffer.address == BASE + BUFFER_OFFSET
+    assert buffer.dropped == 0
+    assert [(s.zone, s.frame, s.ticks) for s in buffer.samples] == [('ai', 1, 100), ('render', 1, 200)]
+
+
+def test_wrapped_buffer_order():
+    ram = make_ram(3, 1, 5, [(AI, 4, 40), (AI, 2, 20), (AI, 3, 30)])
+    buffer = next(ProfileBuffer.find_all(ram, BASE))
+    assert buffer.dropped == 2
+    assert [s.frame for s in buffer.samples] == [2, 3, 4]
+
+
+def test_unknown_zone():
+    ram = make_ram(2, 1, 1, [(0x80100000, 1, 5)])
+    buffer = next(ProfileBuffer.find_all(ram, BASE))
+    assert buffer.samples[0].zone == '<80100000>'
+
+
+def test_invalid_header_ignored():
+    ram = bytearray(make_ram(4, 0, 0, []))
+    struct.pack_into('<H', ram, BUFFER_OFFSET + 8, 10)
+    assert list(ProfileBuffer.find_all(bytes(ram), BASE)) == []
+
+
+def test_summarize():
+    ram = make_ram(8, 5, 5, [(AI, 1, 100), (RENDER, 1, 300), (AI, 2, 200), (AI, 2, 50), (RENDER, 3, 100)])
+    stats = {s.zone: s for s in next(ProfileBuffer.find_all(ram, BASE)).summarize()}
+    assert stats['ai'].count == 3
+    assert stats['ai'].num_frames == 2
+    assert stats['ai'].min_ticks == 50
+    assert stats['ai'].max_ticks == 200
+    assert stats['ai'].avg_ticks == 350 / 3
+    assert stats['render'].total_ticks == 400
+
+
+def make_ai_table(actors: list[tuple[int, int, list[tuple[int, int, int, int, int]]]], num_states: int = 2) -> bytes:
+    ram = bytearray(0x400)
+    struct.pack_into('<4sH2B3H2x', ram, BUFFER_OFFSET, b'GAIB', 1, 4, num_states, 9, 1200, 2000)
+    actor_size = 0x14 + num_states * 0x0C
+    for i, (routine, skipped, states) in enumerate(actors):
+        actor_offset = BUFFER_OFFSET + 0x10 + i * actor_size
+        struct.pack_into('<Ii6H', ram, actor_offset, routine, 1, 300, 250, 400, skipped, 8, 10)
+        for j, state in enumerate(states):
+            struct.pack_into('<5H2x', ram, actor_offset + 0x14 + j * 0x0C, *state)
+    return bytes(ram)
+
+
+def test_ai_budget_table():
+    ram = make_ai_table([(0, 0, []), (0x801F7F04, 3, [(5, 4, 300, 400, 9), (2, 6, 200, 250, 7)])])
+    tables = list(AiBudgetTable.find_all(ram, BASE))
+    assert len(tables) == 1
+    table = tables[0]
+    assert table.address == BASE + BUFFER_OFFSET
+    assert (table.frame, table.frame_ticks, table.budget_ticks) == (9, 1200, 2000)
+    # actors without a routine aren't being timed
+    assert [a.index for a in table.actors] == [1]
+    actor = table.actors[0]
+    assert (actor.routine, actor.avg_ticks, actor.max_ticks, actor.skipped_frames, actor.count) == \
+        (0x801F7F04, 250, 400, 3, 10)
+    assert [(s.state, s.count, s.avg_ticks) for s in actor.states] == [(2, 6, 200), (5, 4, 300)]
+
+
+def test_ai_budget_table_unused_states_ignored():
+    ram = make_ai_table([(0x801F7F04, 0, [(1, 2, 100, 120, 3)])])
+    actor = next(AiBudgetTable.find_all(ram, BASE)).actors[0]
+    assert [s.state for s in actor.states] == [1]
+
+
+def test_ai_budget_table_truncated():
+    ram = make_ai_table([], num_states=200)
+    assert list(AiBudgetTable.find_all(ram, BASE)) == []
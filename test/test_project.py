@@ -1,4 +1,5 @@
-from galsdk.project import Project, Region
+from galsdk.db import Database
+from galsdk.project import ArchiveExtractor, Project, Region
 from galsdk.game import GameVersion
 
 
@@ -9,3 +10,41 @@ def test_save_open(tmp_path):
     other_project = Project.open(str(tmp_path))
     assert project.version == other_project.version
     assert project.last_export_date == other_project.last_export_date
+
+
+def make_archives(game_data):
+    game_data.mkdir()
+    for name, count in [('MODULE.BIN', 3), ('MOT.CDB', 2)]:
+        db = Database()
+        for i in range(count):
+            db.append(bytes([i + 1]) * (0x100 * (i + 1)))
+        with (game_data / name).open('wb') as f:
+            db.write(f)
+    (game_data / 'OTHER.BIN').write_bytes(b'\0' * 0x10)
+
+
+def unpack_archives(game_data, project_path, max_workers):
+    progress = []
+    with ArchiveExtractor(project_path, max_workers, lambda *args: progress.append(args)) as extractor:
+        extractor.submit_all(game_data)
+        assert not extractor.submit(game_data / 'OTHER.BIN')
+        assert not extractor.submit(game_data / 'MODULE.BIN')
+        manifests = [extractor.wait(name) for name in ['MODULE.BIN', 'MOT.CDB', 'SOUND.CDB']]
+    return manifests, progress
+
+
+def test_archive_extractor_parallel_matches_serial(tmp_path):
+    game_data = tmp_path / 'T4'
+    make_archives(game_data)
+
+    serial, serial_progress = unpack_archives(game_data, tmp_path / 'serial', 1)
+    parallel, parallel_progress = unpack_archives(game_data, tmp_path / 'parallel', 2)
+
+    assert serial[2] is None and parallel[2] is None
+    assert serial_progress == parallel_progress == [('Unpacked MODULE.BIN', 1, 2), ('Unpacked MOT.CDB', 2, 2)]
+    for serial_manifest, parallel_manifest in zip(serial[:2], parallel[:2]):
+        assert serial_manifest.name == parallel_manifest.name
+        assert len(serial_manifest) == len(parallel_manifest)
+        for serial_file, parallel_file in zip(serial_manifest, parallel_manifest):
+            assert serial_file.name == parallel_file.name
+            assert serial_file.path.read_bytes() == parallel_file.path.read_bytes()
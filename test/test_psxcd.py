@@ -4,7 +4,7 @@ import os.path
 import pytest
 
 from psx.cd import PsxCd, Patch
-from psx.cd.disc import Disc
+from psx.cd.disc import Disc, Sector
 
 
 @pytest.fixture
@@ -97,3 +97,31 @@ def test_extract(sample_cd):
     with io.BytesIO() as f:
         sample_cd.extract(r'\TEST.TXT', f)
         assert f.getvalue() == b'hello world'
+
+
+def test_write_to_path_incremental(tmp_path, sample_cd):
+    path = tmp_path / 'output.bin'
+    assert sample_cd.write_to_path(path) == len(sample_cd.sectors)
+    assert not any(sector.is_dirty for sector in sample_cd.sectors)
+
+    data = b'this is the patch data'
+    sample_cd.patch([Patch(r'cdrom:\TEST.TXT', data)])
+    num_written = sample_cd.write_to_path(path, True)
+    assert 0 < num_written < len(sample_cd.sectors)
+
+    with io.BytesIO() as f:
+        sample_cd.write(f)
+        assert path.read_bytes() == f.getvalue()
+    with path.open('rb') as f:
+        disc = Disc(f)
+        disc.seek(30)
+        sector = disc.read_sector()
+    assert sector.data[:len(data)] == data
+    assert sector.validate_edc()
+
+
+def test_write_to_path_size_mismatch(tmp_path, sample_cd):
+    path = tmp_path / 'output.bin'
+    path.write_bytes(b'not a cd image')
+    assert sample_cd.write_to_path(path, True) == len(sample_cd.sectors)
+    assert path.stat().st_size == len(sample_cd.sectors) * Sector.SIZE
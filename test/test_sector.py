@@ -94,3 +94,28 @@ def test_edc():
     source.update_edc()
     assert source.edc == 0x9ea391be
     assert source.validate_edc()
+
+
+def test_invalidate_edc():
+    sector = Sector(minute=7, second=8, sector=9, mode=1)
+    sector.data[10:20] = b'abcdefghij'
+    sector.invalidate_edc()
+    assert sector.is_edc_stale
+    assert sector.edc == 0x9ea391be
+    assert not sector.is_edc_stale
+    assert sector.validate_edc()
+
+
+def test_update_edcs():
+    sectors = []
+    for i in range(20):
+        sector = Sector(minute=0, second=2, sector=i, mode=2, form=1 if i % 2 == 0 else 2)
+        sector.data[:4] = i.to_bytes(4, 'little')
+        sector.invalidate_edc()
+        sectors.append(sector)
+    # form 2 sectors without an EDC should be left alone
+    expected = [sector.calculate_edc() if sector.form == 1 else 0 for sector in sectors]
+
+    Sector.update_edcs(sectors, min_batch_size=1)
+    assert [sector.edc for sector in sectors] == expected
+    assert not any(sector.is_edc_stale for sector in sectors)
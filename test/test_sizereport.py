@@ -0,0 +1,86 @@
+import io
+
+from galsdk.sizereport import LinkerMap
+
+MAP = """
+Discarded input sections
+
+ .comment       0x00000000       0x28 room.o
+ .text.unused_helper
+                0x00000000        0xe room.o
+
+Memory Configuration
+
+Name             Origin             Length             Attributes
+ROOM             0x801ec628         0x0000b738         xrw
+*default*        0x00000000         0xffffffff
+
+Linker script and memory map
+
+                0x8013b5bc                SetActorAiRoutine = 0x8013b5bc
+
+MODULE_ID       0x801ec628        0x4
+ *(MODULE_ID)
+ MODULE_ID      0x801ec628        0x4 room.o
+                0x801ec628                module_id
+
+.text           0x801ec62c       0x3c
+ *(.text .text.*)
+ .text.static_helper
+                0x801ec62c        0xe room.o
+ .text.used_helper
+                0x801ec63a       0x21 room.o
+                0x801ec63a                used_helper
+ .text.room     0x801ec65b       0x0d room.o
+                0x801ec65b                room
+
+.data           0x801ec668       0x10
+ *(.data .data.* .sdata .sdata.*)
+ .data.table    0x801ec668       0x10 room.o
+                0x801ec668                table
+
+.bss            0x801ec678       0x84
+                0x801ec678                        ModuleBssStart = .
+ *(.sbss .sbss.* .scommon .bss .bss.* COMMON)
+ .bss.counter   0x801ec678       0x84 room.o
+                0x801ec6fc                        ModuleBssEnd = .
+                0x801ec6fc                        ModuleEnd = .
+
+/DISCARD/
+ *(.comment .note .note.*)
+LOAD room.o
+OUTPUT(ROOM.RMD.elf elf32-tradlittlemips)
+"""
+
+
+def test_parse_map():
+    linker_map = LinkerMap.read(io.StringIO(MAP))
+    assert linker_map.region_origin == 0x801ec628
+    assert linker_map.region_length == 46904
+    assert [s.name for s in linker_map.region_sections] == ['MODULE_ID', '.text', '.data', '.bss']
+    assert linker_map.file_size == 0x50
+    assert linker_map.memory_size == 0xd4
+    assert len(linker_map.discarded) == 2
+    assert linker_map.discarded_size == 0x36
+
+
+def test_symbol_sizes():
+    symbols = {s.name: s for s in LinkerMap.read(io.StringIO(MAP)).symbols()}
+    assert symbols['counter'].size == 0x84
+    assert symbols['counter'].section == '.bss'
+    assert symbols['used_helper'].size == 0x21
+    assert symbols['static_helper'].size == 0xe
+    assert symbols['room'].size == 0xd
+    assert symbols['module_id'].size == 4
+    assert 'SetActorAiRoutine' not in symbols
+    assert 'ModuleEnd' not in symbols
+
+
+def test_stage_library_reserved():
+    region_end = '                0x801ec6fc                        ModuleEnd = .\n'
+    text = MAP.replace(region_end, region_end + '                0x801f5d60                        '
+                       'ModuleRegionEnd = StageLibraryStart\n')
+    linker_map = LinkerMap.read(io.StringIO(text))
+    assert linker_map.assignments['ModuleRegionEnd'] == 0x801f5d60
+    assert linker_map.available_size == 46904 - 8192
+    assert LinkerMap.read(io.StringIO(MAP)).available_size == 46904
@@ -0,0 +1,89 @@
+import io
+import struct
+
+import pytest
+
+from galsdk.sizereport import LinkerMap
+from galsdk.stagelib import HEADER_SIZE, StageLibrary, checksum
+
+MAP = """
+Memory Configuration
+
+Name             Origin             Length             Attributes
+STAGE            0x801f5d60         0x00002000         xrw
+*default*        0x00000000         0xffffffff
+
+Linker script and memory map
+
+                0x8013b5bc                SetActorAiRoutine = 0x8013b5bc
+
+STAGE_HEADER    0x801f5d60       0x14
+                0x801f5d60                StageLibraryStart = .
+                0x801f5d60        0x4 LONG 0x47545347
+
+.text           0x801f5d74       0x1c
+                0x801f5d74                StageExportsStart = .
+ *(STAGE_EXPORTS)
+ STAGE_EXPORTS  0x801f5d74       0x10 lib.o
+                0x801f5d74                StageExport_GiveFileItem
+                0x801f5d7c                StageExport_WaitForMessages
+                0x801f5d84                StageExportsEnd = .
+ *(.text .text.* .rodata .rodata.*)
+ .text          0x801f5d84        0x8 lib.o
+                0x801f5d84                GiveFileItem
+                0x801f5d88                WaitForMessages
+                0x801f5d8c                StageLibraryCodeEnd = .
+                0x801f5d90                StageLibraryEnd = .
+LOAD lib.o
+OUTPUT(STAGEA.LIB binary)
+"""
+
+CODE = struct.pack('<7I', 0x08077d61, 0, 0x08077d62, 0, 0x03e00008, 0x03e00008, 0)
+
+
+def make_library(num_exports: int = 2, code: bytes = CODE) -> bytes:
+    return struct.pack('<4s2H3I', b'GSTG', 1, num_exports, len(code) - 4, 0, HEADER_SIZE + len(code)) + code
+
+
+def test_checksum():
+    assert checksum(b'') == 0
+    assert checksum(struct.pack('<2I', 1, 2)) == 4
+    # the high bit rotates around rather than being lost
+    assert checksum(struct.pack('<2I', 0x80000000, 0)) == 1
+
+
+def test_parse():
+    library = StageLibrary.parse(make_library(), LinkerMap.read(io.StringIO(MAP)))
+    assert library.start == 0x801f5d60
+    assert library.exports == {'GiveFileItem': 0x801f5d74, 'WaitForMessages': 0x801f5d7c}
+    assert library.checksum == checksum(CODE[:-4])
+
+
+def test_with_checksum():
+    library = StageLibrary.parse(make_library(), LinkerMap.read(io.StringIO(MAP)))
+    data = library.with_checksum()
+    assert len(data) == len(library.data)
+    assert struct.unpack_from('<I', data, 0x0C)[0] == library.checksum
+    assert data[HEADER_SIZE:] == library.data[HEADER_SIZE:]
+
+
+def test_symbol_file():
+    library = StageLibrary.parse(make_library(), LinkerMap.read(io.StringIO(MAP)))
+    lines = library.symbol_file(150, 'STAGEA.LIB').splitlines()
+    assert lines[1:] == [
+        'StageLibraryStart = 0x801F5D60;',
+        'StageLibraryIndex = 150;',
+        f'StageLibraryChecksum = 0x{library.checksum:08X};',
+        'GiveFileItem = 0x801F5D74;',
+        'WaitForMessages = 0x801F5D7C;',
+    ]
+
+
+def test_invalid():
+    linker_map = LinkerMap.read(io.StringIO(MAP))
+    with pytest.raises(ValueError):
+        StageLibrary.parse(b'GMOD' + make_library()[4:], linker_map)
+    with pytest.raises(ValueError):
+        StageLibrary.parse(make_library()[:-4], linker_map)
+    with pytest.raises(ValueError):
+        StageLibrary.parse(make_library(num_exports=3), linker_map)
@@ -0,0 +1,74 @@
+import random
+
+from galsdk.xa import XaDatabase, XaRegion
+from psx.cd.disc import Sector, SubMode
+
+
+def make_sector(channel: int, audio: bool, rng: random.Random) -> bytes:
+    sector = Sector(mode=2, form=2 if audio else 1)
+    with sector:
+        sector.channel = channel
+        sector.sub_mode = (SubMode.AUDIO | SubMode.FORM2 | SubMode.REAL_TIME) if audio else SubMode.DATA
+        sector.data[:] = rng.randbytes(sector.data_size)
+    return sector.raw
+
+
+def make_data(num_sectors: int, seed: int = 0) -> bytes:
+    rng = random.Random(seed)
+    return b''.join(make_sector(i % XaDatabase.NUM_CHANNELS, rng.random() < 0.9, rng) for i in range(num_sectors))
+
+
+def clean_regions_by_sector(regions: list[XaRegion], data: bytes):
+    # the straightforward implementation that XaDatabase.clean_regions must match
+    for region in regions:
+        sector_data = bytearray()
+        for i in range(region.start, region.end + 1):
+            start = i * Sector.SIZE
+            if start >= len(data):
+                region.end = i - 1
+                break
+            sector = Sector(data[start:start + Sector.SIZE])
+            if sector.channel != region.channel:
+                sector.sub_mode = SubMode.DATA
+                sector.data[:] = bytes(sector.data_size)
+            sector_data.extend(sector.raw)
+        region.data = sector_data
+
+
+def make_regions() -> list[XaRegion]:
+    return [XaRegion(0, 0, 15), XaRegion(3, 3, 40), XaRegion(7, 16, 63), XaRegion(1, 60, 100), XaRegion(0, 0, -1)]
+
+
+def test_clean_regions_matches_sector_edits():
+    data = make_data(64)
+    expected = make_regions()
+    clean_regions_by_sector(expected, data)
+    actual = make_regions()
+    XaDatabase.clean_regions(actual, data)
+    assert actual == expected
+
+
+def test_own_sectors():
+    data = make_data(64, 1)
+    db = XaDatabase(make_regions(), data)
+    region = db.regions[1]
+    expected = [sector.raw for i in range(region.start, region.end + 1)
+                if (sector := Sector(data[i * Sector.SIZE:(i + 1) * Sector.SIZE])).channel == region.channel
+                and sector.sub_mode & SubMode.AUDIO]
+    assert [sector.raw for sector in region.own_sectors] == expected
+    index, sector = region.first_audio_sector
+    assert sector.raw == region.data[index * Sector.SIZE:(index + 1) * Sector.SIZE] == expected[0]
+    assert db.get_channel_offset(5, 10) == 13 * Sector.SIZE
+
+
+def test_extend():
+    first = XaDatabase(make_regions(), make_data(64, 2))
+    second = XaDatabase(make_regions(), make_data(64, 3))
+    combined = XaDatabase()
+    combined.extend(first)
+    combined.extend(second)
+
+    assert combined.data == first.data + second.data
+    assert [region.data for region in combined.regions[:4]] == [region.data for region in first.regions[:4]]
+    assert [region.data for region in combined.regions[5:9]] == [region.data for region in second.regions[:4]]
+    assert combined.regions[6].start == second.regions[1].start + 64